@@ -51,16 +51,47 @@
 typedef int token_compare_function(TOKEN*, TOKEN*);
 
 
+/*
+ * Convert a token into a long double. Plain integers are converted directly
+ * (without strtold) and tokens that cannot hold a number are rejected right away.
+ */
+int tokenToReal(TOKEN *token, long double *x) {
+	long long i;
+	if (tokenToInteger(token, &i) == TOK_OK) {
+		*x = (long double)i;
+		return TOK_OK;
+	}
+
+	if (!tokenMayBeReal(token))
+		return TOK_INVALID_FORMAT;
+
+	return tokenToLongDouble(token, x);
+}
+
+
+
 /*
  * Compare two tokens.
  * Tokens are converted into long doubles and then compared with given margin of error.
  */
 int compareRealTokens(TOKEN *token1, TOKEN *token2) {
-	
+
+	// Identical tokens always match (save for NaNs, which never equal anything).
+	if (tokensEqual(token1, token2)) {
+		const char *str = token1->str;
+		if (token1->len > 1 && (*str == '-' || *str == '+')) ++str;
+		if (*str != 'n' && *str != 'N') return TRUE;
+	}
+
+	// Equal integers (e.g. "007" and "7") match without any floating point conversion.
+	long long i1, i2;
+	if (tokenToInteger(token1, &i1) == TOK_OK && tokenToInteger(token2, &i2) == TOK_OK && i1 == i2)
+		return TRUE;
+
 	// Convert tokens to doubles.
 	long double x1, x2;
-	int res1 = tokenToLongDouble(token1, &x1);
-	int res2 = tokenToLongDouble(token2, &x2);
+	int res1 = tokenToReal(token1, &x1);
+	int res2 = tokenToReal(token2, &x2);
 	
 	// One token is double the other one is not -> they can't match.
 	if (res1 != res2) return FALSE;
@@ -85,10 +116,8 @@ int compareRealTokens(TOKEN *token1, TOKEN *token2) {
  */
 int compare(TOKEN_FILE *f1, TOKEN_FILE *f2, token_compare_function *comp, int ignoreNewline) {
 	
-	// Initialize token structures.
+	// Token structures (they are only views into the token files).
 	TOKEN token1, token2;
-	initializeToken(&token1, 31);
-	initializeToken(&token2, 31);
 	
 	// Read tokens in cycle.
 	int res1 = fgetToken(f1, &token1);
@@ -106,10 +135,6 @@ int compare(TOKEN_FILE *f1, TOKEN_FILE *f2, token_compare_function *comp, int ig
 		res2 = fgetToken(f2, &token2);
 	}
 	
-	// Clean up token structures.
-	freeToken(&token1);
-	freeToken(&token2);
-	
 	return ((res1 == TOK_EOF) && (res2 == TOK_EOF)) ? RES_OK : RES_WRONG;
 }
 
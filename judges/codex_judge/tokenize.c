@@ -1,9 +1,10 @@
 /*
- * Tokenize library (v 1.0.0).
+ * Tokenize library (v 2.0.0).
  * (C) Martin Krulis <krulis@ksvi.mff.cuni.cz>, 2007
  *
  * This library is designed to streamline reading of text files without whitespace.
- * It also defines TOKEN_FILE files which implements simple buffering over stdio files.
+ * It also defines TOKEN_FILE files which map the whole file into memory, so the tokens
+ * are only views into the mapped data and they are never copied.
  * For more information see attached documentation.
  *
  */
@@ -11,6 +12,13 @@
 #include "tokenize.h"
 #include <string.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 
 /*
  * Inline functions for this file.
@@ -23,6 +31,13 @@ inline int is_whitespace(char ch) {
 	return (ch == ' ') || (ch == '\t') || (ch == '\r') || (ch == '\n');
 }
 
+/*
+ * Returns true if ch is a decimal digit.
+ */
+inline int is_digit(char ch) {
+	return (ch >= '0') && (ch <= '9');
+}
+
 
 
 
@@ -31,63 +46,81 @@ inline int is_whitespace(char ch) {
  * Internal control structure for token file.
  */
 struct s_token_file {
-	FILE *fp;		// Associated file (it is accessed via std. IO functions).
-	char *buf;		// Reading buffer.
-	int len, pos;	// Length of data in buffer and actual readin position.
+	const char *data;	// Contents of the whole file.
+	size_t len, pos;	// Length of the data and actual reading position.
+	int mapped;			// Nonzero if data are mapped (otherwise they are allocated by malloc).
 };
 
 
 
 /*
- * Inline local functions for token file.
+ * Local functions for token file.
  */
- 
+
 /*
- * Returns another character from the stream, but the char is not removed from the stream.
- * Returns EOF if the file has finished or error occured.
+ * Load the whole stream into a malloc-ed buffer (used when the file cannot be mapped).
+ * Returns zero on error.
  */
-inline int tfpeek(TOKEN_FILE *tf) {
-
-	// If there are no more valid chars in the buffer.
-	if (tf->len == tf->pos) {
-		if (feof(tf->fp)) return EOF;
-		tf->pos = 0;
-		tf->len = fread(tf->buf, 1, TOKEN_FILE_BUF_SIZE, tf->fp);
-		if (!tf->len) return EOF;
-	}
-	
-	// Return char at the actual position in the buffer;
-	return tf->buf[tf->pos];
-}
+static int tfload(TOKEN_FILE *tf, FILE *fp) {
+	size_t capacity = 0;
+	char *buf = NULL;
+	tf->len = 0;
+
+	do {
+		// Make sure there is enough space for another chunk.
+		if (tf->len + TOKEN_FILE_BUF_SIZE > capacity) {
+			capacity = (capacity) ? capacity * 2 : TOKEN_FILE_BUF_SIZE;
+			char *newBuf = (char*)realloc(buf, capacity);
+			if (!newBuf) {
+				free(buf);
+				return 0;
+			}
+			buf = newBuf;
+		}
 
+		tf->len += fread(buf + tf->len, 1, TOKEN_FILE_BUF_SIZE, fp);
+	} while (!feof(fp) && !ferror(fp));
 
+	tf->data = buf;
+	if (ferror(fp)) {
+		free(buf);
+		return 0;
+	}
 
-/*
- * Returns another character from the stream.
- * Returns EOF if the file has finished or error occured.
- */
-inline int tfgetc(TOKEN_FILE *tf) {
-	int res = tfpeek(tf);
-	tf->pos++;
-	return res;
+	return 1;
 }
 
 
 
 /*
- * Returns nonzero value if all data have been read.
+ * Try to map given file into memory. Returns zero if the file cannot be mapped
+ * (it is not a regular file, it is empty, or mapping is not supported on this platform).
  */
-inline int tfeof(TOKEN_FILE *tf) {
-	return (tf->len == tf->pos) && feof(tf->fp);
-}
+static int tfmap(TOKEN_FILE *tf, const char *fileName) {
+#ifndef _WIN32
+	int fd = open(fileName, O_RDONLY);
+	if (fd < 0) return 0;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+		close(fd);
+		return 0;
+	}
 
+	void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) return 0;
 
+	// Tokens are read strictly from the beginning to the end.
+	posix_madvise(data, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
 
-/*
- * Returns the same value as ferror on a regular file.
- */
-inline int tferror(TOKEN_FILE *tf) {
-	return ferror(tf->fp);
+	tf->data = (const char*)data;
+	tf->len = (size_t)st.st_size;
+	tf->mapped = 1;
+	return 1;
+#else
+	return 0;
+#endif
 }
 
 
@@ -97,38 +130,39 @@ inline int tferror(TOKEN_FILE *tf) {
 /*
  * Public functions for token file.
  */
- 
+
 /*
  * Open a token file and return's token file control structure.
  * If no file name is given (null is passed), token file will use stdin instead.
- * File is always opened as a binary file for reading.
+ * Regular files are mapped into memory, other files are read as a whole into a buffer.
  * Return's null if file can not be opened.
  */
 TOKEN_FILE *tfopen(const char *fileName) {
-	
+
 	// Allocate token file control structure.
 	TOKEN_FILE *tf = (TOKEN_FILE*)malloc( sizeof(TOKEN_FILE) );
 	if (!tf) return NULL;
-	
-	// Open file.
-	tf->fp = (fileName) ? fopen(fileName, "rb") : stdin;
-	if (!tf->fp) goto error;
-	
-	// Allocate file buffer.
-	tf->buf = (char*)malloc(TOKEN_FILE_BUF_SIZE);
-	if (!tf->buf) goto error2;
-	
-	// Fill in other variables.
+
+	tf->data = NULL;
 	tf->len = tf->pos = 0;
-	
+	tf->mapped = 0;
+
+	// Map the file, or fall back to reading it the old way.
+	if (!fileName || !tfmap(tf, fileName)) {
+		FILE *fp = (fileName) ? fopen(fileName, "rb") : stdin;
+		if (!fp) goto error;
+
+		int res = tfload(tf, fp);
+		if (fileName) fclose(fp);
+		if (!res) goto error;
+	}
+
 	// Skip leading whitespace.
-	while(!tfeof(tf) && is_whitespace(tfpeek(tf)))
-		tfgetc(tf);
-	
+	while (tf->pos < tf->len && is_whitespace(tf->data[tf->pos]))
+		tf->pos++;
+
 	return tf;
 
-error2:
-	fclose(tf->fp);
 error:
 	free(tf);
 	return NULL;
@@ -140,8 +174,12 @@ error:
  * Release all resources associated with given token file.
  */
 void tfclose(TOKEN_FILE *tf) {
-	fclose(tf->fp);
-	free(tf->buf);
+#ifndef _WIN32
+	if (tf->mapped)
+		munmap((void*)tf->data, tf->len);
+	else
+#endif
+		free((void*)tf->data);
 	free(tf);
 }
 
@@ -154,66 +192,7 @@ void tfclose(TOKEN_FILE *tf) {
  */
 
 /*
- * Initialize the token structure with given capacity.
- * Recomended initial capacity is 15 (or some 2^k - 1 number).
- */
-int initializeToken(TOKEN *token, int capacity) {
-	
-	// Check params.
-	if (!token || (capacity < 0))
-		return TOK_INVALID_PARAMS;
-
-	if (capacity > MAX_TOKEN_CAPACITY)
-		return TOK_OUT_OF_MEMORY;
-	
-	// Allocate string.
-	token->capacity = capacity;
-	token->str = (char*)malloc(capacity+1);
-	if (!token->str)
-		return TOK_OUT_OF_MEMORY;
-	
-	// Set token to an empty string.
-	token->len = 0;
-	token->str[0] = '\0';
-	
-	// Set up other members.
-	token->newline = 0;
-	
-	return TOK_OK;
-}
-
-
-
-/*
- * Private method that reallocates the token for bigger capacity.
- */
-int reallocToken(TOKEN *token) {
-
-	// Too small capacity -> make it at least 15.
-	if (token->capacity < 15)
-		token->capacity = 15;
-	
-	// Normal capacity -> double the size.
-	else
-		token->capacity += token->capacity + 1;
-	
-	if (token->capacity > MAX_TOKEN_CAPACITY)
-		return TOK_OUT_OF_MEMORY;
-	
-	// Reallocate the token string.
-	token->str = (char*)realloc(token->str, token->capacity + 1);
-	if (!token->str) {
-		token->len = token->capacity = 0;
-		return TOK_OUT_OF_MEMORY;
-	}
-	
-	return TOK_OK;
-}
-
-
-
-/*
- * Reads a token from opened token file. The token must be initialized.
+ * Reads a token from opened token file.
  * If token was found function returns TOK_OK and valid data are in the token structure.
  * Otherwise an error occured and there may be anything in the token structure.
  */
@@ -222,41 +201,34 @@ int fgetToken(TOKEN_FILE *tf, TOKEN *token) {
 	// Check params.
 	if (!tf || !token)
 		return TOK_INVALID_PARAMS;
-	
-	// Set token to empty string.
-	token->len = 0;
-	token->str[0] = '\0';
+
+	const char *data = tf->data;
+	size_t pos = tf->pos, len = tf->len;
 
 	// Skip leading whitespace.
-	int c = tfpeek(tf);
 	token->newline = 0;
-	while ((c != EOF) && is_whitespace(c)) {
-		if (c == '\n') token->newline = 1;
-		tfgetc(tf);
-		c = tfpeek(tf);
+	while (pos < len && is_whitespace(data[pos])) {
+		if (data[pos] == '\n') token->newline = 1;
+		++pos;
 	}
-		
-	// If there are no more data or error occured, announce it.
-	if (c == EOF) return (tferror(tf) == 0) ? TOK_EOF : TOK_READING_ERROR;
-	
-	// Read the token.
-	while ((c != EOF) && !is_whitespace(c)) {
-		
-		// Ensure that token string capacity is sufficient.
-		if (token->len == token->capacity) {
-			if (reallocToken(token) != TOK_OK)
-				return TOK_OUT_OF_MEMORY;
-		}
-		
-		// Add char to the token and read another one.
-		token->str[ token->len++ ] = tfgetc(tf);
-		c = tfpeek(tf);
+
+	// If there are no more data, announce it.
+	if (pos == len) {
+		tf->pos = pos;
+		token->str = NULL;
+		token->len = 0;
+		return TOK_EOF;
 	}
-	
-	// Add trailing null char into token string.
-	token->str[token->len] = '\0';
-	
-	return (tferror(tf) == 0) ? TOK_OK : TOK_READING_ERROR;
+
+	// Find the end of the token.
+	size_t start = pos;
+	while (pos < len && !is_whitespace(data[pos]))
+		++pos;
+
+	token->str = data + start;
+	token->len = pos - start;
+	tf->pos = pos;
+	return TOK_OK;
 }
 
 
@@ -269,20 +241,11 @@ int tokensEqual(TOKEN *token1, TOKEN *token2) {
 	// Check params.
 	if (!token1 || !token2)
 		return TOK_INVALID_PARAMS;
-		
+
 	if (token1->len != token2->len)
 		return 0;
-	
-	return !strcmp(token1->str, token2->str);
-}
-
 
-
-/*
- * Release token string inside token structure.
- */
-void freeToken(TOKEN *token) {
-	if (token) free(token->str);
+	return !memcmp(token1->str, token2->str, token1->len);
 }
 
 
@@ -291,19 +254,42 @@ void freeToken(TOKEN *token) {
 
 /*
  * Conversion functions. Each function tries to convert token into specific data type.
- * If the conversion succeeds TOK_OK is returned, otherwise TOK_INVALID_PARAMS is returned.
+ * If the conversion succeeds TOK_OK is returned, otherwise an error code is returned.
  */
 
+/*
+ * Size of the local buffer used for null-terminated copies of converted tokens.
+ */
+#define	TOKEN_CONVERSION_BUF_SIZE	128
+
+/*
+ * Make a null-terminated copy of the token (the stdlib conversions require that).
+ * The local buffer is used if it is large enough, otherwise the copy is malloc-ed.
+ */
+static char *tokenToString(TOKEN *token, char *local) {
+	char *str = (token->len < TOKEN_CONVERSION_BUF_SIZE) ? local : (char*)malloc(token->len + 1);
+	if (!str) return NULL;
+	memcpy(str, token->str, token->len);
+	str[token->len] = '\0';
+	return str;
+}
+
+
 #define	testInputParams	\
 	if (!token || !x)\
 		return TOK_INVALID_PARAMS;
 
-	
+
 #define tokenToXPrototype(FUNC, ...)	\
 	testInputParams\
+	char local[TOKEN_CONVERSION_BUF_SIZE];\
+	char *str = tokenToString(token, local);\
+	if (!str) return TOK_OUT_OF_MEMORY;\
 	char *end;\
-	*x = FUNC(token->str, &end, ##__VA_ARGS__);\
-	return (end == token->str + token->len) ? TOK_OK : TOK_INVALID_FORMAT;\
+	*x = FUNC(str, &end, ##__VA_ARGS__);\
+	int res = (token->len && end == str + token->len) ? TOK_OK : TOK_INVALID_FORMAT;\
+	if (str != local) free(str);\
+	return res;\
 
 
 
@@ -324,7 +310,62 @@ int tokenToLong(TOKEN *token, long *x) {
 
 int tokenToULong(TOKEN *token, unsigned long *x) {
 	testInputParams
-	if (token->str[0] == '-')	// Unsigned number must be really "unsigned".
-		return 0;
+	if (token->len && token->str[0] == '-')	// Unsigned number must be really "unsigned".
+		return TOK_INVALID_FORMAT;
 	tokenToXPrototype(strtoul, 10)
 }
+
+
+
+/*
+ * Maximal number of digits of a decimal integer which always fits in a long long.
+ */
+#define	MAX_INTEGER_DIGITS	18
+
+/*
+ * Fast conversion of plain decimal integers (optional sign followed by at most MAX_INTEGER_DIGITS digits).
+ * It does not touch the stdlib at all. Other tokens (including longer integers) yield TOK_INVALID_FORMAT.
+ */
+int tokenToInteger(TOKEN *token, long long *x) {
+	testInputParams
+
+	const char *str = token->str;
+	const char *end = str + token->len;
+	int negative = 0;
+	if (str < end && (*str == '-' || *str == '+')) {
+		negative = (*str == '-');
+		++str;
+	}
+
+	if (str == end || end - str > MAX_INTEGER_DIGITS)
+		return TOK_INVALID_FORMAT;
+
+	long long value = 0;
+	while (str < end) {
+		if (!is_digit(*str))
+			return TOK_INVALID_FORMAT;
+		value = value * 10 + (*str++ - '0');
+	}
+
+	*x = (negative) ? -value : value;
+	return TOK_OK;
+}
+
+
+
+/*
+ * Cheap test whether the token could possibly be converted by tokenToDouble or tokenToLongDouble.
+ * It returns zero for tokens which certainly do not hold a number (so the conversion may be skipped).
+ * Only the first char (after an optional sign) is examined, that is a digit, a decimal point,
+ * or a first letter of "inf", "infinity" and "nan".
+ */
+int tokenMayBeReal(TOKEN *token) {
+	if (!token || !token->len)
+		return 0;
+
+	const char *str = token->str;
+	if ((*str == '-' || *str == '+') && token->len > 1)
+		++str;
+
+	return is_digit(*str) || (*str == '.') || (*str == 'i') || (*str == 'I') || (*str == 'n') || (*str == 'N');
+}
@@ -1,5 +1,5 @@
 /*
- * Tokenize library (v 1.0.0).
+ * Tokenize library (v 2.0.0).
  * (C) Martin Krulis <krulis@ksvi.mff.cuni.cz>, 2007
  */
 
@@ -20,11 +20,6 @@ extern "C" {
 #include <stdlib.h>
 
 
-/*
- * Maximal token capacity is defined 32 MBytes.
- */
-#define	MAX_TOKEN_CAPACITY	(32 << 20)
-
 /*
  * Ok results.
  */
@@ -43,7 +38,8 @@ extern "C" {
 
 
 /*
- * The token file - buffered standard file.
+ * The token file - whole file mapped (or loaded) into memory.
+ * Size of the chunks used when the file cannot be mapped (stdin, pipes, ...).
  */
 #define	TOKEN_FILE_BUF_SIZE		65536
 
@@ -60,29 +56,31 @@ void tfclose(TOKEN_FILE *tf);
 
 /*
  * Token structure.
- * It keeps other information about token string to simplify realocation.
+ * Token is only a view into the data of its token file (the string is not null-terminated),
+ * therefore it is valid only until the token file is closed.
  */
 struct s_token {
-	char *str;
-	int len, capacity, newline;
+	const char *str;
+	size_t len;
+	int newline;
 };
 #define	TOKEN	struct s_token
 
 
-int initializeToken(TOKEN *token, int capacity);
 int fgetToken(TOKEN_FILE *tf, TOKEN *token);
 int tokensEqual(TOKEN *token1, TOKEN *token2);
-void freeToken(TOKEN *token);
 
 int tokenToDouble(TOKEN *token, double *x);
 int tokenToLongDouble(TOKEN *token, long double *x);
 int tokenToLong(TOKEN *token, long *x);
 int tokenToULong(TOKEN *token, unsigned long *x);
+int tokenToInteger(TOKEN *token, long long *x);
+int tokenMayBeReal(TOKEN *token);
 
 
 
 #ifdef __cplusplus
 }
 #endif
- 
+
 #endif // TOKENIZE_H_INCLUDED
@@ -1,8 +1,16 @@
 /*
- * Simple buffered IO library.
+ * Simple block IO library.
  * (C) 2007 Martin Krulis <krulis@ksvi.mff.cuni.cz>
  */
 #include "io.h"
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 
 // Length of the IO buffer.
@@ -15,7 +23,9 @@
 struct s_stream {
 	FILE *fp;
 	char *buf;
-	int len, pos;
+	size_t len, pos;
+	int mapped;		// Whole input is mapped into memory (buf must be unmapped).
+	int write;		// Output stream (buf holds pending data).
 };
 
 
@@ -26,13 +36,11 @@ STREAM createStream(FILE *fp) {
 	STREAM res = (STREAM)malloc( sizeof(struct s_stream) );
 	if (!res)
 		error("Out of memory.");
-	
-	res->buf = (char*)malloc(BUF_LEN);
-	if (!res->buf)
-		error("Out of memory.");		
 
 	res->fp = fp;
+	res->buf = NULL;
 	res->len = res->pos = 0;
+	res->mapped = res->write = 0;
 	return res;
 }
 
@@ -44,25 +52,73 @@ STREAM sopen(const char *fileName, const char *mode) {
 	FILE *fp = fopen(fileName, mode);
 	if (!fp)
 		error("File \"%s\" can not be opened.", fileName);
-	
+
 	STREAM res = createStream(fp);
 	if (!res)
 		fclose(fp);
-	
+
 	return res;
 }
 
 
+/*
+ * Private function that tries to map whole input file into memory.
+ * Returns zero if the file cannot be mapped (it is not a regular file or it is empty).
+ */
+int smap(STREAM s) {
+#ifndef _WIN32
+	struct stat st;
+	int fd = fileno(s->fp);
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+		return 0;
+
+	void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED)
+		return 0;
+
+	// The input is scanned strictly from the beginning to the end.
+	posix_madvise(data, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+
+	s->buf = (char*)data;
+	s->len = (size_t)st.st_size;
+	s->mapped = 1;
+	return 1;
+#else
+	return 0;
+#endif
+}
 
 
 /*
- * Opean given file as stream for reading.
+ * Private function that reads whole input into one buffer (when it cannot be mapped).
+ */
+void sload(STREAM s) {
+	size_t capacity = 0;
+	do {
+		if (capacity - s->len < BUF_LEN) {
+			capacity = (capacity) ? capacity * 2 : BUF_LEN;
+			s->buf = (char*)realloc(s->buf, capacity);
+			if (!s->buf)
+				error("Out of memory.");
+		}
+		s->len += fread(s->buf + s->len, 1, capacity - s->len, s->fp);
+	} while (!feof(s->fp) && !ferror(s->fp));
+
+	if (ferror(s->fp))
+		error("Error reading from file.");
+}
+
+
+
+
+/*
+ * Opean given file as stream for reading. Whole file is mapped (or loaded) immediately.
  */
 STREAM sopenRead(const char *fileName) {
-	if (fileName)
-		return sopen(fileName, "rb");
-	else
-		return createStream(stdin);
+	STREAM res = (fileName) ? sopen(fileName, "rb") : createStream(stdin);
+	if (!smap(res))
+		sload(res);
+	return res;
 }
 
 
@@ -75,59 +131,80 @@ STREAM sopenWrite(const char *fileName) {
 		res = sopen(fileName, "wb");
 	} else
 		res = createStream(stdout);
-	res->len = -1;
+
+	// Data are buffered here, so stdio buffering would only add another copy.
+	setvbuf(res->fp, NULL, _IONBF, 0);
+
+	res->buf = (char*)malloc(BUF_LEN);
+	if (!res->buf)
+		error("Out of memory.");
+	res->write = 1;
 	return res;
 }
 
 
+/*
+ * Private function that writes all pending data of an output stream.
+ */
+void sflush(STREAM s) {
+	if (s->pos) {
+		fwrite(s->buf, 1, s->pos, s->fp);
+		if (ferror(s->fp))
+			error("Error writing into file.");
+		s->pos = 0;
+	}
+}
+
+
 /*
  * Closes given stream.
  */
 void sclose(STREAM s) {
-	if (s->len < 0) {
-		fwrite(s->buf, 1, s->pos, s->fp);
+	if (s->write) {
+		sflush(s);
 	}
-	free(s->buf);
+#ifndef _WIN32
+	if (s->mapped)
+		munmap(s->buf, s->len);
+	else
+#endif
+		free(s->buf);
 	fclose(s->fp);
 	free(s);
 }
 
 
 /*
- * Fetch one character from a stream. Negative value is returned on eof or error.
+ * Get whole contents of an input stream. Length of the data is stored in len.
  */
-int sgetc(STREAM s) {
-	if (s->pos > s->len)
+const char *sdata(STREAM s, size_t *len) {
+	if (s->write)
 		error("Can not read from write-only stream.");
 
-	// Refill buffer if necessary.
-	if (s->pos == s->len) {
-		s->pos = 0;
-		s->len = fread(s->buf, 1, BUF_LEN, s->fp);
-		if (ferror(s->fp))
-			error("Error reading from file.");
-		if (s->len == 0) return -1;
-	}
-	
-	return s->buf[ s->pos++ ];
+	*len = s->len;
+	return s->buf;
 }
 
 
-
 /*
- * Write one character into a stream.
+ * Write a block of data into a stream. Small blocks are gathered in the buffer,
+ * large blocks are written directly.
  */
-void sputc(STREAM s, int ch) {
-	if (s->len != -1)
+void swrite(STREAM s, const char *data, size_t len) {
+	if (!s->write)
 		error("Can not write into read-only stream.");
 
-	if (s->pos == BUF_LEN) {
-		fwrite(s->buf, 1, s->pos, s->fp);
+	if (s->pos + len > BUF_LEN)
+		sflush(s);
+
+	if (len >= BUF_LEN) {
+		fwrite(data, 1, len, s->fp);
 		if (ferror(s->fp))
 			error("Error writing into file.");
-		s->pos = 0;
+	} else {
+		memcpy(s->buf + s->pos, data, len);
+		s->pos += len;
 	}
-	s->buf[ s->pos++ ] = ch;
 }
 
 
@@ -1,5 +1,5 @@
 /*
- * Simple buffered IO library.
+ * Simple block IO library.
  * (C) 2007 Martin Krulis <krulis@ksvi.mff.cuni.cz>
  */
 #ifndef IO_H_INCLUDED
@@ -25,7 +25,8 @@
 
 
 /*
- * Stream abstraction. It is used so buffering can be implemented over libc or unix IO.
+ * Stream abstraction. Input streams are mapped into memory as a whole (or read into one buffer
+ * if mapping is not possible), output streams are written in large blocks.
  */
 
 struct s_stream;
@@ -42,8 +43,8 @@ STREAM sopenRead(const char *fileName);
 STREAM sopenWrite(const char *fileName);
 void sclose(STREAM s);
 
-int sgetc(STREAM s);
-void sputc(STREAM s, int ch);
+const char *sdata(STREAM s, size_t *len);
+void swrite(STREAM s, const char *data, size_t len);
 int serror(STREAM s);
 
 
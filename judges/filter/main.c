@@ -13,6 +13,7 @@
  *
  */
 
+#include <string.h>
 #include "io.h"
 
 
@@ -20,56 +21,57 @@
 
 /*
  * Filters comments from sin stream and stores it into sout stream.
- */
+ * The input is scanned for slashes by memchr and the contiguous spans between
+ * comments are written out as whole blocks.
+ */
 void filterComment(STREAM sin, STREAM sout) {
-	
-	// Initialize vars.
-	int ch = sgetc(sin), ch2;
-	int newline = 1;
-
-	while (1) {
-		
-		// Potentional comment begin.
-		if (ch == '/') {
-			
-			// Check next character.
-			ch2 = sgetc(sin);
-			if (ch2 == '/') {
-
-				// Comment started - skip all chars until end of line.
-				ch = sgetc(sin);
-				while ((ch >= 0) && (ch != '\n'))
-					ch = sgetc(sin);
-
-				// If comment spaned over whole line (ingore LF).
-				if (newline) {
-					ch = sgetc(sin);
-					continue;
-				}
-			
-			// Coment has not started.		
-			} else {
-				sputc(sout, ch);	// Print out slash.
-				ch = ch2;
-			}
+
+	// Initialize vars.
+	size_t len;
+	const char *data = sdata(sin, &len);
+	const char *end = data + len;
+	const char *span = data;	// Beginning of the span which has not been written yet.
+	const char *pos = data;		// Position of the scanning.
+	int newline = 1;			// Whether the last written char was a newline (or nothing has been written).
+
+	while (pos < end) {
+
+		// Find potentional comment begin.
+		const char *slash = (const char*)memchr(pos, '/', end - pos);
+		if (!slash) break;
+
+		// Coment has not started.
+		if ((slash + 1 == end) || (slash[1] != '/')) {
+			pos = slash + 1;
+			continue;
+		}
+
+		// Write out everything before the comment.
+		if (slash > span) {
+			swrite(sout, span, slash - span);
+			newline = (slash[-1] == '\n');
+		}
+
+		// Comment started - skip all chars until end of line.
+		const char *eol = (const char*)memchr(slash + 2, '\n', end - slash - 2);
+		if (!eol) {
+			span = pos = end;
+			break;
 		}
-		
-		// File ended or error occured during reading -> finish reading.
-		if (ch < 0) break;
-		
-		// Print out character.
-		sputc(sout, ch);
-
-		// Check newline and get another character.
-		newline = (ch == '\n');		
-		ch = sgetc(sin);
+
+		// If comment spaned over whole line, skip the LF as well.
+		span = pos = (newline) ? eol + 1 : eol;
 	}
-	
+
+	// Write out the rest of the input.
+	if (end > span)
+		swrite(sout, span, end - span);
+
 	// Check for errors.
 	if (serror(sin))
-		error("Error occured while reading input file.");
-}
-
+		error("Error occured while reading input file.");
+}
+
 
 
 
@@ -79,26 +81,20 @@ void filterComment(STREAM sin, STREAM sout) {
  */
 int main(int argc, char **argv) {
 
-	// Skip first parameter (program name).
-	argv++;
-	
-	// Open input file.
+	// Open input file.
 	STREAM sin;
-	if (argv) {
-		if (!(sin = sopenRead(*argv)))
-			error("Error: Input file \"%s\" can not be open.", *argv)
-		argv++;
-	} else
+	if (argc > 1)
+		sin = sopenRead(argv[1]);
+	else
 		sin = STREAM_STDIN;
-	
-	// Open output file.
+
+	// Open output file.
 	STREAM sout;
-	if (argv) {
-		if (!(sout = sopenWrite(*argv)))
-			error("Error: Output file \"%s\" can not be open.", *argv);
-	} else
+	if (argc > 2)
+		sout = sopenWrite(argv[2]);
+	else
 		sout = STREAM_STDOUT;
-	
+
 	// Proceed with filtering.
 	filterComment(sin, sout);
 	
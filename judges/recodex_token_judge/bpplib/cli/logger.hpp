@@ -266,11 +266,48 @@ namespace bpp
 	}
 
 
+	/**
+	 * Logger of the current thread, which takes precedence over the resident logger of log() (see ScopedLogger).
+	 */
+	inline Logger *&threadLogger()
+	{
+		static thread_local Logger *logger = nullptr;
+		return logger;
+	}
+
+
+	/**
+	 * Makes given logger the logger of the current thread for the lifetime of this object, so that log() can be
+	 * redirected without replacing the resident (process-wide) logger.
+	 */
+	class ScopedLogger
+	{
+	private:
+		Logger *mPrevious; ///< Logger of the thread before this one.
+
+	public:
+		explicit ScopedLogger(Logger &logger) : mPrevious(threadLogger())
+		{
+			threadLogger() = &logger;
+		}
+
+		~ScopedLogger()
+		{
+			threadLogger() = mPrevious;
+		}
+
+		ScopedLogger(const ScopedLogger &) = delete;
+		ScopedLogger &operator=(const ScopedLogger &) = delete;
+	};
+
+
 	/**
 	 * Injectable singleton holder and wrapper for logger entitiy.
 	 */
 	Logger &log(std::unique_ptr<Logger> &&logger = std::unique_ptr<Logger>())
 	{
+		if (!logger && threadLogger() != nullptr) { return threadLogger()->setSeverity(LogSeverity::UNDEFINED); }
+
 		static std::unique_ptr<Logger> residentLogger;
 		if (logger) {
 			// Register new logger ...
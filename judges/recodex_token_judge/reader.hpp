@@ -226,6 +226,8 @@ private:
 	bpp::MMapFile mFile; ///< Underlying mmaped file.
 	bool mIgnoreEmptyLines; ///< Empty lines are skipped completely.
 	bool mAllowComments; ///< Allow comments (lines starting with '#'), which are completely skipped.
+	bool mAllowCppComments; ///< Anything from '//' to the end of line is a comment (even inside a token).
+	bool mAllowInlineComments; ///< Character '#' starts a comment anywhere (even inside a token).
 	bool mIgnoreLineEnds; ///< Treat end lines as regular whitespace.
 	bool mIgnoreTrailingWhitespace; ///< All whitespace (empty lines) at the end of the file is ignored
 
@@ -256,10 +258,15 @@ private:
 
 	/**
 	 * Skip currently processed token (any non-whitespace characters).
+	 * The token is terminated by a comment, if comments may appear inside tokens.
 	 */
 	void skipToken()
 	{
-		while (!eof() && !std::isspace((char) mData[mOffset])) ++mOffset;
+		if (mAllowCppComments || mAllowInlineComments) {
+			while (!eof() && !std::isspace((char) mData[mOffset]) && !isInlineCommentStart()) ++mOffset;
+		} else {
+			while (!eof() && !std::isspace((char) mData[mOffset])) ++mOffset;
+		}
 	}
 
 
@@ -275,12 +282,24 @@ private:
 	}
 
 
+	/**
+	 * Have we reached a start of a comment which may appear anywhere on a line (if permitted)?
+	 */
+	bool isInlineCommentStart()
+	{
+		if (eof()) return false;
+		if (mAllowInlineComments && mData[mOffset] == (char_t) '#') return true;
+		return mAllowCppComments && mData[mOffset] == (char_t) '/' && mOffset + 1 < mLength &&
+			mData[mOffset + 1] == (char_t) '/';
+	}
+
+
 	/**
 	 * Have we reached a comment start (if permitted)?
 	 */
 	bool isCommentStart()
 	{
-		return mAllowComments && !eof() && mData[mOffset] == (char_t) '#';
+		return (mAllowComments && !eof() && mData[mOffset] == (char_t) '#') || isInlineCommentStart();
 	}
 
 
@@ -289,7 +308,7 @@ private:
 	 */
 	bool isTokenStart()
 	{
-		return !eof() && !std::isspace((char) mData[mOffset]) && (!mAllowComments || mData[mOffset] != (char_t) '#');
+		return !eof() && !std::isspace((char) mData[mOffset]) && !isCommentStart();
 	}
 
 
@@ -302,9 +321,16 @@ private:
 	}
 
 public:
-	Reader(bool ignoreEmptyLines, bool allowComments, bool ignoreLineEnds, bool ignoreTrailingWhitespace) :
+	Reader(bool ignoreEmptyLines,
+		bool allowComments,
+		bool ignoreLineEnds,
+		bool ignoreTrailingWhitespace,
+		bool allowCppComments = false,
+		bool allowInlineComments = false) :
 		mIgnoreEmptyLines(ignoreEmptyLines),
 		mAllowComments(allowComments),
+		mAllowCppComments(allowCppComments),
+		mAllowInlineComments(allowInlineComments),
 		mIgnoreLineEnds(ignoreLineEnds),
 		mIgnoreTrailingWhitespace(ignoreTrailingWhitespace),
 		mData(nullptr),
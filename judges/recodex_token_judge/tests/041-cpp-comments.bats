@@ -0,0 +1,21 @@
+#!/usr/bin/env bats
+
+load bats-shared
+
+@test "allow c-style and inline comments" {
+	run $EXE_FILE --allow-cpp-comments --allow-inline-comments $CORRECT_FILE $RESULT_FILE
+	[ "$status" -eq 0 ]
+	[ "${lines[0]}" -eq 1 ]
+}
+
+@test "allow c-style comments only" {
+	run $EXE_FILE --allow-cpp-comments $CORRECT_FILE $RESULT_FILE
+	[ "$status" -eq 1 ]
+	[ "${lines[0]}" -eq 0 ]
+}
+
+@test "allow c-style comments (negative test)" {
+	run $EXE_FILE $CORRECT_FILE $RESULT_FILE
+	[ "$status" -eq 1 ]
+	echo "$output" | diff -abB - $ERROR_FILE
+}
@@ -0,0 +1,153 @@
+#ifndef RECODEX_TOKEN_JUDGE_TOKEN_JUDGE_HPP
+#define RECODEX_TOKEN_JUDGE_TOKEN_JUDGE_HPP
+
+#include "reader.hpp"
+#include "comparator.hpp"
+#include "judge.hpp"
+
+#include <cli/args.hpp>
+#include <cli/logger.hpp>
+#include <misc/ptr_fix.hpp>
+
+#include <iostream>
+
+
+/**
+ * Register all arguments of the token judge.
+ * \param args Program arguments object being filled.
+ */
+inline void registerTokenJudgeArgs(bpp::ProgramArguments &args)
+{
+	args.setNamelessCaption(0, "Expected (correct) output file.");
+	args.setNamelessCaption(1, "Tested solution output file for verification.");
+
+	// Reader args
+	args.registerArg(bpp::make_unique<bpp::ProgramArguments::ArgBool>(
+		"ignore-empty-lines", "Empty lines are ignored completely."));
+	args.registerArg(bpp::make_unique<bpp::ProgramArguments::ArgBool>(
+		"allow-comments", "Lines starting with '#' are ignored completely."));
+	args.registerArg(bpp::make_unique<bpp::ProgramArguments::ArgBool>("allow-cpp-comments",
+		"Anything from '//' to the end of line is ignored (lines containing only a comment are skipped)."));
+	args.registerArg(bpp::make_unique<bpp::ProgramArguments::ArgBool>("allow-inline-comments",
+		"Character '#' starts a comment anywhere on a line, even inside a token."));
+	args.registerArg(bpp::make_unique<bpp::ProgramArguments::ArgBool>(
+		"ignore-line-ends", "New lines characters are treated as regular whitespace."));
+	args.registerArg(bpp::make_unique<bpp::ProgramArguments::ArgBool>("ignore-trailing-whitespace",
+		"Any whitespace (i.e., empty lines or comments if allowed) at the end of files is ignored."));
+	args.getArg("ignore-empty-lines").conflictsWith("ignore-line-ends").conflictsWith("ignore-trailing-whitespace");
+	args.getArg("ignore-line-ends").conflictsWith("ignore-trailing-whitespace");
+
+	// Token comparator args
+	args.registerArg(bpp::make_unique<bpp::ProgramArguments::ArgBool>(
+		"case-insensitive", "Alphanumeric tokens are compared without case sensitivity."));
+	args.registerArg(bpp::make_unique<bpp::ProgramArguments::ArgBool>(
+		"numeric", "Tokens which appear to be integers or floats in decimal notation are compared as numbers."));
+	args.registerArg(bpp::make_unique<bpp::ProgramArguments::ArgFloat>("float-tolerance",
+		"Allowed maximal error for float number comparisons. The error of two numbers is |a-b|/(|a|+|b|).",
+		false,
+		0.0001,
+		0.0,
+		0.9));
+
+	// Comparison strategies
+	args.registerArg(bpp::make_unique<bpp::ProgramArguments::ArgBool>(
+		"shuffled-tokens", "Tokens on a line may appear in any order."));
+	args.registerArg(
+		bpp::make_unique<bpp::ProgramArguments::ArgBool>("shuffled-lines", "Lines may appear in any order."));
+	args.getArg("shuffled-lines").conflictsWith("ignore-line-ends");
+	args.registerArg(bpp::make_unique<bpp::ProgramArguments::ArgInt>(
+		"token-lcs-approx-max-window", "Tuning parameter for approx LCS for comparing lines (0 = always full LCS).", false, 11, 0, 255));
+
+	// Log args
+	args.registerArg(
+		bpp::make_unique<bpp::ProgramArguments::ArgInt>("log-limit", "Maximal length of the log (in bytes)."));
+}
+
+
+/**
+ * Run the token judge with given command line. This is the whole judge application,
+ * it may be invoked from main() or embedded into another process (the worker runs it in-process).
+ * \param argc Number of arguments (including the program name).
+ * \param argv Command line arguments (the first one is the program name).
+ * \param out Stream where the score is printed (stdout of the judge).
+ * \param err Stream where errors and the judge log are written (stderr of the judge).
+ * \return 0 if the outputs match, 1 if they do not, 2 on error (the usual judge exit codes).
+ */
+inline int runTokenJudge(int argc, const char *argv[], std::ostream &out, std::ostream &err)
+{
+	/*
+	 * Arguments
+	 */
+	bpp::ProgramArguments args(2, 2);
+	try {
+		registerTokenJudgeArgs(args);
+		args.process(argc, argv);
+	} catch (bpp::ArgumentException &e) {
+		err << "Error: " << e.what() << std::endl << std::endl;
+		args.printUsage(err);
+		return 2;
+	}
+
+	int res = 2;
+	try {
+		// Initialize logging, the logger belongs to this call only (the process-wide one is not replaced)
+		bpp::Logger logger(err);
+		bpp::ScopedLogger scopedLogger(logger);
+		if (args.getArg("log-limit").isPresent()) {
+			logger.restrictSize((std::size_t) args.getArgInt("log-limit").getValue());
+		}
+
+
+		// Open data readers ...
+		Reader<> correctReader(args.getArgBool("ignore-empty-lines").getValue(),
+			args.getArgBool("allow-comments").getValue(),
+			args.getArgBool("ignore-line-ends").getValue(),
+			args.getArgBool("ignore-trailing-whitespace").getValue(),
+			args.getArgBool("allow-cpp-comments").getValue(),
+			args.getArgBool("allow-inline-comments").getValue());
+		Reader<> resultReader(args.getArgBool("ignore-empty-lines").getValue(),
+			args.getArgBool("allow-comments").getValue(),
+			args.getArgBool("ignore-line-ends").getValue(),
+			args.getArgBool("ignore-trailing-whitespace").getValue(),
+			args.getArgBool("allow-cpp-comments").getValue(),
+			args.getArgBool("allow-inline-comments").getValue());
+
+		correctReader.open(args[0]);
+		resultReader.open(args[1]);
+
+
+		// Initialize comparators
+		TokenComparator<> tokenComparator(args.getArgBool("case-insensitive").getValue(),
+			args.getArgBool("numeric").getValue(),
+			args.getArgFloat("float-tolerance").getValue());
+
+		LineComparator<> lineComparator(tokenComparator,
+			args.getArgBool("shuffled-tokens").getValue(),
+			(std::size_t)args.getArgInt("token-lcs-approx-max-window").getValue());
+
+
+		// Create main judge and execute it ...
+		Judge<Reader<>, LineComparator<>> judge(
+			args.getArgBool("shuffled-lines").getValue(), correctReader, resultReader, lineComparator);
+		bool correct = judge.compare();
+		out << (correct ? 1.0 : 0.0) << std::endl;
+
+
+		// Finalize ...
+		bpp::log().flush();
+
+		correctReader.close();
+		resultReader.close();
+
+		res = correct ? 0 : 1;
+
+	} catch (std::exception &e) {
+		out << 0.0 << std::endl;
+		err << "Error: " << e.what() << std::endl << std::endl;
+	}
+
+	return res;
+}
+
+
+#endif
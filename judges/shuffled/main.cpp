@@ -56,8 +56,19 @@ void loadSwitches(char *arg) {
 
 
 
-// The data set (entire file is loaded here).
-typedef vector<CRow> FILE_DATA;
+/*
+ * The data set (entire file is loaded here).
+ * Tokens of all rows are kept in one arena and they refer directly to the file data,
+ * so the file is kept open as long as the data set exists.
+ */
+struct FILE_DATA {
+	CFile *file;			// Mapped file with the data.
+	vector<CToken> tokens;	// Arena of all tokens in the file.
+	vector<CRow> rows;		// Rows (ranges of tokens in the arena).
+
+	FILE_DATA() : file(NULL) {}
+	~FILE_DATA() { delete file; }
+};
 
 
 #ifdef DEBUG
@@ -65,8 +76,8 @@ typedef vector<CRow> FILE_DATA;
  * Dump whole data set.
  */
 void dump(FILE_DATA &data) {
-	for(unsigned i = 0; i < data.size(); i++)
-		data[i].dump();
+	for(size_t i = 0; i < data.rows.size(); i++)
+		data.rows[i].dump();
 }
 #endif
 
@@ -78,27 +89,26 @@ void dump(FILE_DATA &data) {
 void load(FILE_DATA &data, const char *fileName, bool ignoreNewlines) {
 	
 	// Open file.
-	CFile file(fileName);
+	data.file = new CFile(fileName);
+	CFile &file = *data.file;
 	file.ignoreNewlines = ignoreNewlines;
-	
-	// Initialize data.
-	data.clear();
+
+	// Rough estimate of the number of tokens (to avoid repeated reallocations of the arena).
+	data.tokens.reserve((file.getBufEnd() - file.getPos()) / 8 + 1);
 	
 	// Read rows in cycle until whole file is read.
 	while(!file.eof()) {
 		
-		// Create a new row.
-		data.push_back( CRow() );
-
-		// If there is a regular pattern in amount of tokens on rows, allocate exact capacity for the row.
-		if ((data.size() > 1) && (data[data.size()-1].size() == data[data.size()-2].size()))
-			data.back().reserve( data[data.size()-1].size() );
-
-		// Load row of tokens.
-		data.back().load(file);
-		if (data.back().size() == 0)
+		// Create a new row and load its tokens.
+		data.rows.push_back( CRow() );
+		data.rows.back().load(file, data.tokens);
+		if (data.rows.back().size() == 0)
 			error("Error occured while reading file.");
 	}
+
+	// The arena will not grow any more, rows may refer to it directly.
+	for(size_t i = 0; i < data.rows.size(); i++)
+		data.rows[i].bind(data.tokens);
 }
 
 
@@ -106,11 +116,11 @@ void load(FILE_DATA &data, const char *fileName, bool ignoreNewlines) {
  * Compares data sets and returns the RES_OK or RES_WRONG result..
  */
 int compare(FILE_DATA &data1, FILE_DATA &data2) {
-	if (data1.size() != data2.size())
+	if (data1.rows.size() != data2.rows.size())
 		return RES_WRONG;
 
-	for(unsigned int i = 0; i < data1.size(); i++)
-		if (data1[i] != data2[i])
+	for(size_t i = 0; i < data1.rows.size(); i++)
+		if (!data1.rows[i].equals(data2.rows[i]))
 			return RES_WRONG;
 		
 	return RES_OK;
@@ -118,6 +128,86 @@ int compare(FILE_DATA &data1, FILE_DATA &data2) {
 
 
 
+/*
+ * Hash index of rows (open addressing by row hashes). Rows with the same hash are chained,
+ * so duplicate rows and hash collisions are resolved by exact comparison of the rows.
+ */
+class CRowIndex {
+private:
+	static const size_t NONE = (size_t)-1;
+
+	struct Slot {
+		uint64_t hash;	// Hash of the rows in this slot.
+		size_t head;	// First row of the chain (NONE if all rows were taken).
+		bool used;		// Whether the slot was ever occupied.
+	};
+
+	vector<CRow> &rows;
+	vector<Slot> slots;
+	vector<size_t> next;	// Chains of rows with the same hash.
+	size_t mask;
+
+	Slot &findSlot(uint64_t hash) {
+		size_t i = (size_t)hash & mask;
+		while (slots[i].used && slots[i].hash != hash)
+			i = (i + 1) & mask;
+		return slots[i];
+	}
+
+public:
+	CRowIndex(vector<CRow> &rows) : rows(rows), next(rows.size(), NONE) {
+		size_t capacity = 16;
+		while (capacity < rows.size() * 2)
+			capacity <<= 1;
+		Slot empty = { 0, NONE, false };
+		slots.assign(capacity, empty);
+		mask = capacity - 1;
+
+		for(size_t i = 0; i < rows.size(); i++) {
+			Slot &slot = findSlot(rows[i].getHash());
+			slot.hash = rows[i].getHash();
+			slot.used = true;
+			next[i] = slot.head;
+			slot.head = i;
+		}
+	}
+
+	/*
+	 * Find a row equal to given row and remove it from the index. Returns false if there is none.
+	 */
+	bool take(CRow &row) {
+		Slot &slot = findSlot(row.getHash());
+		if (!slot.used)
+			return false;
+
+		for(size_t *link = &slot.head; *link != NONE; link = &next[*link]) {
+			if (rows[*link].equals(row)) {
+				*link = next[*link];
+				return true;
+			}
+		}
+		return false;
+	}
+};
+
+
+/*
+ * Compares data sets with shuffled rows (as multisets of rows) and returns the RES_OK or RES_WRONG result.
+ */
+int compareShuffledRows(FILE_DATA &data1, FILE_DATA &data2) {
+	if (data1.rows.size() != data2.rows.size())
+		return RES_WRONG;
+
+	CRowIndex index(data1.rows);
+	for(size_t i = 0; i < data2.rows.size(); i++)
+		if (!index.take(data2.rows[i]))
+			return RES_WRONG;
+
+	return RES_OK;
+}
+
+
+
 
 
 /*
@@ -140,19 +230,13 @@ int main(int argc, char **argv) {
 	load(data1, argv[argc-2], HAS_SWITCH(SWITCH_IGNORE_NEWLINES));
 	load(data2, argv[argc-1], HAS_SWITCH(SWITCH_IGNORE_NEWLINES));
 
-	// Sort rows if necessary.
-	if (HAS_SWITCH(SWITCH_SHUFFLED_ROWS)) {
-		sort(data1.begin(), data1.end());
-		sort(data2.begin(), data2.end());
-	}
-
 #ifdef DEBUG
 	dump(data1);
 	return 0;
 #endif
 
-	// Compare the data sets and write results.
-	int res = compare(data1, data2);
+	// Compare the data sets (as multisets of rows if the rows are shuffled) and write results.
+	int res = HAS_SWITCH(SWITCH_SHUFFLED_ROWS) ? compareShuffledRows(data1, data2) : compare(data1, data2);
 	if (res == RES_OK) {
 		printf("%lf", 1.0);
 	} else {
@@ -2,12 +2,19 @@
  * Token library for Shuffled judge.
  * (C) 2007 Martin Krulis <krulis@ksvi.mff.cuni.cz>
  *
- * Token lib implements a few classes that are used for tokenizing and token ordering a text file. 
+ * Token lib implements a few classes that are used for tokenizing and token ordering a text file.
  *
  */
 #include "token.h"
 #include <algorithm>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 
 using namespace std;
 
@@ -17,40 +24,94 @@ using namespace std;
  */
 
 /*
- * File reading abstraction. Reads entire file into one string.
- * Buffer is allocated as big as needed (plus trailing zero) and file length is returned.
+ * File reading abstraction. Maps entire file into memory (or reads it into one buffer
+ * if the file cannot be mapped).
+ */
+CFile::CFile(const char *fileName) : buf(NULL), pos(NULL), bufEnd(NULL), mapped(false), ignoreNewlines(false) {
+
+	if (!map(fileName))
+		read(fileName);
+	pos = buf;
+
+	// Skip leading whitespace.
+	skipWhitespace();
+}
+
+
+CFile::~CFile() {
+#ifndef _WIN32
+	if (mapped) {
+		munmap((void*)buf, bufEnd - buf);
+		return;
+	}
+#endif
+	free((void*)buf);
+}
+
+
+/*
+ * Try to map the file into memory. Returns false if the file cannot be mapped
+ * (it is not a regular file, it is empty, or mapping is not supported on this platform).
+ */
+bool CFile::map(const char *fileName) {
+#ifndef _WIN32
+	int fd = open(fileName, O_RDONLY);
+	if (fd < 0)
+		error("File \"%s\" can not be open.", fileName);
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+		close(fd);
+		return false;
+	}
+
+	void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return false;
+
+	// The file is tokenized strictly from the beginning to the end.
+	posix_madvise(data, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+
+	buf = (const char*)data;
+	bufEnd = buf + st.st_size;
+	mapped = true;
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+/*
+ * Read entire file into one buffer (fallback when the file cannot be mapped).
  */
-CFile::CFile(const char *fileName) {
+void CFile::read(const char *fileName) {
 
 	// Open the file.
 	FILE *fp = fopen(fileName, "rb");
 	if (!fp)
 		error("File \"%s\" can not be open.", fileName);
-	
-	// Get file length.
-	fseek(fp, 0, SEEK_END);
-	long len = ftell(fp);
-	if (len > MAX_FILE_SIZE)
-		error("File \"%s\" is too big (%lu B).", fileName, len);
-	fseek(fp, 0, SEEK_SET);
-	
-	// Allocate buffer.
-	buf = pos = (char*)malloc(len+1);
-	if (!buf)
-		error("Out of memory.");
-	
-	// Read data (and close the file since it won't be needed any more).
-	int count = fread(buf, 1, len, fp);
-	if (count < len)
-		error("Unexpected end of file \"%s\" (only %d from %lu bytes were read) [ferror = %d]", fileName, count, len, ferror(fp));
+
+	// Read data in chunks (the file does not have to be seekable).
+	size_t len = 0, capacity = 0;
+	char *data = NULL;
+	do {
+		if (capacity - len < 65536) {
+			capacity = capacity ? capacity * 2 : 65536;
+			data = (char*)realloc(data, capacity);
+			if (!data)
+				error("Out of memory.");
+		}
+		len += fread(data + len, 1, capacity - len, fp);
+	} while (!feof(fp) && !ferror(fp));
+
+	if (ferror(fp))
+		error("Unable to read file \"%s\" (only %lu bytes were read) [ferror = %d]", fileName, (unsigned long)len, ferror(fp));
 	fclose(fp);
 
-	// Find end of the file and put a traling zero there.
-	bufEnd = buf + count;
-	*bufEnd = '\0';
-	
-	// Skip leading whitespace.
-	skipWhitespace();
+	buf = data;
+	bufEnd = buf + len;
 }
 
 
@@ -62,15 +123,15 @@ inline int CFile::skipWhitespace() {
 
 	// While there's a whitespace on actual position.
 	while(!eof() && isWhitespace(getChar())) {
-		
+
 		// Check for newlines.
 		if (getChar() == '\n')
 			newlines++;
 
-		// Convert whitespace into zero and move further.
-		putZero();;
+		// Move further.
+		incPos();
 	}
-	
+
 	return ignoreNewlines ? 0 : newlines;
 }
 
@@ -83,14 +144,10 @@ inline int CFile::skipWhitespace() {
  */
 
 /*
- * Adds new char into hash code (for calculating hash value) and returns new hash.
+ * FNV-1a hashing constants (64-bit variant).
  */
-inline unsigned int CToken::addHashChar(unsigned int hash, char ch) {
-	unsigned int x = (hash >> 20) & (1 << (5 - 1));
-	hash = (hash << 5) ^ (unsigned)ch;
-	hash = hash ^ x;
-	return hash;
-}
+#define	FNV_OFFSET_BASIS	0xcbf29ce484222325ULL
+#define	FNV_PRIME			0x100000001b3ULL
 
 
 /*
@@ -100,26 +157,24 @@ bool CToken::parse(CFile &file) {
 
 	// Clean token members.
 	str = NULL;
-	hash = 0;
+	len = 0;
+	hash = FNV_OFFSET_BASIS;
 
 	// Skip leading whitespace.
 	int newline = file.skipWhitespace();
-	
+
 	// If newline was found of input ends - return empty token.
 	if (newline || file.eof())
 		return false;
-			
+
 	// Load token itself.
 	str = file.getPos();
-	unsigned int len = 0;
 	while(!file.eof() && !file.isWhitespace()) {
-		hash = addHashChar(hash, file.getChar());
+		hash = (hash ^ (unsigned char)file.getChar()) * FNV_PRIME;
 		file.incPos();
-		len++;
 	}
-	
-	hash <<= 7;
-	hash ^= len;
+	len = file.getPos() - str;
+
 	return true;
 }
 
@@ -136,12 +191,24 @@ bool CRow::shuffledItems = false;
 
 
 /*
- * Load row of tokens from given file.
+ * Scramble bits of a token hash before it is combined into the row hash
+ * (finalizer of the SplitMix64 generator). Summing raw FNV hashes would be too weak.
  */
-void CRow::load(CFile &file) {
-	
+static inline uint64_t mixHash(uint64_t x) {
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+
+/*
+ * Load row of tokens from given file. Tokens are appended to the arena.
+ */
+void CRow::load(CFile &file, vector<CToken> &arena) {
+
 	// Prepare variables.
 	CToken token;
+	first = arena.size();
 	hash = 0;
 
 	// Read all tokens on the row.
@@ -150,17 +217,26 @@ void CRow::load(CFile &file) {
 		// Modify hash.
 		if (!shuffledItems) {
 			// If the items are not shuffled the hash should reflect ordering.
-			unsigned int x = hash >> 27;
-			hash = hash << 5;
-			hash ^= token.getHash() ^ x;
-		} else
-			hash = (unsigned)(((unsigned long)hash + (unsigned long)token.getHash()) & 0xffffffff);
-
-		// Store token into the vector and fetch another one.
-		tokens.push_back(token);
+			hash = (hash ^ mixHash(token.getHash())) * FNV_PRIME;
+		} else {
+			// Otherwise the hash represents the multiset of tokens (so it has to be commutative).
+			hash += mixHash(token.getHash());
+		}
+
+		// Store token into the arena and fetch another one.
+		arena.push_back(token);
 	}
-	
-	// If items are shuffled, sort them.
-	if (shuffledItems)
-		sort(tokens.begin(), tokens.end());
+
+	count = arena.size() - first;
+}
+
+
+/*
+ * Sort tokens of the row (so two rows with shuffled items can be compared exactly).
+ */
+void CRow::sortTokens() {
+	if (sorted)
+		return;
+	sort(tokens, tokens + count);
+	sorted = true;
 }
@@ -9,6 +9,7 @@
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
+#include <cstdint>
 #include <vector>
 
 //Disable warning about fopen() on Windows
@@ -38,41 +39,45 @@
 }
 
 
-// Maximal file size that is allowed to be processe by this lib.
-#define	MAX_FILE_SIZE	(32 << 20)
-
-
 
 
 
 /*
  * Class that encapsulates file operations.
- * Whole file is read into one large buffer and all operations are performed on that buffer.
+ * Whole file is mapped into memory (or read into one large buffer if mapping is not possible)
+ * and all operations are performed on that read-only data.
  */
 class CFile {
 private:
-	char *buf;		// Allocated buffer for the file's data.
-	char *pos;		// Actual position in the buffer.
-	char *bufEnd;	// Pointer at the end of the buffer.
+	const char *buf;	// Mapped (or allocated) file data.
+	const char *pos;	// Actual position in the buffer.
+	const char *bufEnd;	// Pointer at the end of the buffer.
+	bool mapped;		// Whether the buffer is mapped (or allocated by malloc).
+
+	bool map(const char *fileName);
+	void read(const char *fileName);
+
+	CFile(const CFile &);
+	CFile &operator =(const CFile &);
+
 
-	
 public:
-	// Flag that indicates whether 
+	// Flag that indicates whether newlines are treated as regular whitespace.
 	bool ignoreNewlines;
-	
-	// Constructor - reads given file.
+
+	// Constructor - maps (or reads) given file.
 	CFile(const char *fileName);
-	
+	~CFile();
+
 	/*
 	 * Inline functions.
 	 */
 	char getChar() const			{ return *pos; }
 	void incPos()					{ pos++; }
-	void putZero()					{ *pos++ = '\0'; }
 	const char *getPos() const		{ return pos; }
 	const char *getBufEnd() const	{ return bufEnd; }
 	bool eof() const				{ return (pos == bufEnd); }
-	
+
 	static inline bool isWhitespace(char ch) {
 		return (ch == ' ') || (ch == '\t') || (ch == '\r') || (ch == '\n');
 	}
@@ -84,37 +89,40 @@ public:
 
 /*
  * CToken encapsulates one token in the file stream.
- * It contains pointer to begining of the token and it's hash code.
+ * It contains pointer to begining of the token (in the file's data), its length and 64-bit hash code.
  */
 class CToken {
 private:
-	const char *str;	// Begining of the token in the file's buffer.
-	unsigned int hash;	// XOR hash code of the token.
+	const char *str;	// Begining of the token in the file's buffer (it is not zero-terminated).
+	size_t len;			// Length of the token.
+	uint64_t hash;		// FNV-1a hash code of the token.
 
-	static inline unsigned int addHashChar(unsigned int hash, char ch);
 
-	
 public:
-	unsigned int getHash()			{ return hash; }
+	uint64_t getHash() const		{ return hash; }
 	bool parse(CFile &file);
 
 #ifdef DEBUG
-	void dump()	{ printf("Token [%x]: \"%s\"\n", hash, str); }
+	void dump()	{ printf("Token [%llx]: \"%.*s\"\n", (unsigned long long)hash, (int)len, str); }
 #endif
 
 	// Comparing function and operators override.
 	int compare(CToken const &token) const {
-		if (hash == token.hash) {
-			return strcmp(str, token.str);
-		} else
+		if (hash != token.hash)
 			return (hash < token.hash) ? -1 : 1;
-		
+		if (len != token.len)
+			return (len < token.len) ? -1 : 1;
+		return memcmp(str, token.str, len);
+	}
+
+	bool operator ==(const CToken &token) const {
+		return (hash == token.hash) && (len == token.len) && (memcmp(str, token.str, len) == 0);
 	}
-	
+
 	bool operator !=(const CToken &token) const {
-		return (compare(token) != 0);
+		return !(*this == token);
 	}
-	
+
 	bool operator <(const CToken &token) const {
 		return (compare(token) < 0);
 	}
@@ -124,66 +132,62 @@ public:
 
 
 /*
- * CRow encapsulates one row of tokens. 
+ * CRow encapsulates one row of tokens.
+ * The tokens themselves are stored in one arena vector of the whole file (see load()),
+ * the row keeps only their range and a 64-bit hash of the entire row.
  */
 class CRow {
 private:
-	std::vector<CToken> tokens;		// Vector of token objects on the row.
-	unsigned int hash;				// XOR hash code of the entire row (it is calculated from hashes of all tokens).
-	
+	size_t first;			// Index of the first token of the row in the arena.
+	size_t count;			// Number of tokens on the row.
+	CToken *tokens;			// Pointer to the first token (valid after bind()).
+	uint64_t hash;			// Hash code of the entire row (it is calculated from hashes of all tokens).
+	bool sorted;			// Whether the tokens are already sorted (only shuffled items get sorted).
+
+	void sortTokens();
+
 public:
 	// Static flag for all rows - whether the items are shuffled.
 	static bool shuffledItems;
-	
-	unsigned size()				{ return tokens.size(); }
-	void reserve(int capacity)	{ tokens.reserve(capacity); }
-	
-	void load(CFile &file);
-//	void sortTokens();
+
+	CRow() : first(0), count(0), tokens(NULL), hash(0), sorted(false) {}
+
+	size_t size() const			{ return count; }
+	uint64_t getHash() const	{ return hash; }
+
+	void load(CFile &file, std::vector<CToken> &arena);
+	void bind(std::vector<CToken> &arena)	{ tokens = arena.empty() ? NULL : &arena[first]; }
 
 #ifdef DEBUG
 	void dump()	{
-		printf("Row [%x] with %d tokens:\n", hash, size());
-		for(unsigned i = 0; i < size(); i++)
+		printf("Row [%llx] with %d tokens:\n", (unsigned long long)hash, (int)size());
+		for(size_t i = 0; i < size(); i++)
 			tokens[i].dump();
 		printf("\n");
 	}
 #endif
 
-	// Operator overrides.
-	bool operator ==(const CRow &row) const {
+	/*
+	 * Exact comparison of two rows. Hashes are compared first, so the tokens are checked
+	 * only when the rows are (almost certainly) equal. If the items are shuffled, the hash
+	 * represents the multiset of tokens and the tokens are sorted only for the exact check.
+	 */
+	bool equals(CRow &row) {
 		// Quick check - hashes and lengths.
-		if ((hash != row.hash) || tokens.size() != row.tokens.size())
+		if ((hash != row.hash) || (count != row.count))
 			return false;
-		
+
+		if (shuffledItems) {
+			sortTokens();
+			row.sortTokens();
+		}
+
 		// Check every token on the row.
-		for(unsigned i = 0; i < tokens.size(); i++)
+		for(size_t i = 0; i < count; i++)
 			if (tokens[i] != row.tokens[i]) return false;
 
 		return true;
 	}
-	
-	bool operator !=(const CRow &row) const {
-		return !(*this == row);
-	}
-	
-	bool operator <(const CRow &row) const {
-		if (hash == row.hash) {
-			if (tokens.size() == row.tokens.size()) {
-				// Check all tokens.
-				for(unsigned i = 0; i < tokens.size(); i++) {
-					int res = tokens[i].compare(row.tokens[i]);
-					if (res < 0) return true;
-					if (res > 0) return false;
-				}
-				
-				// All tokens are equal;
-				return false;
-			} else
-				return (tokens.size() < row.tokens.size());
-		} else
-			return (hash < row.hash);
-	}
 };
 
 
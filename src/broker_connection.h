@@ -7,6 +7,7 @@
 #include <bitset>
 
 #include "helpers/logger.h"
+#include "helpers/trace.h"
 #include "config/worker_config.h"
 #include "commands/command_holder.h"
 #include "commands/broker_commands.h"
@@ -42,6 +43,10 @@ private:
 	std::shared_ptr<command_holder<broker_connection_context<proxy>>> jobs_server_cmds_;
 	std::chrono::seconds reconnect_delay = std::chrono::seconds(1);
 	std::string current_job_;
+	std::shared_ptr<cache_warmer> warmer_;
+	std::shared_ptr<helpers::cancellation_token> cancellation_;
+	/** Trace span of the current job from its eval request to the done message */
+	std::unique_ptr<helpers::trace_span> job_span_;
 
 	/**
 	 * Send the init command to the broker
@@ -85,21 +90,30 @@ public:
 	 * @param config configuration of the worker
 	 * @param socket a proxy of ZeroMQ communication channels
 	 * @param logger a logging service
+	 * @param warmer prefetching of files into the cache (optional), paused while a job is evaluated
+	 * @param cancellation cancellation of the evaluated job (optional)
 	 */
 	broker_connection(std::shared_ptr<const worker_config> config,
 		std::shared_ptr<proxy> socket,
-		std::shared_ptr<spdlog::logger> logger = nullptr)
-		: config_(config), socket_(socket), logger_(logger), current_job_("")
+		std::shared_ptr<spdlog::logger> logger = nullptr,
+		std::shared_ptr<cache_warmer> warmer = nullptr,
+		std::shared_ptr<helpers::cancellation_token> cancellation = nullptr)
+		: config_(config), socket_(socket), logger_(logger), current_job_(""), warmer_(warmer),
+		  cancellation_(cancellation)
 	{
 		if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
 
 		// prepare dependent context for commands (in this class)
-		broker_connection_context<proxy> dependent_context = {socket_, config_, current_job_};
+		broker_connection_context<proxy> dependent_context = {socket_, config_, current_job_, warmer_, cancellation_};
 
 		// init broker commands
 		broker_cmds_ = std::make_shared<command_holder<broker_connection_context<proxy>>>(dependent_context, logger_);
 		broker_cmds_->register_command("eval", broker_commands::process_eval<broker_connection_context<proxy>>);
 		broker_cmds_->register_command("intro", broker_commands::process_intro<broker_connection_context<proxy>>);
+		broker_cmds_->register_command(
+			"warmup", broker_commands::process_warmup<broker_connection_context<proxy>>);
+		broker_cmds_->register_command(
+			"cancel", broker_commands::process_cancel<broker_connection_context<proxy>>);
 
 		// init jobs server commands
 		jobs_server_cmds_ =
@@ -162,7 +176,14 @@ public:
 
 					if (terminate) { break; }
 
-					if (msg.size() >= 2 && msg.at(0) == "eval") { current_job_ = msg.at(1); }
+					if (msg.size() >= 2 && msg.at(0) == "eval") {
+						current_job_ = msg.at(1);
+						// the previous span must end first, spans of one thread are nested
+						job_span_ = nullptr;
+						job_span_ = std::make_unique<helpers::trace_span>("broker", current_job_);
+						// evaluation must not compete with prefetching
+						if (warmer_ != nullptr) { warmer_->pause(); }
+					}
 
 					broker_cmds_->call_function(msg.at(0), msg);
 				}
@@ -172,17 +193,20 @@ public:
 
 					if (terminate) { break; }
 
-					if (msg.size() >= 1 && msg.at(0) == "done") { current_job_ = ""; }
+					if (msg.size() >= 1 && msg.at(0) == "done") {
+						current_job_ = "";
+						if (job_span_ != nullptr && msg.size() >= 3) { job_span_->set("result", msg.at(2)); }
+						job_span_ = nullptr;
+						if (warmer_ != nullptr) { warmer_->resume(); }
+					}
 
 					jobs_server_cmds_->call_function(msg.at(0), msg);
 				}
 
 				if (result.test(message_origin::PROGRESS)) {
-					socket_->recv_progress(msg, &terminate);
+					socket_->forward_progress(&terminate);
 
 					if (terminate) { break; }
-
-					socket_->send_broker(msg);
 				}
 			} catch (std::exception &e) {
 				logger_->error("Unexpected error while receiving tasks: {}", e.what());
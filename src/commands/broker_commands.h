@@ -37,6 +37,48 @@ namespace broker_commands
 
 		context.sockets->send_broker(reply);
 	}
+
+	/**
+	 * Broker asks to prefetch files into the local cache (the files are expected to be needed soon).
+	 * The downloads run in background, no reply is sent.
+	 * @param args received multipart message with leading command followed by full URLs of the files
+	 * @param context command context of command holder
+	 */
+	template <typename context_t>
+	void process_warmup(const std::vector<std::string> &args, const command_context<context_t> &context)
+	{
+		if (context.warmer == nullptr) {
+			context.logger->warn("Cache warm-up requested, but it is not available");
+			return;
+		}
+
+		context.warmer->warmup(std::vector<std::string>(args.begin() + 1, args.end()));
+	}
+
+	/**
+	 * Broker asks to stop evaluation of a job. The running program is terminated, remaining tasks are skipped and
+	 * the job is reported as cancelled in its done message. The request may arrive before the evaluation starts.
+	 * @param args received multipart message with leading command followed by identifier of the job
+	 * @param context command context of command holder
+	 */
+	template <typename context_t>
+	void process_cancel(const std::vector<std::string> &args, const command_context<context_t> &context)
+	{
+		if (args.size() != 2) {
+			context.logger->warn("Cancel command with wrong number of arguments");
+			return;
+		}
+		if (context.cancellation == nullptr) {
+			context.logger->warn("Cancellation of job {} requested, but it is not available", args[1]);
+			return;
+		}
+
+		if (context.cancellation->cancel(args[1])) {
+			context.logger->info("Job {} is being cancelled", args[1]);
+		} else {
+			context.logger->info("Job {} is not evaluated now, it is cancelled when it starts", args[1]);
+		}
+	}
 } // namespace broker_commands
 
 #endif // RECODEX_WORKER_BROKER_COMMANDS_H
@@ -9,6 +9,8 @@
 #include "helpers/logger.h"
 #include "job/job_evaluator_interface.h"
 #include "config/worker_config.h"
+#include "fileman/cache_warmer.h"
+#include "helpers/cancellation_token.h"
 
 
 /**
@@ -24,6 +26,10 @@ public:
 	std::shared_ptr<const worker_config> config;
 	/** Identifier of currently evaluated job, usefull when reconnecting during evaluation. */
 	const std::string &current_job;
+	/** Prefetching of files into the local cache, @a nullptr if not available. */
+	std::shared_ptr<cache_warmer> warmer;
+	/** Cancellation of the evaluated job, @a nullptr if not available. */
+	std::shared_ptr<helpers::cancellation_token> cancellation;
 };
 
 /**
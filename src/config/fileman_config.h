@@ -2,6 +2,7 @@
 #define RECODEX_WORKER_FILEMAN_CONFIG_H
 
 #include <string>
+#include <cstddef>
 
 /**
  * Struct which stores informations which are usefull in file managers.
@@ -14,6 +15,21 @@ public:
 	std::string username = "";
 	/** Classical credentials. */
 	std::string password = "";
+	/** How many times a failed download is retried (transient errors only). */
+	std::size_t retries = 3;
+	/** Delay before the first retry in milliseconds, it doubles with every next retry. */
+	std::size_t retry_delay = 1000;
+	/** Transfer slower than this (in bytes per second) for @a low_speed_time seconds is aborted. */
+	std::size_t low_speed_limit = 1024;
+	/** Number of seconds the transfer may be slower than @a low_speed_limit (zero disables the check). */
+	std::size_t low_speed_time = 60;
+	/** Whether compressed transfer of downloaded files (gzip, zstd, ...) is negotiated with the server. */
+	bool compression = true;
+	/** Local directory (e.g., NFS mount) with the same contents as the file server, files are not transferred over
+	 * HTTP if set (see @ref local_file_manager). */
+	std::string local_dir = "";
+	/** Whether files from @a local_dir can be delivered as hard links (they must not be modified then). */
+	bool local_hardlink = false;
 
 	/**
 	 * Classic equality operator. All variables should match.
@@ -22,7 +38,11 @@ public:
 	 */
 	bool operator==(const fileman_config &second) const
 	{
-		return (remote_url == second.remote_url && username == second.username && password == second.password);
+		return (remote_url == second.remote_url && username == second.username && password == second.password &&
+			retries == second.retries && retry_delay == second.retry_delay &&
+			low_speed_limit == second.low_speed_limit && low_speed_time == second.low_speed_time &&
+			compression == second.compression && local_dir == second.local_dir &&
+			local_hardlink == second.local_hardlink);
 	}
 
 	/**
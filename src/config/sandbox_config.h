@@ -3,6 +3,7 @@
 
 #include <map>
 #include <memory>
+#include <vector>
 #include "sandbox_limits.h"
 
 
@@ -60,6 +61,11 @@ public:
 	 * Working directory relative to the directory with the source files.
 	 */
 	std::string working_directory = "";
+	/**
+	 * Files produced by the task, used as outputs of cached initiation tasks.
+	 * @note Paths must be accessible from inside of sandbox.
+	 */
+	std::vector<std::string> outputs;
 	/**
 	 * Associative array of loaded limits with textual index identifying its hw group.
 	 */
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 
 /**
  * Return error codes of sandbox. Code names corresponds isolate's meta file error codes.
@@ -21,6 +22,44 @@ enum class isolate_status {
 enum class task_status { OK, FAILED, SKIPPED };
 
 
+/**
+ * Resource usage of a sandboxed program at one moment of its run.
+ * Counters (CPU time and I/O) are cumulative since the start of the run.
+ */
+struct resource_sample {
+	/**
+	 * Time since the start of the run.
+	 * Default: 0 (ms)
+	 */
+	std::size_t time = 0;
+	/**
+	 * Memory used by all processes of the program (including page cache).
+	 * Default: 0 (kB)
+	 */
+	std::size_t memory = 0;
+	/**
+	 * Consumed CPU time of all processes.
+	 * Default: 0 (ms)
+	 */
+	std::size_t cpu_time = 0;
+	/**
+	 * Bytes read from block devices.
+	 * Default: 0
+	 */
+	std::size_t io_read = 0;
+	/**
+	 * Bytes written to block devices.
+	 * Default: 0
+	 */
+	std::size_t io_write = 0;
+	/**
+	 * Number of processes and threads.
+	 * Default: 0
+	 */
+	std::size_t pids = 0;
+};
+
+
 /**
  * Sandbox results.
  * @note Not all items must be returned from sandbox, so some defaults may aply.
@@ -81,6 +120,11 @@ struct sandbox_results {
 	 * Default: 0
 	 */
 	std::size_t csw_forced = 0;
+	/**
+	 * Resource usage sampled during the run (if sampling is enabled).
+	 * Default: empty
+	 */
+	std::vector<resource_sample> samples;
 
 	/**
 	 * Constructor with default values initialization.
@@ -1,5 +1,6 @@
 #include "worker_config.h"
 #include "helpers/config.h"
+#include "helpers/affinity.h"
 
 worker_config::worker_config() = default;
 
@@ -52,8 +53,86 @@ worker_config::worker_config(const YAML::Node &config)
 			if (cache["cache-dir"] && cache["cache-dir"].IsScalar()) {
 				cache_dir_ = config["file-cache"]["cache-dir"].as<std::string>();
 			}
+
+			if (cache["warmup-threads"] && cache["warmup-threads"].IsScalar()) {
+				cache_warmup_threads_ = cache["warmup-threads"].as<std::size_t>();
+			} // can be omitted... no throw
 		}
 
+		// load staging item
+		if (config["staging"] && config["staging"].IsMap()) {
+			auto &staging = config["staging"];
+			if (staging["directory"] && staging["directory"].IsScalar()) {
+				staging_dir_ = staging["directory"].as<std::string>();
+			} // no throw... can be omitted
+			if (staging["job-budget"] && staging["job-budget"].IsScalar()) {
+				staging_job_budget_ = staging["job-budget"].as<std::size_t>();
+			} // no throw... can be omitted
+		} // can be omitted... no throw
+
+		// load compilation-cache item
+		if (config["compilation-cache"] && config["compilation-cache"].IsMap()) {
+			auto &compilation_cache = config["compilation-cache"];
+			if (compilation_cache["directory"] && compilation_cache["directory"].IsScalar()) {
+				compilation_cache_dir_ = compilation_cache["directory"].as<std::string>();
+			} // no throw... can be omitted
+			if (compilation_cache["max-size"] && compilation_cache["max-size"].IsScalar()) {
+				compilation_cache_max_size_ = compilation_cache["max-size"].as<std::size_t>();
+			} // no throw... can be omitted
+			if (compilation_cache["toolchain"] && compilation_cache["toolchain"].IsSequence()) {
+				compilation_cache_toolchain_ = compilation_cache["toolchain"].as<std::vector<std::string>>();
+			} // no throw... can be omitted
+			if (compilation_cache["toolchain-version"] && compilation_cache["toolchain-version"].IsScalar()) {
+				compilation_cache_toolchain_version_ = compilation_cache["toolchain-version"].as<std::string>();
+			} // no throw... can be omitted
+		} // can be omitted... no throw
+
+		// load judge-cache item
+		if (config["judge-cache"] && config["judge-cache"].IsMap()) {
+			auto &judge_cache = config["judge-cache"];
+			if (judge_cache["directory"] && judge_cache["directory"].IsScalar()) {
+				judge_cache_dir_ = judge_cache["directory"].as<std::string>();
+			} // no throw... can be omitted
+			if (judge_cache["max-size"] && judge_cache["max-size"].IsScalar()) {
+				judge_cache_max_size_ = judge_cache["max-size"].as<std::size_t>();
+			} // no throw... can be omitted
+			if (judge_cache["judges"] && judge_cache["judges"].IsSequence()) {
+				judge_cache_binaries_ = judge_cache["judges"].as<std::vector<std::string>>();
+			} // no throw... can be omitted
+		} // can be omitted... no throw
+
+		// load resource-sampling item
+		if (config["resource-sampling"] && config["resource-sampling"].IsMap()) {
+			auto &sampling = config["resource-sampling"];
+			if (sampling["interval"] && sampling["interval"].IsScalar()) {
+				sampling_interval_ = std::chrono::milliseconds(sampling["interval"].as<std::size_t>());
+			} // no throw... can be omitted
+			if (sampling["max-samples"] && sampling["max-samples"].IsScalar()) {
+				sampling_max_samples_ = sampling["max-samples"].as<std::size_t>();
+			} // no throw... can be omitted
+			if (sampling["cgroup-root"] && sampling["cgroup-root"].IsScalar()) {
+				sampling_cgroup_root_ = sampling["cgroup-root"].as<std::string>();
+			} // no throw... can be omitted
+		} // can be omitted... no throw
+
+		// load cpuset item
+		if (config["cpuset"] && config["cpuset"].IsMap()) {
+			auto &cpuset = config["cpuset"];
+			try {
+				if (cpuset["box-cpus"] && cpuset["box-cpus"].IsScalar()) {
+					box_cpus_ = helpers::parse_cpu_list(cpuset["box-cpus"].as<std::string>());
+				} // no throw... can be omitted
+				if (cpuset["box-mems"] && cpuset["box-mems"].IsScalar()) {
+					box_mems_ = helpers::parse_cpu_list(cpuset["box-mems"].as<std::string>());
+				} // no throw... can be omitted
+				if (cpuset["worker-cpus"] && cpuset["worker-cpus"].IsScalar()) {
+					worker_cpus_ = helpers::parse_cpu_list(cpuset["worker-cpus"].as<std::string>());
+				} // no throw... can be omitted
+			} catch (std::invalid_argument &e) {
+				throw config_error("Item cpuset not defined properly: " + std::string(e.what()));
+			}
+		} // can be omitted... no throw
+
 		// load worker-id
 		if (config["worker-id"] && config["worker-id"].IsScalar()) {
 			worker_id_ = config["worker-id"].as<std::size_t>();
@@ -61,6 +140,11 @@ worker_config::worker_config(const YAML::Node &config)
 			throw config_error("Item worker-id not defined properly");
 		}
 
+		// load spare-box-ids
+		if (config["spare-box-ids"] && config["spare-box-ids"].IsSequence()) {
+			spare_box_ids_ = config["spare-box-ids"].as<std::vector<std::size_t>>();
+		} // can be omitted... no throw
+
 		// load worker-description
 		if (config["worker-description"] && config["worker-description"].IsScalar()) {
 			worker_description_ = config["worker-description"].as<std::string>();
@@ -85,6 +169,27 @@ worker_config::worker_config(const YAML::Node &config)
 					if (fileman["password"] && fileman["password"].IsScalar()) {
 						fileman_conf.password = fileman["password"].as<std::string>();
 					} // no throw... can be omitted
+					if (fileman["retries"] && fileman["retries"].IsScalar()) {
+						fileman_conf.retries = fileman["retries"].as<std::size_t>();
+					} // no throw... can be omitted
+					if (fileman["retry-delay"] && fileman["retry-delay"].IsScalar()) {
+						fileman_conf.retry_delay = fileman["retry-delay"].as<std::size_t>();
+					} // no throw... can be omitted
+					if (fileman["low-speed-limit"] && fileman["low-speed-limit"].IsScalar()) {
+						fileman_conf.low_speed_limit = fileman["low-speed-limit"].as<std::size_t>();
+					} // no throw... can be omitted
+					if (fileman["low-speed-time"] && fileman["low-speed-time"].IsScalar()) {
+						fileman_conf.low_speed_time = fileman["low-speed-time"].as<std::size_t>();
+					} // no throw... can be omitted
+					if (fileman["compression"] && fileman["compression"].IsScalar()) {
+						fileman_conf.compression = fileman["compression"].as<bool>();
+					} // no throw... can be omitted
+					if (fileman["local-dir"] && fileman["local-dir"].IsScalar()) {
+						fileman_conf.local_dir = fileman["local-dir"].as<std::string>();
+					} // no throw... can be omitted
+					if (fileman["local-hardlink"] && fileman["local-hardlink"].IsScalar()) {
+						fileman_conf.local_hardlink = fileman["local-hardlink"].as<bool>();
+					} // no throw... can be omitted
 				} // no throw... can be omitted
 
 				filemans_configs_.push_back(fileman_conf);
@@ -93,6 +198,17 @@ worker_config::worker_config(const YAML::Node &config)
 			throw config_error("File managers not defined properly");
 		}
 
+		// load file-transfers
+		if (config["file-transfers"] && config["file-transfers"].IsMap()) {
+			auto &transfers = config["file-transfers"];
+			if (transfers["max-concurrent"] && transfers["max-concurrent"].IsScalar()) {
+				max_transfers_ = transfers["max-concurrent"].as<std::size_t>();
+			} // no throw... can be omitted
+			if (transfers["max-bandwidth"] && transfers["max-bandwidth"].IsScalar()) {
+				max_transfer_bandwidth_ = transfers["max-bandwidth"].as<std::size_t>();
+			} // no throw... can be omitted
+		} // can be omitted... no throw
+
 		// load logger
 		if (config["logger"] && config["logger"].IsMap()) {
 			if (config["logger"]["file"] && config["logger"]["file"].IsScalar()) {
@@ -111,6 +227,13 @@ worker_config::worker_config(const YAML::Node &config)
 			} // no throw... can be omitted
 		} // no throw... can be omitted
 
+		// load tracing
+		if (config["tracing"] && config["tracing"].IsMap()) {
+			if (config["tracing"]["file"] && config["tracing"]["file"].IsScalar()) {
+				trace_file_ = config["tracing"]["file"].as<std::string>();
+			} // no throw... can be omitted
+		} // no throw... can be omitted
+
 		// load limits
 		if (config["limits"] && config["limits"].IsMap()) {
 			auto limits = config["limits"];
@@ -195,6 +318,11 @@ size_t worker_config::get_worker_id() const
 	return worker_id_;
 }
 
+const std::vector<std::size_t> &worker_config::get_spare_box_ids() const
+{
+	return spare_box_ids_;
+}
+
 const std::string &worker_config::get_worker_description() const
 {
 	return worker_description_;
@@ -226,6 +354,11 @@ const log_config &worker_config::get_log_config() const
 	return log_config_;
 }
 
+const std::string &worker_config::get_trace_file() const
+{
+	return trace_file_;
+}
+
 const std::vector<fileman_config> &worker_config::get_filemans_configs() const
 {
 	return filemans_configs_;
@@ -241,6 +374,96 @@ const std::string &worker_config::get_cache_dir() const
 	return cache_dir_;
 }
 
+const std::string &worker_config::get_staging_dir() const
+{
+	return staging_dir_;
+}
+
+std::size_t worker_config::get_staging_job_budget() const
+{
+	return staging_job_budget_;
+}
+
+const std::string &worker_config::get_compilation_cache_dir() const
+{
+	return compilation_cache_dir_;
+}
+
+std::size_t worker_config::get_compilation_cache_max_size() const
+{
+	return compilation_cache_max_size_;
+}
+
+const std::vector<std::string> &worker_config::get_compilation_cache_toolchain() const
+{
+	return compilation_cache_toolchain_;
+}
+
+const std::string &worker_config::get_compilation_cache_toolchain_version() const
+{
+	return compilation_cache_toolchain_version_;
+}
+
+const std::string &worker_config::get_judge_cache_dir() const
+{
+	return judge_cache_dir_;
+}
+
+std::size_t worker_config::get_judge_cache_max_size() const
+{
+	return judge_cache_max_size_;
+}
+
+const std::vector<std::string> &worker_config::get_judge_cache_binaries() const
+{
+	return judge_cache_binaries_;
+}
+
+std::chrono::milliseconds worker_config::get_sampling_interval() const
+{
+	return sampling_interval_;
+}
+
+std::size_t worker_config::get_sampling_max_samples() const
+{
+	return sampling_max_samples_;
+}
+
+const std::string &worker_config::get_sampling_cgroup_root() const
+{
+	return sampling_cgroup_root_;
+}
+
+const std::vector<std::size_t> &worker_config::get_box_cpus() const
+{
+	return box_cpus_;
+}
+
+const std::vector<std::size_t> &worker_config::get_box_mems() const
+{
+	return box_mems_;
+}
+
+const std::vector<std::size_t> &worker_config::get_worker_cpus() const
+{
+	return worker_cpus_;
+}
+
+std::size_t worker_config::get_max_transfers() const
+{
+	return max_transfers_;
+}
+
+std::size_t worker_config::get_max_transfer_bandwidth() const
+{
+	return max_transfer_bandwidth_;
+}
+
+std::size_t worker_config::get_cache_warmup_threads() const
+{
+	return cache_warmup_threads_;
+}
+
 size_t worker_config::get_max_broker_liveness() const
 {
 	return max_broker_liveness_;
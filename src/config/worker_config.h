@@ -44,6 +44,12 @@ public:
 	 * @return integer which can be used also as identifier/index of sandbox
 	 */
 	virtual std::size_t get_worker_id() const;
+	/**
+	 * Get identifiers of additional isolate boxes of this worker, which are used to initialize the box of the next
+	 * task while the current one is running. They have to be unique at least in context of one machine.
+	 * @return list of box identifiers, empty if boxes are not initialized in advance
+	 */
+	virtual const std::vector<std::size_t> &get_spare_box_ids() const;
 	/**
 	 * Get worker human readable description (name), which will be shown in broker logs.
 	 * @return string with the description
@@ -89,16 +95,128 @@ public:
 	 */
 	virtual const std::string &get_cache_dir() const;
 
+	/**
+	 * Get maximal number of concurrent downloads of the cache warm-up.
+	 * @return number of threads, zero if the warm-up is disabled
+	 */
+	virtual std::size_t get_cache_warmup_threads() const;
+
+	/**
+	 * Get path to the directory on a RAM-backed filesystem where small jobs are evaluated.
+	 * @return textual representation of path, empty if the staging is disabled
+	 */
+	virtual const std::string &get_staging_dir() const;
+
+	/**
+	 * Get maximal size of input files of a job which is evaluated in the staging directory.
+	 * @return size in bytes
+	 */
+	virtual std::size_t get_staging_job_budget() const;
+
+	/**
+	 * Get path to the directory where results of initiation tasks are cached.
+	 * @return textual representation of path, empty if the cache is disabled
+	 */
+	virtual const std::string &get_compilation_cache_dir() const;
+
+	/**
+	 * Get maximal total size of the compilation cache.
+	 * @return size in bytes, zero means unlimited
+	 */
+	virtual std::size_t get_compilation_cache_max_size() const;
+
+	/**
+	 * Get files and directories of the toolchain outside the sandbox (compiler internals, system headers and
+	 * libraries, ...), which are a part of compilation cache keys.
+	 * @return list of paths
+	 */
+	virtual const std::vector<std::string> &get_compilation_cache_toolchain() const;
+
+	/**
+	 * Get version stamp of the toolchain, which is a part of compilation cache keys.
+	 * @return textual stamp, empty if not set
+	 */
+	virtual const std::string &get_compilation_cache_toolchain_version() const;
+
+	/**
+	 * Get path to the directory where verdicts of judges are cached.
+	 * @return textual representation of path, empty if the cache is disabled
+	 */
+	virtual const std::string &get_judge_cache_dir() const;
+
+	/**
+	 * Get maximal total size of the judge cache.
+	 * @return size in bytes, zero means unlimited
+	 */
+	virtual std::size_t get_judge_cache_max_size() const;
+
+	/**
+	 * Get file names of judge binaries whose verdicts may be cached.
+	 * @return constant reference to the list of names
+	 */
+	virtual const std::vector<std::string> &get_judge_cache_binaries() const;
+
+	/**
+	 * Get interval of sampling of resource usage of sandboxed programs.
+	 * @return interval, zero if the sampling is disabled
+	 */
+	virtual std::chrono::milliseconds get_sampling_interval() const;
+
+	/**
+	 * Get maximal number of resource usage samples of one run.
+	 * @return number of samples
+	 */
+	virtual std::size_t get_sampling_max_samples() const;
+
+	/**
+	 * Get directory of the cgroups of isolate boxes.
+	 * @return textual representation of path
+	 */
+	virtual const std::string &get_sampling_cgroup_root() const;
+
+	/**
+	 * Get CPUs to which sandboxed programs of this worker are restricted.
+	 * @return list of CPUs, empty if they are not restricted
+	 */
+	virtual const std::vector<std::size_t> &get_box_cpus() const;
+
+	/**
+	 * Get NUMA memory nodes to which memory of sandboxed programs of this worker is bound.
+	 * @return list of nodes, empty if it is not bound
+	 */
+	virtual const std::vector<std::size_t> &get_box_mems() const;
+
+	/**
+	 * Get CPUs to which the worker itself (all its threads) is restricted.
+	 * @return list of CPUs, empty if it is not restricted
+	 */
+	virtual const std::vector<std::size_t> &get_worker_cpus() const;
+
 	/**
 	 * Get wrapper for logger configuration.
 	 * @return constant reference to log_config structure
 	 */
 	virtual const log_config &get_log_config() const;
+	/**
+	 * Get path to the file with trace spans of jobs.
+	 * @return textual representation of path, empty if the tracing is disabled
+	 */
+	virtual const std::string &get_trace_file() const;
 	/**
 	 * Get wrapper for file manager configuration.
 	 * @return constant reference to fileman_config structure
 	 */
 	virtual const std::vector<fileman_config> &get_filemans_configs() const;
+	/**
+	 * Get maximal number of concurrent file transfers.
+	 * @return number of transfers, zero if unlimited
+	 */
+	virtual std::size_t get_max_transfers() const;
+	/**
+	 * Get maximal aggregate bandwidth of file transfers.
+	 * @return bytes per second, zero if unlimited
+	 */
+	virtual std::size_t get_max_transfer_bandwidth() const;
 	/**
 	 * Get default worker sandbox limits. Which will be used as defaults if not defined in job configuration.
 	 * @return non editable reference to sandbox_limits structure
@@ -126,6 +244,8 @@ public:
 private:
 	/** Unique worker number in context of one machine (0-100 preferably) */
 	std::size_t worker_id_ = 0;
+	/** Additional isolate boxes of this worker */
+	std::vector<std::size_t> spare_box_ids_ = {};
 	/** Human readable description of the worker for logging purposes */
 	std::string worker_description_ = "";
 	/** Working directory of whole worker used as base directory for all temporary files */
@@ -142,10 +262,49 @@ private:
 	std::chrono::milliseconds broker_ping_interval_ = std::chrono::milliseconds(1000);
 	/** The caching directory path */
 	std::string cache_dir_ = "";
+	/** Maximal number of concurrent downloads of the cache warm-up */
+	std::size_t cache_warmup_threads_ = 2;
+	/** Directory on a RAM-backed filesystem for small jobs, empty if the staging is disabled */
+	std::string staging_dir_ = "";
+	/** Maximal size of input files of a staged job in bytes */
+	std::size_t staging_job_budget_ = 64 * 1024 * 1024;
+	/** Directory of the compilation cache, empty if the cache is disabled */
+	std::string compilation_cache_dir_ = "";
+	/** Maximal total size of the compilation cache in bytes, zero means unlimited */
+	std::size_t compilation_cache_max_size_ = 1024 * 1024 * 1024;
+	/** Paths of the toolchain outside the sandbox, identified by metadata of their files in compilation cache keys */
+	std::vector<std::string> compilation_cache_toolchain_;
+	/** Version stamp of the toolchain in compilation cache keys */
+	std::string compilation_cache_toolchain_version_ = "";
+	/** Directory of the judge cache, empty if the cache is disabled */
+	std::string judge_cache_dir_ = "";
+	/** Maximal total size of the judge cache in bytes, zero means unlimited */
+	std::size_t judge_cache_max_size_ = 256 * 1024 * 1024;
+	/** Names of judge binaries which depend only on their arguments and the files given in them */
+	std::vector<std::string> judge_cache_binaries_ = {
+		"recodex-judge-normal", "recodex-judge-shuffle", "recodex-judge-passthrough", "recodex-token-judge"};
+	/** Interval of resource usage sampling, zero if the sampling is disabled */
+	std::chrono::milliseconds sampling_interval_ = std::chrono::milliseconds(0);
+	/** Maximal number of resource usage samples of one run */
+	std::size_t sampling_max_samples_ = 1000;
+	/** Directory containing cgroups of isolate boxes */
+	std::string sampling_cgroup_root_ = "/sys/fs/cgroup";
+	/** CPUs of sandboxed programs, empty if they are not restricted */
+	std::vector<std::size_t> box_cpus_ = {};
+	/** NUMA nodes of sandboxed programs, empty if they are not restricted */
+	std::vector<std::size_t> box_mems_ = {};
+	/** CPUs of the worker itself (housekeeping), empty if they are not restricted */
+	std::vector<std::size_t> worker_cpus_ = {};
 	/** Configuration of logger */
 	log_config log_config_ = {};
+	/** File with trace spans of jobs, empty if the tracing is disabled */
+	std::string trace_file_ = "";
 	/** Default configuration of file managers */
 	std::vector<fileman_config> filemans_configs_ = {};
+	/** Maximal number of concurrent file transfers, zero means unlimited */
+	std::size_t max_transfers_ = 0;
+	/** Maximal aggregate bandwidth of file transfers in bytes per second, zero means unlimited */
+	std::size_t max_transfer_bandwidth_ = 0;
 	/** Default sandbox limits */
 	sandbox_limits limits_ = {};
 	/** Maximal length of output from sandbox which can be written to the results file, in bytes. */
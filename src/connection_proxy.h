@@ -145,14 +145,14 @@ public:
 	}
 
 	/**
-	 * Receive data from the progress socket (sent by the job evaluator).
+	 * Pass a message from the progress socket (sent by the job evaluator) to the broker. Frames are moved between
+	 * the sockets, their content is not copied.
 	 * This method should only be called after a successful poll call (only poll measures elapsed time).
-	 * @param target where the received message should be stored
 	 * @param terminate set to true if the underlying ZeroMQ sockets can't receive messages anymore
 	 */
-	bool recv_progress(std::vector<std::string> &target, bool *terminate = nullptr)
+	bool forward_progress(bool *terminate = nullptr)
 	{
-		return helpers::recv_from_socket(progress_, target, terminate);
+		return helpers::forward_through_socket(progress_, broker_, terminate);
 	}
 };
 
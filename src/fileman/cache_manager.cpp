@@ -1,5 +1,55 @@
 #include "cache_manager.h"
 #include "helpers/string_utils.h"
+#include "helpers/filesystem.h"
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+
+namespace
+{
+	/**
+	 * Lock of a cached file implemented by flock() on a lock file. The lock is released
+	 * by the kernel even if the holding process dies, so it cannot be left stale.
+	 * The lock file is removed while the lock is still held, so lock files do not pile up
+	 * in the cache and the cleaner never finds an old one.
+	 */
+	class flock_file_lock : public file_lock
+	{
+	public:
+		flock_file_lock(int fd, const fs::path &path) : fd_(fd), path_(path)
+		{
+		}
+		~flock_file_lock() override
+		{
+			unlink(path_.c_str());
+			flock(fd_, LOCK_UN);
+			close(fd_);
+		}
+
+	private:
+		int fd_;
+		fs::path path_;
+	};
+
+	/**
+	 * Check whether the locked file descriptor still belongs to the lock file, which is not the case
+	 * if the previous holder removed the lock file while this process was waiting for the lock.
+	 */
+	bool is_current_lock_file(int fd, const fs::path &path)
+	{
+		struct stat fd_stat;
+		struct stat path_stat;
+		if (fstat(fd, &fd_stat) != 0 || stat(path.c_str(), &path_stat) != 0) { return false; }
+		return fd_stat.st_dev == path_stat.st_dev && fd_stat.st_ino == path_stat.st_ino;
+	}
+} // namespace
+#endif
 
 
 cache_manager::cache_manager(std::shared_ptr<spdlog::logger> logger)
@@ -37,13 +87,13 @@ void cache_manager::get_file(const std::string &src_name, const std::string &dst
 	}
 
 	try {
-		fs::copy_file(source_file, destination_file, fs::copy_options::overwrite_existing);
+		helpers::fast_copy_file(source_file, destination_file);
 		fs::permissions(fs::path(destination_file),
 			fs::perms::owner_write | fs::perms::group_write | fs::perms::others_write,
 			fs::perm_options::add);
 		// change last modification time of the file
 		fs::last_write_time(source_file, fs::file_time_type::clock::now());
-	} catch (fs::filesystem_error &e) {
+	} catch (std::exception &e) {
 		auto message = "Failed to copy file '" + source_file.string() + "' to '" + dst_path + "'. Error: " + e.what();
 		logger_->warn(message);
 		throw fm_exception(message);
@@ -66,16 +116,77 @@ void cache_manager::put_file(const std::string &src_name, const std::string &dst
 
 	try {
 		// first copy only temporary file
-		fs::copy_file(source_file, destination_temp_file, fs::copy_options::overwrite_existing);
+		helpers::fast_copy_file(source_file, destination_temp_file);
 		// and then move (atomically) the file to its original destination
 		fs::rename(destination_temp_file, destination_file);
-	} catch (fs::filesystem_error &e) {
+	} catch (std::exception &e) {
+		// do not leave partially written file behind
+		std::error_code ec;
+		fs::remove(destination_temp_file, ec);
+
 		auto message = "Failed to copy file " + src_name + " to cache. Error: " + e.what();
 		logger_->warn(message);
 		throw fm_exception(message);
 	}
 }
 
+std::unique_ptr<file_lock> cache_manager::lock_file(const std::string &name)
+{
+#ifndef _WIN32
+	fs::path lock_path = caching_dir_ / fs::path(name + ".lock").relative_path();
+
+	bool logged = false;
+	while (true) {
+		int fd = open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+		if (fd < 0) {
+			auto message = "Cannot open lock file " + lock_path.string() + ". Error: " + std::strerror(errno);
+			logger_->warn(message);
+			throw fm_exception(message);
+		}
+
+		// try it without waiting first, so that waiting for another process can be logged
+		int res = flock(fd, LOCK_EX | LOCK_NB);
+		if (res != 0 && errno == EWOULDBLOCK) {
+			if (!logged) { logger_->info("File {} is being fetched by another worker, waiting for it", name); }
+			logged = true;
+			while ((res = flock(fd, LOCK_EX)) != 0 && errno == EINTR) {}
+		}
+
+		if (res != 0) {
+			auto message = "Cannot lock file " + lock_path.string() + ". Error: " + std::strerror(errno);
+			close(fd);
+			logger_->warn(message);
+			throw fm_exception(message);
+		}
+
+		if (is_current_lock_file(fd, lock_path)) {
+			return std::unique_ptr<file_lock>(new flock_file_lock(fd, lock_path));
+		}
+
+		// the previous holder removed the lock file, the lock has to be taken on a new one
+		close(fd);
+	}
+#else
+	return nullptr;
+#endif
+}
+
+bool cache_manager::contains(const std::string &name) const
+{
+	std::error_code ec;
+	return fs::is_regular_file(caching_dir_ / fs::path(name).relative_path(), ec);
+}
+
+bool cache_manager::get_file_size(const std::string &name, std::uintmax_t &size)
+{
+	std::error_code ec;
+	auto file_size = fs::file_size(caching_dir_ / fs::path(name).relative_path(), ec);
+	if (ec) { return false; }
+
+	size = file_size;
+	return true;
+}
+
 std::string cache_manager::get_caching_dir() const
 {
 	return caching_dir_.string();
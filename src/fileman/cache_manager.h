@@ -15,7 +15,10 @@ namespace fs = std::filesystem;
  *
  * Cache is a directory inside host filesystem, where recently used files
  * are stored for some period of time. This directory could be the same for
- * more worker instances. Removing old files will do recodex-cleaner project.
+ * more worker instances, they coordinate through lock files placed next to
+ * the cached files (see @a lock_file). Files are stored under temporary names
+ * first and renamed atomically, so partially written file is never visible.
+ * Removing old files will do recodex-cleaner project.
  * Failed operations throws @a fm_exception exception.
  */
 class cache_manager : public file_manager_interface
@@ -49,6 +52,26 @@ public:
 	 * @param dst_name Name of the file in cache.
 	 */
 	void put_file(const std::string &src_name, const std::string &dst_name) override;
+	/**
+	 * Lock the file in cache exclusively for all worker processes which share the caching directory.
+	 * The lock is held on the file @a name with ".lock" suffix, which exists only while the lock is held.
+	 * @param name Name of the file in cache.
+	 * @return Lock of the file, @a nullptr on platforms without file locking support.
+	 */
+	std::unique_ptr<file_lock> lock_file(const std::string &name) override;
+	/**
+	 * Check whether the file is present in cache.
+	 * @param name Name of the file in cache.
+	 * @return True if the file is cached.
+	 */
+	bool contains(const std::string &name) const;
+	/**
+	 * Get size of the cached file.
+	 * @param name Name of the file in cache.
+	 * @param size Size of the file in bytes.
+	 * @return True if the file is cached.
+	 */
+	bool get_file_size(const std::string &name, std::uintmax_t &size) override;
 
 	/**
 	 * Get path to the directory where files are stored.
@@ -0,0 +1,170 @@
+#include "cache_warmer.h"
+#include "helpers/string_utils.h"
+
+
+cache_warmer::cache_warmer(std::shared_ptr<file_manager_interface> remote_fm,
+	std::shared_ptr<cache_manager> cache,
+	const fs::path &temp_dir,
+	std::size_t threads,
+	std::shared_ptr<spdlog::logger> logger)
+	: remote_fm_(remote_fm), cache_(cache), temp_dir_(temp_dir), logger_(logger)
+{
+	if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
+
+	if (threads == 0) { return; }
+
+	try {
+		fs::create_directories(temp_dir_);
+	} catch (fs::filesystem_error &e) {
+		auto message = "Cannot create directory " + temp_dir_.string() + ". Error: " + e.what();
+		logger_->warn(message);
+		throw fm_exception(message);
+	}
+
+	for (std::size_t i = 0; i < threads; ++i) { threads_.emplace_back(&cache_warmer::process_queue, this); }
+}
+
+cache_warmer::~cache_warmer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	queue_cv_.notify_all();
+
+	for (auto &thread : threads_) { thread.join(); }
+}
+
+void cache_warmer::warmup(const std::vector<std::string> &urls)
+{
+	if (threads_.empty()) {
+		logger_->warn("Cache warm-up is disabled, {} files are not prefetched", urls.size());
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (auto &url : urls) { enqueue(url, fs::path(url).filename().string()); }
+	}
+	queue_cv_.notify_all();
+}
+
+void cache_warmer::warmup(const job_metadata &job)
+{
+	if (threads_.empty()) {
+		logger_->warn("Cache warm-up is disabled, files of job {} are not prefetched", job.job_id);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (auto &task : job.tasks) {
+			if (task->binary != "fetch" || task->cmd_args.size() != 2) { continue; }
+
+			// the same naming as used by job_evaluator for the fetch tasks
+			enqueue(job.file_server_url + "/" + task->cmd_args[0], task->cmd_args[0]);
+		}
+	}
+	queue_cv_.notify_all();
+}
+
+void cache_warmer::enqueue(const std::string &url, const std::string &name)
+{
+	if (name.empty()) {
+		logger_->warn("Cannot prefetch {}, the URL does not name a file", url);
+		return;
+	}
+
+	if (!pending_.insert(url).second) { return; }
+	queue_.emplace_back(url, name);
+}
+
+void cache_warmer::pause()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	paused_ = true;
+}
+
+void cache_warmer::resume()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		paused_ = false;
+	}
+	queue_cv_.notify_all();
+}
+
+void cache_warmer::wait()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	idle_cv_.wait(lock, [this] { return stop_ || (queue_.empty() && active_ == 0); });
+}
+
+void cache_warmer::process_queue()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	while (true) {
+		queue_cv_.wait(lock, [this] { return stop_ || (!paused_ && !queue_.empty()); });
+		if (stop_) { break; }
+
+		auto item = queue_.front();
+		queue_.pop_front();
+		++active_;
+		lock.unlock();
+
+		bool downloaded = false;
+		bool failed = false;
+		try {
+			downloaded = prefetch(item.first, item.second);
+		} catch (std::exception &e) {
+			logger_->warn("Cache warm-up of {} failed: {}", item.first, e.what());
+			failed = true;
+		}
+
+		lock.lock();
+		--active_;
+		pending_.erase(item.first);
+		if (failed) {
+			++failed_;
+		} else if (downloaded) {
+			++downloaded_;
+		} else {
+			++cached_;
+		}
+
+		if (queue_.empty() && active_ == 0) {
+			logger_->info("Cache warm-up finished: {} files downloaded, {} already cached, {} failed",
+				downloaded_,
+				cached_,
+				failed_);
+			downloaded_ = cached_ = failed_ = 0;
+			idle_cv_.notify_all();
+		}
+	}
+}
+
+bool cache_warmer::prefetch(const std::string &url, const std::string &name)
+{
+	if (cache_->contains(name)) { return false; }
+
+	// another worker (or a running job) may be downloading the same file
+	auto file_lock = cache_->lock_file(name);
+	if (cache_->contains(name)) { return false; }
+
+	fs::path temp_file = temp_dir_ / (helpers::random_alphanum_string(20) + ".tmp");
+	logger_->debug("Prefetching file {} into cache", url);
+
+	try {
+		remote_fm_->get_file(url, temp_file.string());
+		cache_->put_file(temp_file.string(), name);
+	} catch (...) {
+		std::error_code ec;
+		fs::remove(temp_file, ec);
+		throw;
+	}
+
+	std::error_code ec;
+	fs::remove(temp_file, ec);
+	return true;
+}
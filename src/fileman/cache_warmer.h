@@ -0,0 +1,141 @@
+#ifndef RECODEX_WORKER_CACHE_WARMER_H
+#define RECODEX_WORKER_CACHE_WARMER_H
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "cache_manager.h"
+#include "config/job_metadata.h"
+#include "helpers/logger.h"
+
+namespace fs = std::filesystem;
+
+
+/**
+ * Prefetches files from the file server into the local cache in background.
+ *
+ * Files are given either by their full URLs (the name of the file in cache is the last segment of the URL) or by
+ * a job configuration (files of all its fetch tasks are cached under the same names the tasks look for). Requests
+ * are queued and processed by a fixed number of threads, the caller is never blocked by the downloads. Files already
+ * present in the cache are skipped and downloads hold the cache lock of the file, so a job which needs the file
+ * meanwhile waits for it instead of downloading it again. While a job is evaluated the warmer is paused (see @a pause), so no new download competes
+ * with the evaluation (a download which is already running is finished though).
+ */
+class cache_warmer
+{
+public:
+	/**
+	 * Constructor which starts the downloading threads.
+	 * @param remote_fm File manager which downloads files from their URLs.
+	 * @param cache Cache where downloaded files are stored.
+	 * @param temp_dir Directory for partially downloaded files, it is created if it does not exist.
+	 * @param threads Maximal number of concurrent downloads, zero disables the warm-up.
+	 * @param logger Shared pointer to system logger (optional).
+	 */
+	cache_warmer(std::shared_ptr<file_manager_interface> remote_fm,
+		std::shared_ptr<cache_manager> cache,
+		const fs::path &temp_dir,
+		std::size_t threads,
+		std::shared_ptr<spdlog::logger> logger = nullptr);
+
+	/**
+	 * Destructor, stops the threads. Queued files which were not downloaded yet are dropped.
+	 */
+	~cache_warmer();
+
+	cache_warmer(const cache_warmer &source) = delete;
+	cache_warmer &operator=(const cache_warmer &source) = delete;
+
+	/**
+	 * Queue files for downloading into the cache, returns immediately.
+	 * Files which are already queued or being downloaded are not queued again.
+	 * @param urls Full URLs of the files.
+	 */
+	void warmup(const std::vector<std::string> &urls);
+
+	/**
+	 * Queue all files fetched by given job for downloading into the cache, returns immediately.
+	 * @param job Metadata of the job.
+	 */
+	void warmup(const job_metadata &job);
+
+	/**
+	 * Do not start any new download until @a resume is called.
+	 */
+	void pause();
+
+	/**
+	 * Continue with queued downloads.
+	 */
+	void resume();
+
+	/**
+	 * Block until all queued files are processed.
+	 */
+	void wait();
+
+private:
+	/**
+	 * Queue one file (the mutex must be held).
+	 * @param url Full URL of the file.
+	 * @param name Name of the file in cache.
+	 */
+	void enqueue(const std::string &url, const std::string &name);
+
+	/**
+	 * Main loop of the downloading threads.
+	 */
+	void process_queue();
+
+	/**
+	 * Download one file into the cache unless it is already there.
+	 * @param url Full URL of the file.
+	 * @param name Name of the file in cache.
+	 * @return True if the file was downloaded, false if it was already cached.
+	 */
+	bool prefetch(const std::string &url, const std::string &name);
+
+	/** File manager which downloads the files. */
+	std::shared_ptr<file_manager_interface> remote_fm_;
+	/** Cache which is being warmed up. */
+	std::shared_ptr<cache_manager> cache_;
+	/** Directory for partially downloaded files. */
+	fs::path temp_dir_;
+	/** System or null logger. */
+	std::shared_ptr<spdlog::logger> logger_;
+
+	/** Guards all members below. */
+	std::mutex mutex_;
+	/** Signalled when there is something to do for the downloading threads. */
+	std::condition_variable queue_cv_;
+	/** Signalled when the queue gets empty and all threads are idle. */
+	std::condition_variable idle_cv_;
+	/** URLs waiting for download paired with names of the files in cache. */
+	std::deque<std::pair<std::string, std::string>> queue_;
+	/** URLs which are queued or being downloaded (to avoid duplicates). */
+	std::set<std::string> pending_;
+	/** Number of files being downloaded right now. */
+	std::size_t active_ = 0;
+	/** No new download is started when paused. */
+	bool paused_ = false;
+	/** Threads should terminate. */
+	bool stop_ = false;
+	/** Number of files downloaded since the queue was empty last time. */
+	std::size_t downloaded_ = 0;
+	/** Number of files found in the cache since the queue was empty last time. */
+	std::size_t cached_ = 0;
+	/** Number of failed downloads since the queue was empty last time. */
+	std::size_t failed_ = 0;
+
+	/** Downloading threads. */
+	std::vector<std::thread> threads_;
+};
+
+#endif // RECODEX_WORKER_CACHE_WARMER_H
@@ -1,4 +1,5 @@
 #include "fallback_file_manager.h"
+#include "helpers/trace.h"
 #include <memory>
 
 fallback_file_manager::fallback_file_manager(file_manager_ptr primary, file_manager_ptr secondary)
@@ -15,6 +16,19 @@ void fallback_file_manager::get_file(const std::string &src_name, const std::str
 	} catch (...) {
 	}
 
+	// only one holder of the lock fetches the file, the others wait and then take it from the primary manager
+	auto lock = primary_manager_->lock_file(src_name);
+	if (lock != nullptr) {
+		try {
+			primary_manager_->get_file(src_name, dst_name);
+			return;
+		} catch (...) {
+		}
+	}
+
+	// the span shows cache misses in the trace of the job
+	helpers::trace_span span("fetch_remote");
+	span.set("file", src_name);
 	secondary_manager_->get_file(src_name, dst_name);
 	primary_manager_->put_file(dst_name, src_name);
 }
@@ -40,6 +40,8 @@ public:
 	/**
 	 * Get file. If requested file is in cache, copy will be saved as @a dst_name immediately,
 	 * otherwise it'll be downloaded to cache first and copied to requested destination later.
+	 * Download is guarded by a lock of the primary manager, so concurrent requests for the same file
+	 * (even from other processes sharing the cache) download it only once.
 	 * @param src_name Name of requested file.
 	 * @param dst_name Path (with filename) where to save the file (actual path you want,
 	 *					caching is transparent from this point of view).
@@ -2,7 +2,23 @@
 #define RECODEX_WORKER_FILE_MANAGER_BASE_H
 
 #include <string>
+#include <memory>
 #include <exception>
+#include <cstdint>
+
+
+/**
+ * Exclusive lock of one file held through a file manager.
+ * The lock is released when the object is destroyed.
+ */
+class file_lock
+{
+public:
+	/**
+	 * Destructor (releases the lock).
+	 */
+	virtual ~file_lock() = default;
+};
 
 
 /**
@@ -32,6 +48,26 @@ public:
 	 * @param dst_path Where the file should be stored.
 	 */
 	virtual void put_file(const std::string &src_name, const std::string &dst_path) = 0;
+	/**
+	 * Lock the file exclusively, so that only one holder (possibly in another process) fetches
+	 * and puts it at a time. Blocks until the lock is acquired.
+	 * @param name Name of the file to be locked.
+	 * @return Lock of the file or @a nullptr if the manager does not support locking.
+	 */
+	virtual std::unique_ptr<file_lock> lock_file(const std::string &name)
+	{
+		return nullptr;
+	}
+	/**
+	 * Get size of the file without retrieving it (if the manager can tell it cheaply).
+	 * @param name Name of the file.
+	 * @param size Size of the file in bytes, set only if it is known.
+	 * @return True if the size is known.
+	 */
+	virtual bool get_file_size(const std::string &name, std::uintmax_t &size)
+	{
+		return false;
+	}
 };
 
 
@@ -3,6 +3,10 @@
 #include <curl/curl.h>
 #include <regex>
 #include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
 
 namespace fs = std::filesystem;
 
@@ -14,19 +18,216 @@ namespace fs = std::filesystem;
 namespace
 {
 
+	/**
+	 * State of an upload shared with the read callback.
+	 */
+	struct upload_state {
+		/** File which is uploaded. */
+		FILE *fd;
+		/** Transfer in the governor (if there is any). */
+		transfer_governor::transfer *transfer;
+	};
+
 	/* If you want run this program on Windows with libcurl as a
 	   DLL, you MUST also provide a read callback with CURLOPT_READFUNCTION.
 	   Failing to do so will give you a crash since a DLL may not use the
 	   variable's memory when passed in to it from an app like this. */
-	static std::size_t fread_wrapper(void *ptr, std::size_t size, std::size_t nmemb, FILE *stream)
+	std::size_t upload_read_callback(char *ptr, std::size_t size, std::size_t nmemb, void *userdata)
+	{
+		auto state = static_cast<upload_state *>(userdata);
+		std::size_t read = fread(ptr, size, nmemb, state->fd);
+		if (state->transfer != nullptr) { state->transfer->consume(read * size); }
+		return read;
+	}
+
+	/**
+	 * State of one (possibly resumed) download shared with the write callback.
+	 */
+	struct download_state {
+		/** File where the data are written. */
+		FILE *fd;
+		/** Path of the file. */
+		fs::path path;
+		/** Number of bytes already present in the file (start of the requested range). */
+		curl_off_t offset = 0;
+		/** Whether some data of current attempt were already received. */
+		bool received = false;
+		/** Total number of bytes which were not downloaded again thanks to resumed attempts. */
+		curl_off_t resumed = 0;
+		/** Transfer in the governor (if there is any). */
+		transfer_governor::transfer *transfer;
+
+		download_state(FILE *fd, const std::string &path, transfer_governor::transfer *transfer)
+			: fd(fd), path(path), transfer(transfer)
+		{
+		}
+
+		/**
+		 * Prepare the state for another attempt, which continues where the previous one ended.
+		 * @param restart If true, all data received so far are discarded and download starts from scratch.
+		 */
+		void prepare_retry(bool restart)
+		{
+			fflush(fd);
+			offset = restart ? 0 : (curl_off_t) ftell(fd);
+			if (offset <= 0) { truncate(); }
+			received = false;
+		}
+
+		/**
+		 * Discard all data written so far.
+		 */
+		void truncate()
+		{
+			offset = 0;
+			std::error_code ec;
+			fflush(fd);
+			fseek(fd, 0, SEEK_SET);
+			fs::resize_file(path, 0, ec);
+		}
+	};
+
+	// Write callback of downloads, written data are appended to the file
+	std::size_t download_write_callback(char *ptr, std::size_t size, std::size_t nmemb, void *userdata)
+	{
+		auto state = static_cast<download_state *>(userdata);
+		if (!state->received) {
+			// the data are coming, so the requested range was accepted by the server
+			state->received = true;
+			state->resumed += state->offset;
+		}
+		if (state->transfer != nullptr) { state->transfer->consume(size * nmemb); }
+		return fwrite(ptr, 1, size * nmemb, state->fd);
+	}
+
+	// Whether the failed transfer might succeed when tried again, resumed transfers sent a Range header
+	bool is_transient_error(CURLcode res, long response_code, bool resumed)
 	{
-		return fread(ptr, size, nmemb, stream);
+		switch (res) {
+		case CURLE_HTTP_RETURNED_ERROR:
+			// server errors, timeouts, rate limiting and unsatisfiable resumed range
+			return response_code >= 500 || response_code == 408 || response_code == 429 ||
+				(response_code == 416 && resumed);
+		case CURLE_RANGE_ERROR: // server does not support ranges, download is restarted
+			return resumed;
+		case CURLE_COULDNT_RESOLVE_HOST:
+		case CURLE_COULDNT_CONNECT:
+		case CURLE_OPERATION_TIMEDOUT:
+		case CURLE_PARTIAL_FILE:
+		case CURLE_SEND_ERROR:
+		case CURLE_RECV_ERROR:
+		case CURLE_GOT_NOTHING:
+		case CURLE_SSL_CONNECT_ERROR:
+		case CURLE_HTTP2:
+		case CURLE_HTTP2_STREAM:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Delay before given retry, exponential backoff with random jitter (from half to full delay)
+	std::chrono::milliseconds retry_delay(std::size_t base_delay, std::size_t attempt)
+	{
+		const std::size_t max_delay = 60000;
+		std::size_t delay = base_delay;
+		for (std::size_t i = 1; i < attempt && delay < max_delay; ++i) { delay *= 2; }
+		delay = std::min(delay, max_delay);
+
+		// downloads run concurrently (job and cache warm-up threads), each thread has its own generator
+		static thread_local std::mt19937 generator{std::random_device{}()};
+		std::uniform_int_distribution<std::size_t> jitter(delay / 2, delay);
+		return std::chrono::milliseconds(jitter(generator));
+	}
+
+	/**
+	 * Detection of stalled transfers, which does not count the time the transfer was held back by the governor.
+	 * Low speed limits of libcurl would abort throttled transfers (e.g., low priority ones waiting for high priority
+	 * transfers), which would be started again and waste the bandwidth the governor tries to save.
+	 */
+	struct stall_detector {
+		/** Minimal average speed in bytes per second. */
+		std::size_t limit = 0;
+		/** Length of the measured window of active (not throttled) time. */
+		std::chrono::steady_clock::duration time = std::chrono::steady_clock::duration::zero();
+		/** Transfer in the governor. */
+		const transfer_governor::transfer *transfer = nullptr;
+		/** Whether the last attempt was aborted as stalled. */
+		bool stalled = false;
+
+		/** Start of the current window. */
+		std::chrono::steady_clock::time_point window_start;
+		/** Bytes transferred before the window. */
+		curl_off_t window_bytes = 0;
+		/** Throttled time of the transfer before the window. */
+		std::chrono::milliseconds window_throttled = std::chrono::milliseconds::zero();
+
+		/**
+		 * Start measuring new attempt.
+		 */
+		void reset()
+		{
+			stalled = false;
+			window_start = std::chrono::steady_clock::now();
+			window_bytes = 0;
+			window_throttled = transfer->get_throttled();
+		}
+
+		/**
+		 * Check the speed of the transfer.
+		 * @param bytes Number of bytes transferred in the current attempt.
+		 * @return False if the transfer is stalled.
+		 */
+		bool check(curl_off_t bytes)
+		{
+			auto now = std::chrono::steady_clock::now();
+			auto throttled = transfer->get_throttled();
+			if ((now - window_start) - (throttled - window_throttled) < time) { return true; }
+
+			// the whole window was active, so the data had to come at the minimal speed
+			auto seconds = std::chrono::duration<double>(time).count();
+			if ((double) (bytes - window_bytes) < limit * seconds) {
+				stalled = true;
+				return false;
+			}
+
+			window_start = now;
+			window_bytes = bytes;
+			window_throttled = throttled;
+			return true;
+		}
+	};
+
+	// Progress callback of governed transfers, aborts stalled ones
+	int stall_callback(void *userdata, curl_off_t, curl_off_t dlnow, curl_off_t, curl_off_t ulnow)
+	{
+		auto detector = static_cast<stall_detector *>(userdata);
+		return detector->check(dlnow + ulnow) ? 0 : 1;
+	}
+
+	// Abort transfers which are too slow for too long (stalled connections)
+	void set_low_speed_limits(CURL *curl, const fileman_config &config, stall_detector &detector)
+	{
+		if (config.low_speed_time == 0) { return; }
+
+		if (detector.transfer == nullptr) {
+			curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, (long) config.low_speed_limit);
+			curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, (long) config.low_speed_time);
+			return;
+		}
+
+		detector.limit = config.low_speed_limit;
+		detector.time = std::chrono::seconds(config.low_speed_time);
+		detector.reset();
+		curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, stall_callback);
+		curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &detector);
+		curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
 	}
 
-	// And the same for writing ...
-	static std::size_t fwrite_wrapper(void *ptr, std::size_t size, std::size_t nmemb, FILE *stream)
+	// Result of the transfer as if it was checked by libcurl (stalled transfers are timeouts)
+	CURLcode transfer_result(CURLcode res, const stall_detector &detector)
 	{
-		return fwrite(ptr, size, nmemb, stream);
+		return (res == CURLE_ABORTED_BY_CALLBACK && detector.stalled) ? CURLE_OPERATION_TIMEDOUT : res;
 	}
 
 	// Nothing write callback
@@ -43,12 +244,16 @@ namespace
 #endif
 
 
-http_manager::http_manager(std::shared_ptr<spdlog::logger> logger) : logger_(logger)
+http_manager::http_manager(std::shared_ptr<spdlog::logger> logger)
+	: logger_(logger), governor_(nullptr), priority_(transfer_priority::HIGH)
 {
 }
 
-http_manager::http_manager(const std::vector<fileman_config> &configs, std::shared_ptr<spdlog::logger> logger)
-	: configs_(configs), logger_(logger)
+http_manager::http_manager(const std::vector<fileman_config> &configs,
+	std::shared_ptr<spdlog::logger> logger,
+	std::shared_ptr<transfer_governor> governor,
+	transfer_priority priority)
+	: configs_(configs), logger_(logger), governor_(governor), priority_(priority)
 {
 	if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
 }
@@ -65,15 +270,24 @@ void http_manager::get_file(const std::string &src_name, const std::string &dst_
 		throw fm_exception(message);
 	}
 
+	// Servers without explicit configuration get the default retry and timeout settings
+	fileman_config default_config;
+	auto config = find_config(src_name);
+	const fileman_config &transfer_config = (config != nullptr) ? *config : default_config;
+
 	std::unique_ptr<CURL, decltype(&curl_easy_cleanup)> curl = {curl_easy_init(), curl_easy_cleanup};
 	if (curl.get()) {
 		// Destination URL
 		curl_easy_setopt(curl.get(), CURLOPT_URL, (src_name).c_str());
 
+		// Wait for a free slot, the data are throttled in the write callback then
+		auto transfer = start_transfer();
+
 		// Set where to write data to
-		curl_easy_setopt(curl.get(), CURLOPT_WRITEDATA, fd.get());
-		// Use custom write function (because of Windows DLL issue)
-		curl_easy_setopt(curl.get(), CURLOPT_READFUNCTION, fwrite_wrapper);
+		download_state state(fd.get(), dst_name, transfer.get());
+		curl_easy_setopt(curl.get(), CURLOPT_WRITEDATA, &state);
+		// Use custom write function (because of Windows DLL issue and resumed downloads)
+		curl_easy_setopt(curl.get(), CURLOPT_WRITEFUNCTION, download_write_callback);
 
 #ifdef _WIN32 // Windows needs to have explicitly defined certificate bundle
 		curl_easy_setopt(curl.get(), CURLOPT_CAINFO, "curl-ca-bundle.crt");
@@ -88,10 +302,14 @@ void http_manager::get_file(const std::string &src_name, const std::string &dst_
 		curl_easy_setopt(curl.get(), CURLOPT_SSL_VERIFYHOST, 2L);
 		// Throw exception on HTTP responses >= 400
 		curl_easy_setopt(curl.get(), CURLOPT_FAILONERROR, 1L);
+		// Abort stalled transfers (they are retried then)
+		stall_detector stall;
+		stall.transfer = transfer.get();
+		set_low_speed_limits(curl.get(), transfer_config, stall);
+		// Negotiate compressed transfer (all encodings supported by libcurl), data are decoded on the fly
+		if (transfer_config.compression) { curl_easy_setopt(curl.get(), CURLOPT_ACCEPT_ENCODING, ""); }
 
 		// Set HTTP authentication
-		auto config = find_config(src_name);
-
 		if (config != nullptr) {
 			curl_easy_setopt(curl.get(), CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
 			curl_easy_setopt(curl.get(), CURLOPT_USERPWD, (config->username + ":" + config->password).c_str());
@@ -100,22 +318,78 @@ void http_manager::get_file(const std::string &src_name, const std::string &dst_
 		// Enable verbose for easier tracing
 		// curl_easy_setopt(curl.get(), CURLOPT_VERBOSE, 1L);
 
-		CURLcode res = curl_easy_perform(curl.get());
+		CURLcode res;
+		long response_code;
+		std::size_t attempt = 0;
+		while (true) {
+			// Continue from the end of partially downloaded file (if there is any)
+			curl_easy_setopt(curl.get(), CURLOPT_RESUME_FROM_LARGE, state.offset);
+
+			if (stall.transfer != nullptr) { stall.reset(); }
+			res = transfer_result(curl_easy_perform(curl.get()), stall);
+			response_code = 0;
+			curl_easy_getinfo(curl.get(), CURLINFO_RESPONSE_CODE, &response_code);
+
+			if (res == CURLE_OK || attempt >= transfer_config.retries ||
+				!is_transient_error(res, response_code, state.offset > 0)) {
+				break;
+			}
+
+			// Keep the data received so far, the next attempt asks only for the rest of the file
+			state.prepare_retry(res == CURLE_RANGE_ERROR || (res == CURLE_HTTP_RETURNED_ERROR && response_code == 416));
+			// Range of encoded content does not match decoded data in the file, so resumed parts are not compressed
+			if (state.offset > 0) { curl_easy_setopt(curl.get(), CURLOPT_ACCEPT_ENCODING, nullptr); }
+
+			++attempt;
+			auto delay = retry_delay(transfer_config.retry_delay, attempt);
+			logger_->warn("Download of {} failed (({}) {}), retry {} of {} in {} ms from byte {}",
+				src_name,
+				response_code,
+				curl_easy_strerror(res),
+				attempt,
+				transfer_config.retries,
+				delay.count(),
+				(long long) state.offset);
+			std::this_thread::sleep_for(delay);
+		}
 
 		// Check for errors
 		if (res != CURLE_OK) {
+			fd.reset();
 			try {
 				fs::remove(dst_name);
 			} catch (...) {
 			}
-			long response_code;
-			curl_easy_getinfo(curl.get(), CURLINFO_RESPONSE_CODE, &response_code);
 			auto error_message = "Failed to download " + src_name + " to " + dst_name + ". Error: (" +
 				std::to_string(response_code) + ") " + curl_easy_strerror(res);
+			if (attempt > 0) { error_message += " (after " + std::to_string(attempt) + " retries)"; }
 			logger_->warn(error_message);
 			throw fm_exception(error_message);
 		}
 
+		curl_off_t transferred = 0;
+		curl_easy_getinfo(curl.get(), CURLINFO_SIZE_DOWNLOAD_T, &transferred);
+		logger_->debug("File {} downloaded, {} bytes transferred ({} bytes written)",
+			src_name,
+			(long long) transferred,
+			(long long) ftell(fd.get()));
+
+		log_throttling(transfer.get(), src_name);
+
+		if (attempt > 0) {
+			logger_->info("File {} downloaded after {} retries, {} bytes were resumed instead of downloaded again",
+				src_name,
+				attempt,
+				(long long) state.resumed);
+		}
+
+		// make sure all data are written before the file is used
+		if (fflush(fd.get()) != 0) {
+			auto message = "Failed to write downloaded file " + dst_name + ".";
+			logger_->warn(message);
+			throw fm_exception(message);
+		}
+
 		// set write permissions to downloaded file
 		try {
 			fs::permissions(fs::path(dst_name),
@@ -154,10 +428,14 @@ void http_manager::put_file(const std::string &src_name, const std::string &dst_
 		// Upload mode
 		curl_easy_setopt(curl.get(), CURLOPT_UPLOAD, 1L);
 
+		// Wait for a free slot, the data are throttled in the read callback then
+		auto transfer = start_transfer();
+
 		// Set where to read data from
-		curl_easy_setopt(curl.get(), CURLOPT_READDATA, fd.get());
-		// Use custom read function (because of Windows DLL issue)
-		curl_easy_setopt(curl.get(), CURLOPT_READFUNCTION, fread_wrapper);
+		upload_state state = {fd.get(), transfer.get()};
+		curl_easy_setopt(curl.get(), CURLOPT_READDATA, &state);
+		// Use custom read function (because of Windows DLL issue and throttling)
+		curl_easy_setopt(curl.get(), CURLOPT_READFUNCTION, upload_read_callback);
 
 		// Drop output - the page after put request
 		curl_easy_setopt(curl.get(), CURLOPT_WRITEFUNCTION, write_callback);
@@ -182,6 +460,11 @@ void http_manager::put_file(const std::string &src_name, const std::string &dst_
 		// Set HTTP authentication
 		auto config = find_config(dst_url);
 
+		// Abort stalled transfers
+		stall_detector stall;
+		stall.transfer = transfer.get();
+		set_low_speed_limits(curl.get(), (config != nullptr) ? *config : fileman_config(), stall);
+
 		if (config != nullptr) {
 			curl_easy_setopt(curl.get(), CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
 			curl_easy_setopt(curl.get(), CURLOPT_USERPWD, (config->username + ":" + config->password).c_str());
@@ -190,7 +473,7 @@ void http_manager::put_file(const std::string &src_name, const std::string &dst_
 		// Enable verbose for easier tracing
 		// curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
 
-		CURLcode res = curl_easy_perform(curl.get());
+		CURLcode res = transfer_result(curl_easy_perform(curl.get()), stall);
 
 		// Check for errors
 		if (res != CURLE_OK) {
@@ -201,6 +484,8 @@ void http_manager::put_file(const std::string &src_name, const std::string &dst_
 			logger_->warn(message);
 			throw fm_exception(message);
 		}
+
+		log_throttling(transfer.get(), src_name);
 	}
 }
 
@@ -212,3 +497,23 @@ const fileman_config *http_manager::find_config(const std::string &url) const
 
 	return nullptr;
 }
+
+std::unique_ptr<transfer_governor::transfer> http_manager::start_transfer() const
+{
+	if (governor_ == nullptr) { return nullptr; }
+	return governor_->start(priority_);
+}
+
+void http_manager::log_throttling(const transfer_governor::transfer *transfer, const std::string &name) const
+{
+	if (transfer == nullptr) { return; }
+
+	auto queued = transfer->get_queued().count();
+	auto throttled = transfer->get_throttled().count();
+	if (queued > 0 || throttled > 0) {
+		logger_->info("Transfer of {} waited {} ms for a free slot and was throttled for {} ms",
+			name,
+			(long long) queued,
+			(long long) throttled);
+	}
+}
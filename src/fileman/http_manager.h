@@ -6,6 +6,7 @@
 #include "file_manager_interface.h"
 #include "helpers/logger.h"
 #include "config/fileman_config.h"
+#include "transfer_governor.h"
 
 
 /**
@@ -14,7 +15,7 @@
  * the abilities. We are supporting SSL connections with peer and host verification
  * and HTTP/2 protocol with fallback to 1.1 version. Also, HTTP authentication
  * is used when right configs are provided. HTTP status codes above 400 are
- * interpreted as strict error.
+ * interpreted as strict error. Transfers can be limited by a @ref transfer_governor.
  * Failed operations throws @ref fm_exception exception.
  */
 class http_manager : public file_manager_interface
@@ -29,8 +30,13 @@ public:
 	 * Constructor with initialization.
 	 * @param configs File server configurations
 	 * @param logger Shared pointer to system logger (optional).
+	 * @param governor Limits of concurrent transfers and bandwidth shared with other managers (optional).
+	 * @param priority Priority class of transfers made by this manager.
 	 */
-	http_manager(const std::vector<fileman_config> &configs, std::shared_ptr<spdlog::logger> logger = nullptr);
+	http_manager(const std::vector<fileman_config> &configs,
+		std::shared_ptr<spdlog::logger> logger = nullptr,
+		std::shared_ptr<transfer_governor> governor = nullptr,
+		transfer_priority priority = transfer_priority::HIGH);
 	/**
 	 * Destructor.
 	 */
@@ -60,11 +66,28 @@ protected:
 	 */
 	const fileman_config *find_config(const std::string &url) const;
 
+	/**
+	 * Start a transfer in the governor (if there is any).
+	 * @return Handle of the transfer or @a nullptr.
+	 */
+	std::unique_ptr<transfer_governor::transfer> start_transfer() const;
+
+	/**
+	 * Log the time the transfer was delayed by the governor.
+	 * @param transfer Handle of the transfer (may be @a nullptr).
+	 * @param name Name of the transferred file.
+	 */
+	void log_throttling(const transfer_governor::transfer *transfer, const std::string &name) const;
+
 private:
 	/** Credentials for each server HTTP Auth. */
 	const std::vector<fileman_config> configs_;
 	/** System or null logger. */
 	std::shared_ptr<spdlog::logger> logger_;
+	/** Limits of transfers, @a nullptr if there are none. */
+	std::shared_ptr<transfer_governor> governor_;
+	/** Priority class of transfers of this manager. */
+	transfer_priority priority_;
 };
 
 #endif // RECODEX_WORKER_HTTP_MANAGER_H
@@ -0,0 +1,145 @@
+#include "local_file_manager.h"
+#include "helpers/string_utils.h"
+#include "helpers/filesystem.h"
+#include <vector>
+
+
+namespace
+{
+	const std::string file_scheme = "file://";
+
+	/**
+	 * Check whether the URL has "file://" scheme.
+	 */
+	bool is_file_url(const std::string &url)
+	{
+		return url.compare(0, file_scheme.size(), file_scheme) == 0;
+	}
+
+	/**
+	 * Remove the host of a "file://" URL, only local host makes sense (empty or "localhost").
+	 * Other URLs are returned unchanged.
+	 */
+	std::string strip_file_host(const std::string &url)
+	{
+		if (!is_file_url(url)) { return url; }
+
+		auto path_start = url.find('/', file_scheme.size());
+		auto host_end = path_start == std::string::npos ? url.size() : path_start;
+		auto host = url.substr(file_scheme.size(), host_end - file_scheme.size());
+		if (!host.empty() && host != "localhost") {
+			throw fm_exception("URL " + url + " refers to a file on another host");
+		}
+		return file_scheme + url.substr(host_end);
+	}
+} // namespace
+
+
+local_file_manager::local_file_manager(const std::vector<fileman_config> &configs,
+	std::shared_ptr<file_manager_interface> remote_fm,
+	std::shared_ptr<spdlog::logger> logger)
+	: configs_(configs), remote_fm_(remote_fm), logger_(logger)
+{
+	if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
+
+	// prefixes of local files are compared without the host
+	for (auto &config : configs_) { config.remote_url = strip_file_host(config.remote_url); }
+}
+
+void local_file_manager::get_file(const std::string &src_name, const std::string &dst_name)
+{
+	bool hardlink = false;
+	fs::path src_path = find_path(src_name, hardlink);
+	if (src_path.empty()) {
+		if (remote_fm_ == nullptr) { throw fm_exception("File " + src_name + " is not accessible"); }
+		remote_fm_->get_file(src_name, dst_name);
+		return;
+	}
+
+	logger_->debug("Copying local file {} to {}", src_path.string(), dst_name);
+
+	std::error_code ec;
+	if (!fs::is_regular_file(src_path, ec)) {
+		auto message = "File " + src_name + " not found (" + src_path.string() + ")";
+		logger_->warn(message);
+		throw fm_exception(message);
+	}
+
+	try {
+		auto method = helpers::fast_copy_file(src_path, dst_name, true, hardlink);
+		if (method != helpers::copy_method::HARDLINK) {
+			if (hardlink) { logger_->debug("Cannot create hard link of {}, it was copied", src_path.string()); }
+			// copies can be modified by the job even if the local files are read-only
+			fs::permissions(dst_name, fs::perms::owner_write, fs::perm_options::add);
+		}
+	} catch (std::exception &e) {
+		auto message = "Failed to copy file " + src_path.string() + " to " + dst_name + ". Error: " + e.what();
+		logger_->warn(message);
+		throw fm_exception(message);
+	}
+}
+
+void local_file_manager::put_file(const std::string &src_name, const std::string &dst_url)
+{
+	bool hardlink = false;
+	fs::path dst_path = find_path(dst_url, hardlink);
+	if (dst_path.empty()) {
+		if (remote_fm_ == nullptr) { throw fm_exception("Destination " + dst_url + " is not accessible"); }
+		remote_fm_->put_file(src_name, dst_url);
+		return;
+	}
+
+	logger_->debug("Copying file {} to local file {}", src_name, dst_path.string());
+
+	// temporary file in the same directory, so it can be renamed atomically
+	fs::path temp_path = dst_path;
+	temp_path += "-" + helpers::random_alphanum_string(20) + ".tmp";
+
+	try {
+		// directories are created only behind HTTP addresses, "file://" destinations have to exist already
+		if (!is_file_url(dst_url)) {
+			fs::create_directories(dst_path.parent_path());
+		}
+		helpers::fast_copy_file(src_name, temp_path);
+		fs::rename(temp_path, dst_path);
+	} catch (std::exception &e) {
+		std::error_code ec;
+		fs::remove(temp_path, ec);
+
+		auto message = "Failed to copy file " + src_name + " to " + dst_path.string() + ". Error: " + e.what();
+		logger_->warn(message);
+		throw fm_exception(message);
+	}
+}
+
+fs::path local_file_manager::find_path(const std::string &url, bool &hardlink) const
+{
+	hardlink = false;
+
+	// "file://" URLs are served only from local directories of configured servers, never from anywhere else
+	bool file_url = is_file_url(url);
+	std::string local_url = strip_file_host(url);
+
+	// the same lookup as in http_manager, the first matching server wins
+	for (const auto &config : configs_) {
+		const std::string &prefix = config.remote_url;
+		if (prefix.empty() || local_url.compare(0, prefix.size(), prefix) != 0) { continue; }
+		if (local_url.size() > prefix.size() && local_url[prefix.size()] != '/' && prefix.back() != '/') { continue; }
+		if (config.local_dir.empty()) {
+			if (file_url) { throw fm_exception("URL " + url + " is not served from a local directory"); }
+			return fs::path();
+		}
+
+		// the file must not escape the local directory
+		fs::path relative = fs::path(local_url.substr(prefix.size())).relative_path().lexically_normal();
+		if (relative.empty() || *relative.begin() == "..") {
+			throw fm_exception("URL " + url + " points outside of the file server directory");
+		}
+
+		hardlink = config.local_hardlink;
+		return fs::path(config.local_dir) / relative;
+	}
+
+	if (file_url) { throw fm_exception("URL " + url + " does not belong to any configured file server"); }
+	return fs::path();
+}
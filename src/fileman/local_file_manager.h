@@ -0,0 +1,75 @@
+#ifndef RECODEX_WORKER_LOCAL_FILE_MANAGER_H
+#define RECODEX_WORKER_LOCAL_FILE_MANAGER_H
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <filesystem>
+#include "file_manager_interface.h"
+#include "helpers/logger.h"
+#include "config/fileman_config.h"
+
+namespace fs = std::filesystem;
+
+
+/**
+ * File manager for file servers which storage is accessible directly from the worker host (local directory or
+ * network mount). URLs starting with the address of a file server with configured @a local_dir are served from the
+ * filesystem, all other requests are passed to another (HTTP) manager. "file://" URLs are allowed only under
+ * a file server address with "file://" scheme (e.g., "file:///srv/recodex") which has @a local_dir, the host part
+ * of such URLs has to be empty or "localhost".
+ *
+ * Files are delivered as hard links (only if enabled for the file server), reflinks, by copy_file_range() (in kernel
+ * or even server side copy) or by ordinary copy, whichever works first. Uploaded files are written under temporary
+ * names and renamed atomically, so partially written file is never visible on the server.
+ * Failed operations throws @a fm_exception exception.
+ */
+class local_file_manager : public file_manager_interface
+{
+public:
+	/**
+	 * Constructor with initialization.
+	 * @param configs File server configurations, only those with @a local_dir are used.
+	 * @param remote_fm File manager for all other URLs (optional, such URLs are not accessible without it).
+	 * @param logger Shared pointer to system logger (optional).
+	 */
+	local_file_manager(const std::vector<fileman_config> &configs,
+		std::shared_ptr<file_manager_interface> remote_fm = nullptr,
+		std::shared_ptr<spdlog::logger> logger = nullptr);
+	/**
+	 * Destructor.
+	 */
+	~local_file_manager() override = default;
+
+	/**
+	 * Get a copy of the file.
+	 * @param src_name URL of the file.
+	 * @param dst_name Path to the created file.
+	 */
+	void get_file(const std::string &src_name, const std::string &dst_name) override;
+	/**
+	 * Store the file on the server.
+	 * @param src_name Path to the file to upload.
+	 * @param dst_url URL where the file will be stored.
+	 */
+	void put_file(const std::string &src_name, const std::string &dst_url) override;
+
+private:
+	/**
+	 * Translate URL to a local path.
+	 * @param url URL of a file.
+	 * @param hardlink Set to true if the file may be delivered as a hard link.
+	 * @return Path to the file or empty path if the URL is not served locally.
+	 * @throws fm_exception if the URL points outside of the file server directory or to a file on another host.
+	 */
+	fs::path find_path(const std::string &url, bool &hardlink) const;
+
+	/** File server configurations with local directories. */
+	std::vector<fileman_config> configs_;
+	/** Manager for URLs which are not local. */
+	std::shared_ptr<file_manager_interface> remote_fm_;
+	/** System or null logger. */
+	std::shared_ptr<spdlog::logger> logger_;
+};
+
+#endif // RECODEX_WORKER_LOCAL_FILE_MANAGER_H
@@ -0,0 +1,104 @@
+#include "transfer_governor.h"
+#include <algorithm>
+
+using clock_type = std::chrono::steady_clock;
+
+
+transfer_governor::transfer::transfer(
+	transfer_governor &governor, transfer_priority priority, clock_type::duration queued)
+	: governor_(governor), priority_(priority), queued_(queued)
+{
+}
+
+transfer_governor::transfer::~transfer()
+{
+	governor_.finish();
+}
+
+void transfer_governor::transfer::consume(std::size_t bytes)
+{
+	throttled_ += governor_.consume(bytes, priority_);
+}
+
+std::chrono::milliseconds transfer_governor::transfer::get_queued() const
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(queued_);
+}
+
+std::chrono::milliseconds transfer_governor::transfer::get_throttled() const
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(throttled_);
+}
+
+
+transfer_governor::transfer_governor(std::size_t max_transfers, std::size_t max_bandwidth)
+	: max_transfers_(max_transfers), max_bandwidth_(max_bandwidth), tokens_((double) max_bandwidth),
+	  refilled_(clock_type::now())
+{
+}
+
+std::unique_ptr<transfer_governor::transfer> transfer_governor::start(transfer_priority priority)
+{
+	auto begin = clock_type::now();
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	if (max_transfers_ > 0) {
+		bool high = (priority == transfer_priority::HIGH);
+		if (high) { ++high_queued_; }
+		slot_cv_.wait(lock, [&] { return active_ < max_transfers_ && (high || high_queued_ == 0); });
+		if (high) {
+			--high_queued_;
+			// low priority transfers might be waiting only for this one
+			slot_cv_.notify_all();
+		}
+	}
+
+	++active_;
+	return std::unique_ptr<transfer>(new transfer(*this, priority, clock_type::now() - begin));
+}
+
+void transfer_governor::finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		--active_;
+	}
+	slot_cv_.notify_all();
+}
+
+clock_type::duration transfer_governor::consume(std::size_t bytes, transfer_priority priority)
+{
+	if (max_bandwidth_ == 0 || bytes == 0) { return clock_type::duration::zero(); }
+
+	auto begin = clock_type::now();
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	bool high = (priority == transfer_priority::HIGH);
+	if (high) { ++high_throttled_; }
+
+	while (true) {
+		// refill the bucket, at most one second worth of data can be accumulated
+		auto now = clock_type::now();
+		double elapsed = std::chrono::duration<double>(now - refilled_).count();
+		tokens_ = std::min((double) max_bandwidth_, tokens_ + elapsed * max_bandwidth_);
+		refilled_ = now;
+
+		bool turn = high || high_throttled_ == 0;
+		if (turn && tokens_ > 0) { break; }
+
+		// wait until the debt is paid (or until a high priority transfer is served)
+		double missing = std::max(1.0 - tokens_, (double) std::min(bytes, max_bandwidth_));
+		auto wait = std::chrono::duration<double>(missing / max_bandwidth_);
+		bandwidth_cv_.wait_for(lock, std::chrono::duration_cast<clock_type::duration>(wait));
+	}
+
+	// data are already transferred, so the tokens may get below zero (next transfers wait for them)
+	tokens_ -= (double) bytes;
+
+	if (high) {
+		--high_throttled_;
+		bandwidth_cv_.notify_all();
+	}
+
+	return clock_type::now() - begin;
+}
@@ -0,0 +1,129 @@
+#ifndef RECODEX_WORKER_TRANSFER_GOVERNOR_H
+#define RECODEX_WORKER_TRANSFER_GOVERNOR_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+
+/**
+ * Priority class of a file transfer.
+ */
+enum class transfer_priority {
+	/** Transfers of evaluated jobs (submission downloads, result uploads). */
+	HIGH,
+	/** Background transfers (cache warm-up), they get only what high priority transfers leave. */
+	LOW
+};
+
+
+/**
+ * Limits file transfers of the worker - number of concurrent transfers and their aggregate bandwidth.
+ *
+ * Every transfer has to be started by @a start, which waits for a free slot, and it reports all transferred data
+ * through @a transfer::consume, which waits while the bandwidth is exhausted (token bucket with one second burst).
+ * Waiting high priority transfers are always served before low priority ones. Limits apply to one worker process,
+ * so they should be set to the share of the host uplink which belongs to this worker.
+ *
+ * Priorities are not inherited: a high priority transfer which waits for a file locked in the cache by a low priority
+ * one (cache warm-up) is delayed by the throttled low priority transfer. Time spent in @a transfer::consume is
+ * reported by @a transfer::get_throttled, so that stall detection of the transfers can skip it.
+ */
+class transfer_governor
+{
+public:
+	/**
+	 * One running transfer, the slot is released when the object is destroyed.
+	 */
+	class transfer
+	{
+	public:
+		~transfer();
+		transfer(const transfer &source) = delete;
+		transfer &operator=(const transfer &source) = delete;
+
+		/**
+		 * Account transferred data, blocks if the bandwidth limit was reached.
+		 * @param bytes Number of transferred bytes.
+		 */
+		void consume(std::size_t bytes);
+
+		/**
+		 * Get the time spent waiting for a free slot.
+		 */
+		std::chrono::milliseconds get_queued() const;
+
+		/**
+		 * Get the time spent waiting because of the bandwidth limit.
+		 */
+		std::chrono::milliseconds get_throttled() const;
+
+	private:
+		friend class transfer_governor;
+		transfer(transfer_governor &governor, transfer_priority priority, std::chrono::steady_clock::duration queued);
+
+		/** Governor of this transfer. */
+		transfer_governor &governor_;
+		/** Priority class of this transfer. */
+		transfer_priority priority_;
+		/** Time spent waiting for a free slot. */
+		std::chrono::steady_clock::duration queued_;
+		/** Time spent waiting because of the bandwidth limit. */
+		std::chrono::steady_clock::duration throttled_ = std::chrono::steady_clock::duration::zero();
+	};
+
+	/**
+	 * Constructor.
+	 * @param max_transfers Maximal number of concurrent transfers, zero means unlimited.
+	 * @param max_bandwidth Maximal aggregate bandwidth of all transfers in bytes per second, zero means unlimited.
+	 */
+	transfer_governor(std::size_t max_transfers = 0, std::size_t max_bandwidth = 0);
+
+	transfer_governor(const transfer_governor &source) = delete;
+	transfer_governor &operator=(const transfer_governor &source) = delete;
+
+	/**
+	 * Start a new transfer, blocks until there is a free slot.
+	 * @param priority Priority class of the transfer.
+	 * @return Handle of the transfer which must not outlive the governor.
+	 */
+	std::unique_ptr<transfer> start(transfer_priority priority);
+
+private:
+	/**
+	 * Release a slot of finished transfer.
+	 */
+	void finish();
+
+	/**
+	 * Take tokens for transferred data, blocks while there are not any.
+	 * @return Time spent waiting.
+	 */
+	std::chrono::steady_clock::duration consume(std::size_t bytes, transfer_priority priority);
+
+	/** Maximal number of concurrent transfers (zero = unlimited). */
+	const std::size_t max_transfers_;
+	/** Maximal aggregate bandwidth in bytes per second (zero = unlimited). */
+	const std::size_t max_bandwidth_;
+
+	/** Guards all members below. */
+	std::mutex mutex_;
+	/** Signalled when a slot is released or waiting high priority transfer gets its slot. */
+	std::condition_variable slot_cv_;
+	/** Signalled when waiting high priority transfer gets its tokens. */
+	std::condition_variable bandwidth_cv_;
+	/** Number of running transfers. */
+	std::size_t active_ = 0;
+	/** Number of high priority transfers waiting for a slot. */
+	std::size_t high_queued_ = 0;
+	/** Number of high priority transfers waiting for tokens. */
+	std::size_t high_throttled_ = 0;
+	/** Available bytes, negative when the last transfer took more than there was. */
+	double tokens_;
+	/** Time of the last refill of tokens. */
+	std::chrono::steady_clock::time_point refilled_;
+};
+
+#endif // RECODEX_WORKER_TRANSFER_GOVERNOR_H
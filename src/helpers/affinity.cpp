@@ -0,0 +1,139 @@
+#include "affinity.h"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	/** Memory policy of set_mempolicy(2), numaif.h of libnuma is not required */
+	const int mpol_bind = 2;
+
+	/** Affinity of the process before it was restricted, valid if @a original_cpus_saved is set */
+	cpu_set_t original_cpus;
+	/** Whether @a original_cpus is saved, set once on start of the worker (before any fork) */
+	bool original_cpus_saved = false;
+
+	bool fill_cpu_set(const std::vector<std::size_t> &cpus, cpu_set_t &set)
+	{
+		CPU_ZERO(&set);
+		for (auto cpu : cpus) {
+			if (cpu >= CPU_SETSIZE) { return false; }
+			CPU_SET(cpu, &set);
+		}
+		return true;
+	}
+} // namespace
+#endif
+
+
+std::vector<std::size_t> helpers::parse_cpu_list(const std::string &list)
+{
+	std::vector<std::size_t> result;
+	std::size_t begin = 0;
+
+	while (begin < list.size()) {
+		std::size_t end = list.find(',', begin);
+		if (end == std::string::npos) { end = list.size(); }
+		std::string item = list.substr(begin, end - begin);
+		item.erase(std::remove_if(item.begin(), item.end(), ::isspace), item.end());
+
+		std::size_t dash = item.find('-');
+		std::string first = item.substr(0, dash);
+		std::string last = dash == std::string::npos ? first : item.substr(dash + 1);
+		if (first.empty() || last.empty() || first.find_first_not_of("0123456789") != std::string::npos ||
+			last.find_first_not_of("0123456789") != std::string::npos) {
+			throw std::invalid_argument("Malformed item '" + item + "' of CPU list '" + list + "'");
+		}
+
+		std::size_t from = std::stoul(first);
+		std::size_t to = std::stoul(last);
+		if (from > to) { throw std::invalid_argument("Reversed range '" + item + "' of CPU list '" + list + "'"); }
+		for (std::size_t i = from; i <= to; ++i) { result.push_back(i); }
+
+		begin = end + 1;
+	}
+	if (!list.empty() && begin == list.size()) {
+		throw std::invalid_argument("Trailing comma in CPU list '" + list + "'");
+	}
+
+	std::sort(result.begin(), result.end());
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+	return result;
+}
+
+bool helpers::set_process_cpu_affinity(const std::vector<std::size_t> &cpus)
+{
+	if (cpus.empty()) { return true; }
+
+#ifndef _WIN32
+	cpu_set_t set;
+	if (!fill_cpu_set(cpus, set)) { return false; }
+	if (!original_cpus_saved) {
+		original_cpus_saved = sched_getaffinity(0, sizeof(original_cpus), &original_cpus) == 0;
+	}
+
+	// sched_setaffinity affects only one thread, threads which already exist (e.g. of zmq) are set one by one
+	std::error_code ec;
+	bool result = true;
+	for (auto &task : fs::directory_iterator("/proc/self/task", ec)) {
+		pid_t tid = 0;
+		try {
+			tid = (pid_t) std::stol(task.path().filename().string());
+		} catch (std::exception &) {
+			continue;
+		}
+		if (sched_setaffinity(tid, sizeof(set), &set) != 0) { result = false; }
+	}
+	if (ec) { return sched_setaffinity(0, sizeof(set), &set) == 0; }
+	return result;
+#else
+	return false;
+#endif
+}
+
+bool helpers::set_thread_cpu_affinity(const std::vector<std::size_t> &cpus)
+{
+	if (cpus.empty()) { return reset_thread_cpu_affinity(); }
+
+#ifndef _WIN32
+	cpu_set_t set;
+	if (!fill_cpu_set(cpus, set)) { return false; }
+	return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+	return false;
+#endif
+}
+
+bool helpers::reset_thread_cpu_affinity()
+{
+#ifndef _WIN32
+	if (!original_cpus_saved) { return true; }
+	return sched_setaffinity(0, sizeof(original_cpus), &original_cpus) == 0;
+#else
+	return true;
+#endif
+}
+
+bool helpers::set_thread_memory_nodes(const std::vector<std::size_t> &nodes)
+{
+	if (nodes.empty()) { return true; }
+
+#ifndef _WIN32
+	const std::size_t bits = 8 * sizeof(unsigned long);
+	std::vector<unsigned long> mask(*std::max_element(nodes.begin(), nodes.end()) / bits + 1, 0);
+	for (auto node : nodes) { mask[node / bits] |= 1ul << (node % bits); }
+
+	// the kernel reads one bit less than the given number of nodes
+	return syscall(SYS_set_mempolicy, mpol_bind, mask.data(), mask.size() * bits + 1) == 0;
+#else
+	return false;
+#endif
+}
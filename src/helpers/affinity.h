@@ -0,0 +1,50 @@
+#ifndef RECODEX_WORKER_HELPERS_AFFINITY_H
+#define RECODEX_WORKER_HELPERS_AFFINITY_H
+
+#include <string>
+#include <vector>
+
+namespace helpers
+{
+	/**
+	 * Parse list of CPUs or memory nodes in the format of cpusets, e.g. "0-3,8,10-11".
+	 * @param list textual list, empty string gives an empty list
+	 * @return sorted list of numbers without duplicates
+	 * @throws std::invalid_argument if the list is malformed
+	 */
+	std::vector<std::size_t> parse_cpu_list(const std::string &list);
+
+	/**
+	 * Restrict all threads of the current process (and processes and threads started afterwards) to given CPUs.
+	 * The affinity which the process had before the first call is kept for @ref reset_thread_cpu_affinity.
+	 * @param cpus list of CPUs, nothing happens if it is empty
+	 * @return false if the affinity cannot be set (e.g. the CPUs do not exist), always false on Windows (unless the list is empty)
+	 */
+	bool set_process_cpu_affinity(const std::vector<std::size_t> &cpus);
+
+	/**
+	 * Restrict the calling thread (and processes started by it afterwards) to given CPUs. It is safe to be called
+	 * in a forked child.
+	 * @param cpus list of CPUs, the thread is reset by @ref reset_thread_cpu_affinity if it is empty
+	 * @return false if the affinity cannot be set, always false on Windows (unless the list is empty)
+	 */
+	bool set_thread_cpu_affinity(const std::vector<std::size_t> &cpus);
+
+	/**
+	 * Give the calling thread the affinity which the process had before @ref set_process_cpu_affinity restricted it,
+	 * so that processes started by the thread do not run on the CPUs reserved for the worker. Nothing happens if the
+	 * affinity of the process was not changed. It is safe to be called in a forked child.
+	 * @return false if the affinity cannot be set
+	 */
+	bool reset_thread_cpu_affinity();
+
+	/**
+	 * Bind memory allocations of the calling thread (and processes started by it afterwards) to given NUMA nodes.
+	 * @param nodes list of memory nodes, nothing happens if it is empty
+	 * @return false if the policy cannot be set, always false on Windows (unless the list is empty)
+	 */
+	bool set_thread_memory_nodes(const std::vector<std::size_t> &nodes);
+} // namespace helpers
+
+
+#endif // RECODEX_WORKER_HELPERS_AFFINITY_H
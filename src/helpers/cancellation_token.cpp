@@ -0,0 +1,73 @@
+#include "cancellation_token.h"
+#include <algorithm>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/types.h>
+#endif
+
+void helpers::cancellation_token::start(const std::string &job_id)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	current_job_ = job_id;
+	pid_ = 0;
+}
+
+void helpers::cancellation_token::finish()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = std::find(cancelled_jobs_.begin(), cancelled_jobs_.end(), current_job_);
+	if (it != cancelled_jobs_.end()) { cancelled_jobs_.erase(it); }
+	current_job_.clear();
+	pid_ = 0;
+}
+
+bool helpers::cancellation_token::cancel(const std::string &job_id)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (std::find(cancelled_jobs_.begin(), cancelled_jobs_.end(), job_id) == cancelled_jobs_.end()) {
+		cancelled_jobs_.push_back(job_id);
+		if (cancelled_jobs_.size() > max_pending_cancellations) { cancelled_jobs_.pop_front(); }
+	}
+	if (current_job_.empty() || current_job_ != job_id) { return false; }
+
+	kill_process();
+	return true;
+}
+
+bool helpers::cancellation_token::is_cancelled() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return current_cancelled();
+}
+
+bool helpers::cancellation_token::attach_process(int pid)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	pid_ = pid;
+	if (!current_cancelled()) { return true; }
+
+	kill_process();
+	return false;
+}
+
+void helpers::cancellation_token::detach_process()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	pid_ = 0;
+}
+
+void helpers::cancellation_token::kill_process()
+{
+#ifndef _WIN32
+	// isolate cleans up the box when it is terminated
+	if (pid_ > 0) { kill(pid_, SIGTERM); }
+#endif
+	pid_ = 0;
+}
+
+bool helpers::cancellation_token::current_cancelled() const
+{
+	return !current_job_.empty() &&
+		std::find(cancelled_jobs_.begin(), cancelled_jobs_.end(), current_job_) != cancelled_jobs_.end();
+}
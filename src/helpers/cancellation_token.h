@@ -0,0 +1,79 @@
+#ifndef RECODEX_WORKER_HELPERS_CANCELLATION_TOKEN_H
+#define RECODEX_WORKER_HELPERS_CANCELLATION_TOKEN_H
+
+#include <deque>
+#include <mutex>
+#include <string>
+
+namespace helpers
+{
+	/**
+	 * Cancellation of the job which is being evaluated, shared by the thread receiving commands from the broker and
+	 * the thread evaluating jobs.
+	 *
+	 * Cancellations are bound to job identifiers, so a request which arrives before the evaluation of the job starts
+	 * (or after it ends) does not affect other jobs. Identifiers of the jobs cancelled before their start are kept
+	 * until the jobs are evaluated, only the most recent @ref max_pending_cancellations of them. The sandbox attaches
+	 * its running process, which is terminated as soon as the job is cancelled.
+	 */
+	class cancellation_token
+	{
+	public:
+		/** Maximal number of remembered cancellations of jobs which are not evaluated yet. */
+		static const std::size_t max_pending_cancellations = 32;
+
+		/**
+		 * Start evaluation of a job.
+		 * @param job_id identifier of the job
+		 */
+		void start(const std::string &job_id);
+
+		/**
+		 * End evaluation of the current job, its cancellation is forgotten.
+		 */
+		void finish();
+
+		/**
+		 * Cancel a job. The attached process is terminated if the job is being evaluated.
+		 * @param job_id identifier of the job
+		 * @return true if the job is being evaluated
+		 */
+		bool cancel(const std::string &job_id);
+
+		/**
+		 * Check whether the current job was cancelled.
+		 * @return true if the job should stop
+		 */
+		bool is_cancelled() const;
+
+		/**
+		 * Attach the process which is running for the current job. It is terminated (SIGTERM) right away if the job
+		 * is cancelled already.
+		 * @param pid identifier of the process
+		 * @return false if the job is cancelled already
+		 */
+		bool attach_process(int pid);
+
+		/**
+		 * Detach the process attached before, it is not terminated anymore.
+		 */
+		void detach_process();
+
+	private:
+		/** Terminate the attached process, the mutex has to be locked. */
+		void kill_process();
+		/** Check whether the current job is among the cancelled ones, the mutex has to be locked. */
+		bool current_cancelled() const;
+
+		/** Protects all members */
+		mutable std::mutex mutex_;
+		/** Identifier of the job being evaluated, empty if there is none */
+		std::string current_job_;
+		/** Identifiers of the cancelled jobs, the oldest first */
+		std::deque<std::string> cancelled_jobs_;
+		/** Process running for the current job, zero if there is none */
+		int pid_ = 0;
+	};
+} // namespace helpers
+
+#endif // RECODEX_WORKER_HELPERS_CANCELLATION_TOKEN_H
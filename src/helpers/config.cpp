@@ -190,6 +190,9 @@ std::shared_ptr<job_metadata> helpers::build_job_metadata(const YAML::Node &conf
 				if (ctask["sandbox"]["working-directory"] && ctask["sandbox"]["working-directory"].IsScalar()) {
 					sandbox->working_directory = ctask["sandbox"]["working-directory"].as<std::string>();
 				} // can be ommited... no throw
+				if (ctask["sandbox"]["outputs"] && ctask["sandbox"]["outputs"].IsSequence()) {
+					sandbox->outputs = ctask["sandbox"]["outputs"].as<std::vector<std::string>>();
+				} // can be ommited... no throw
 
 				// load limits... if they are supplied
 				if (ctask["sandbox"]["limits"]) {
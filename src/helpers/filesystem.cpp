@@ -1,95 +1,534 @@
 #include "filesystem.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
 
-/**
- * Try to find matching hardlink in hardlinks map. If src is found in the map, dest is filled with corresponding file.
- * @param hardlinks the hardlinks map (src -> dst)
- * @param src source path being looked up in hardlinks using equvalent func
- * @param dest output arg which is filled in case of success
- * @return true if the hardlink match is found
- */
-bool find_matching_hardlink(std::map<fs::path, fs::path> &hardlinks, const fs::path &src, fs::path &dest)
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <linux/fs.h>
+#endif
+
+namespace
 {
-	for (auto& [s, d] : hardlinks) {
-		if (fs::equivalent(s, src)) { // both paths point to the same data on the disk (same hardlinks)
-			dest = d;
-			return true;
+	/** Numbers of files copied by each method, indexed by helpers::copy_method */
+	std::array<std::atomic<std::size_t>, 4> copy_counts = {};
+
+	void count_copy(helpers::copy_method method)
+	{
+		++copy_counts[static_cast<std::size_t>(method)];
+	}
+
+#ifdef __linux__
+	/**
+	 * Descriptor which is closed when going out of scope.
+	 */
+	class scoped_fd
+	{
+	public:
+		explicit scoped_fd(int fd) : fd(fd)
+		{
+		}
+		~scoped_fd()
+		{
+			if (fd >= 0) { close(fd); }
+		}
+		scoped_fd(const scoped_fd &) = delete;
+		scoped_fd &operator=(const scoped_fd &) = delete;
+
+		/**
+		 * Close the descriptor explicitly (errors of delayed writes are reported by close).
+		 * @return result of close()
+		 */
+		int close_fd()
+		{
+			int res = close(fd);
+			fd = -1;
+			return res;
 		}
+
+		int fd;
+	};
+
+	std::error_code last_error()
+	{
+		return std::error_code(errno, std::generic_category());
 	}
-	return false;
-}
 
-void copy_diretory_internal(const fs::path &src, const fs::path &dest, bool skip_symlinks, std::map<fs::path, fs::path> &hardlinks)
+	/**
+	 * Copy data between two descriptors in kernel. On filesystems which support it the data are copied on the server
+	 * side (NFS 4.2), so they do not have to go through the worker at all.
+	 * @return false if the kernel cannot copy these files (nothing was copied then)
+	 */
+	bool copy_in_kernel(int in, int out, std::uintmax_t max_length, std::uintmax_t &copied, std::error_code &ec)
+	{
+		while (copied < max_length) {
+			auto chunk = static_cast<std::size_t>(std::min<std::uintmax_t>(max_length - copied, 1 << 30));
+			ssize_t res = copy_file_range(in, nullptr, out, nullptr, chunk, 0);
+			if (res < 0 && errno == EINTR) { continue; }
+			if (res < 0 && copied == 0 &&
+				(errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+				return false;
+			}
+			if (res < 0) {
+				ec = last_error();
+				break;
+			}
+			if (res == 0) { break; } // end of the file
+			copied += res;
+		}
+		return true;
+	}
+
+	/**
+	 * Copy data between two descriptors by sendfile, used when copy_file_range cannot copy across filesystems. The
+	 * data are not passed through the worker, but they are read and written by the local kernel.
+	 * @return false if the kernel cannot send these files (nothing was copied then)
+	 */
+	bool send_in_kernel(int in, int out, std::uintmax_t max_length, std::uintmax_t &copied, std::error_code &ec)
+	{
+		while (copied < max_length) {
+			auto chunk = static_cast<std::size_t>(std::min<std::uintmax_t>(max_length - copied, 1 << 30));
+			ssize_t res = sendfile(out, in, nullptr, chunk);
+			if (res < 0 && errno == EINTR) { continue; }
+			if (res < 0 && copied == 0 && (errno == ENOSYS || errno == EINVAL)) { return false; }
+			if (res < 0) {
+				ec = last_error();
+				break;
+			}
+			if (res == 0) { break; } // end of the file
+			copied += res;
+		}
+		return true;
+	}
+
+	/**
+	 * Copy data between two descriptors through a buffer.
+	 */
+	void copy_by_buffer(int in, int out, std::uintmax_t max_length, std::uintmax_t &copied, std::error_code &ec)
+	{
+		std::vector<char> buffer(1 << 17);
+		while (copied < max_length) {
+			auto chunk = static_cast<std::size_t>(std::min<std::uintmax_t>(max_length - copied, buffer.size()));
+			ssize_t res = read(in, buffer.data(), chunk);
+			if (res < 0 && errno == EINTR) { continue; }
+			if (res < 0) {
+				ec = last_error();
+				return;
+			}
+			if (res == 0) { break; }
+
+			for (ssize_t written = 0; written < res;) {
+				ssize_t w = write(out, buffer.data() + written, (std::size_t) (res - written));
+				if (w < 0 && errno == EINTR) { continue; }
+				if (w < 0) {
+					ec = last_error();
+					return;
+				}
+				written += w;
+			}
+			copied += res;
+		}
+	}
+
+	/**
+	 * Copy at most @a max_length bytes between two descriptors by the cheapest method.
+	 * @param size size of the input file
+	 */
+	helpers::copy_method copy_data(
+		int in, int out, std::uintmax_t size, std::uintmax_t max_length, std::uintmax_t &copied, std::error_code &ec)
+	{
+		copied = 0;
+#ifdef FICLONE
+		if (size <= max_length && ioctl(out, FICLONE, in) == 0) {
+			copied = size;
+			return helpers::copy_method::REFLINK;
+		}
+#endif
+		if (copy_in_kernel(in, out, max_length, copied, ec)) { return helpers::copy_method::KERNEL; }
+		if (send_in_kernel(in, out, max_length, copied, ec)) { return helpers::copy_method::KERNEL; }
+		copy_by_buffer(in, out, max_length, copied, ec);
+		return helpers::copy_method::BUFFER;
+	}
+#endif
+} // namespace
+
+namespace
 {
-	try {
+	/** Identity of a file on the disk (device and inode) */
+	using file_id = std::pair<std::uintmax_t, std::uintmax_t>;
+
+	/** Trees with fewer files are copied by the calling thread only */
+	const std::size_t parallel_copy_threshold = 64;
+	/** Maximal number of threads copying one tree */
+	const std::size_t max_copy_threads = 4;
+
+	/**
+	 * Find out whether a file has more hard links (a single lstat).
+	 * @param path the file
+	 * @param id filled with identity of the file if it has more hard links
+	 * @return false if the file is a symlink or it has only one link
+	 */
+	bool get_hardlinked_id(const fs::path &path, file_id &id)
+	{
+#ifndef _WIN32
+		struct stat st;
+		if (lstat(path.c_str(), &st) != 0) {
+			throw fs::filesystem_error("lstat", path, std::error_code(errno, std::generic_category()));
+		}
+		if (S_ISLNK(st.st_mode) || st.st_nlink <= 1) { return false; }
+		id = file_id(st.st_dev, st.st_ino);
+		return true;
+#else
+		// the identity is not available through std::filesystem, hard links are copied as separate files
+		(void) path;
+		(void) id;
+		return false;
+#endif
+	}
+
+	/**
+	 * Walk through the source tree, create directories in the destination and collect files to be copied.
+	 * @param hardlinks destinations of already collected files with more hard links, by their identity
+	 * @param copies pairs of source and destination files to be copied
+	 * @param links pairs of existing destination files (copied before) and their new hard links
+	 */
+	void collect_directory(const fs::path &src,
+		const fs::path &dest,
+		bool skip_symlinks,
+		std::map<file_id, fs::path> &hardlinks,
+		std::vector<std::pair<fs::path, fs::path>> &copies,
+		std::vector<std::pair<fs::path, fs::path>> &links)
+	{
 		// routine checks
 		if (!fs::exists(src)) {
 			throw helpers::filesystem_exception(
 				"helpers::copy_directory: Source directory does not exist '" + src.string() + "'");
 		}
 
-		if (skip_symlinks && fs::is_symlink(src)) {
-			return;
-		}
-		
+		if (skip_symlinks && fs::is_symlink(src)) { return; }
+
 		if (!fs::is_directory(fs::symlink_status(src))) {
 			throw helpers::filesystem_exception(
 				"helpers::copy_directory: Source directory is not a directory '" + src.string() + "'");
 		}
-		
+
 		if (!fs::exists(dest) && !fs::create_directories(dest)) {
 			throw helpers::filesystem_exception(
 				"helpers::copy_directory: Destination directory cannot be created '" + dest.string() + "'");
 		}
 
-		// proceed with copying
-		fs::directory_iterator endit;
-		for (fs::directory_iterator it(src); it != endit; ++it) {
-			auto srcPath = it->path();
-			auto destPath = dest / it->path().filename();
+		for (auto &entry : fs::directory_iterator(src)) {
+			auto src_path = entry.path();
+			auto dest_path = dest / src_path.filename();
+			auto status = entry.symlink_status();
+
+			if (skip_symlinks && fs::is_symlink(status)) { continue; }
 
-			if (skip_symlinks && fs::is_symlink(srcPath)) {
+			if (fs::is_directory(status)) {
+				collect_directory(src_path, dest_path, skip_symlinks, hardlinks, copies, links);
 				continue;
 			}
 
-			if (fs::is_directory(it->symlink_status())) {
-				copy_diretory_internal(srcPath, destPath, skip_symlinks, hardlinks);
-			} else {
-				// a file may be either copied or hardlinked
-				if (!fs::is_symlink(srcPath) && fs::hard_link_count(srcPath) > 1) {
-					fs::path destPathHardlink;
-					if (find_matching_hardlink(hardlinks, it->path(), destPathHardlink)) {
-						// another file refering to the same data already exists in dest directory
-						fs::create_hard_link(destPathHardlink, destPath);
-						continue; // move to next file, hardlink replaced copying
-					} else {
-						// this is the first time we encoutered this data, lets register them in hardlinks map
-						hardlinks.emplace(std::make_pair(it->path(), destPath));
-					}
+			// a file may be either copied or hardlinked
+			file_id id;
+			if (get_hardlinked_id(src_path, id)) {
+				auto it = hardlinks.find(id);
+				if (it != hardlinks.end()) {
+					// another file refering to the same data will exist in dest directory
+					links.emplace_back(it->second, dest_path);
+					continue;
 				}
-
-				// no hardlink created, lets proceed with copying
-				fs::copy(it->path(), destPath);
+				// this is the first time we encoutered this data, lets register them in hardlinks map
+				hardlinks.emplace(id, dest_path);
 			}
+
+			copies.emplace_back(src_path, dest_path);
 		}
-	} catch (fs::filesystem_error &e) {
-		throw helpers::filesystem_exception("helpers::copy_directory: Error in copying directories: " + std::string(e.what()));
 	}
 
-	return;
-}
+	/**
+	 * Copy a file which is not a directory.
+	 */
+	void copy_entry(const fs::path &src, const fs::path &dest)
+	{
+		if (fs::is_regular_file(src)) {
+			helpers::fast_copy_file(src, dest, false);
+		} else {
+			fs::copy(src, dest);
+		}
+	}
+
+	/**
+	 * Copy files, large sets of them by several threads.
+	 * @param copies pairs of source and destination files
+	 * @throws the first error which occurred, remaining files are not copied then
+	 */
+	void copy_entries(const std::vector<std::pair<fs::path, fs::path>> &copies)
+	{
+		std::size_t threads = 1;
+		if (copies.size() >= parallel_copy_threshold) {
+			threads = std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u), max_copy_threads);
+		}
+
+		std::atomic<std::size_t> next(0);
+		std::exception_ptr error;
+		std::mutex error_mutex;
+		auto copy_loop = [&]() {
+			for (std::size_t i = next++; i < copies.size(); i = next++) {
+				try {
+					copy_entry(copies[i].first, copies[i].second);
+				} catch (...) {
+					std::lock_guard<std::mutex> lock(error_mutex);
+					if (!error) { error = std::current_exception(); }
+					next = copies.size();
+				}
+			}
+		};
+
+		std::vector<std::thread> pool;
+		for (std::size_t i = 1; i < threads; ++i) {
+			try {
+				pool.emplace_back(copy_loop);
+			} catch (std::system_error &) {
+				break; // the threads we have will do
+			}
+		}
+		copy_loop();
+		for (auto &thread : pool) { thread.join(); }
+
+		if (error) { std::rethrow_exception(error); }
+	}
+} // namespace
 
 void helpers::copy_directory(const fs::path &src, const fs::path &dest, bool skip_symlinks)
 {
 	/*
 	 * Hardlinks map provide mapping between files in src and dest which have been harlinked.
-	 * Everytime a file with > 1 hardlink count is copied from src to dest, it is registered here.
-	 * When files with > 1 hardlinks are encountered, this map is searched and if match is found
+	 * Everytime a file with > 1 hardlink count is copied from src to dest, it is registered here under
+	 * its device and inode. When files with > 1 hardlinks are encountered, this map is searched and if match is found
 	 * the new file is hardlinked inside dest instead of coping it from src.
 	 */
-	std::map<fs::path, fs::path> hardlinks;
-	::copy_diretory_internal(src, dest, skip_symlinks, hardlinks);
+	std::map<file_id, fs::path> hardlinks;
+	std::vector<std::pair<fs::path, fs::path>> copies;
+	std::vector<std::pair<fs::path, fs::path>> links;
+
+	try {
+		// the tree is walked first, then files are copied (possibly in parallel) and finally hard links are created
+		::collect_directory(src, dest, skip_symlinks, hardlinks, copies, links);
+		::copy_entries(copies);
+		for (auto &[target, link] : links) { fs::create_hard_link(target, link); }
+	} catch (fs::filesystem_error &e) {
+		throw helpers::filesystem_exception(
+			"helpers::copy_directory: Error in copying directories: " + std::string(e.what()));
+	}
+}
+
+std::uintmax_t helpers::directory_size(const fs::path &dir)
+{
+	std::uintmax_t size = 0;
+	try {
+		if (!fs::exists(dir)) { return 0; }
+
+		for (auto &entry : fs::recursive_directory_iterator(dir)) {
+			if (entry.is_symlink() || !entry.is_regular_file()) { continue; }
+			size += entry.file_size();
+		}
+	} catch (fs::filesystem_error &e) {
+		throw helpers::filesystem_exception("helpers::directory_size: Cannot read directory: " + std::string(e.what()));
+	}
+
+	return size;
+}
+
+std::string helpers::read_head_tail(const fs::path &file, std::size_t max_length)
+{
+	static const std::string separator = "\n...\n";
+
+	std::ifstream in(file.string(), std::ios::binary);
+	if (!in.is_open()) { return ""; }
+
+	in.seekg(0, std::ios::end);
+	auto size = static_cast<std::size_t>(std::max(in.tellg(), std::streampos(0)));
+	in.seekg(0, std::ios::beg);
+
+	// short files (and files which are too long even for the separator) are read from the beginning
+	if (size <= max_length || max_length <= 2 * separator.size()) {
+		std::string result(std::min(size, max_length), 0);
+		in.read(&result[0], result.size());
+		result.resize(in.gcount());
+		return result;
+	}
+
+	std::size_t head = (max_length - separator.size()) / 2;
+	std::size_t tail = max_length - separator.size() - head;
+	std::string result(max_length, 0);
+	in.read(&result[0], head);
+	std::copy(separator.begin(), separator.end(), result.begin() + head);
+	in.seekg(size - tail, std::ios::beg);
+	in.read(&result[head + separator.size()], tail);
+	return result;
+}
+
+std::string helpers::head_tail(const std::string &content, std::size_t max_length)
+{
+	static const std::string separator = "\n...\n";
+
+	if (content.size() <= max_length || max_length <= 2 * separator.size()) {
+		return content.substr(0, max_length);
+	}
+
+	std::size_t head = (max_length - separator.size()) / 2;
+	std::size_t tail = max_length - separator.size() - head;
+	return content.substr(0, head) + separator + content.substr(content.size() - tail);
+}
+
+helpers::copy_method helpers::fast_copy_file(
+	const fs::path &src, const fs::path &dest, std::error_code &error_code, bool overwrite, bool hardlink)
+{
+	error_code.clear();
+#ifdef __linux__
+	struct stat st;
+	if (stat(src.c_str(), &st) != 0) {
+		error_code = last_error();
+		return copy_method::BUFFER;
+	}
+	if (!S_ISREG(st.st_mode)) {
+		error_code = std::make_error_code(std::errc::invalid_argument);
+		return copy_method::BUFFER;
+	}
+
+	if (hardlink) {
+		if (overwrite) { unlink(dest.c_str()); }
+		if (link(src.c_str(), dest.c_str()) == 0) {
+			count_copy(copy_method::HARDLINK);
+			return copy_method::HARDLINK;
+		}
+		if (errno == EEXIST) {
+			error_code = last_error();
+			return copy_method::HARDLINK;
+		}
+		// other filesystem, too many links, ... the file is copied
+	}
+
+	scoped_fd in(open(src.c_str(), O_RDONLY | O_CLOEXEC));
+	if (in.fd < 0) {
+		error_code = last_error();
+		return copy_method::BUFFER;
+	}
+
+	// the mode is set explicitly (as fs::copy_file does), the umask would strip bits given to open
+	scoped_fd out(open(dest.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (overwrite ? O_TRUNC : O_EXCL), S_IWUSR));
+	if (out.fd < 0 || fchmod(out.fd, st.st_mode & 07777) != 0) {
+		error_code = last_error();
+		return copy_method::BUFFER;
+	}
+
+	std::uintmax_t copied;
+	auto method = copy_data(in.fd, out.fd, st.st_size, std::numeric_limits<std::uintmax_t>::max(), copied, error_code);
+	if (!error_code && out.close_fd() != 0) { error_code = last_error(); }
+#else
+	if (hardlink) {
+		if (overwrite) { fs::remove(dest, error_code); }
+		fs::create_hard_link(src, dest, error_code);
+		if (!error_code) {
+			count_copy(copy_method::HARDLINK);
+			return copy_method::HARDLINK;
+		}
+	}
+
+	auto method = copy_method::BUFFER;
+	error_code.clear();
+	fs::copy_file(src,
+		dest,
+		overwrite ? fs::copy_options::overwrite_existing : fs::copy_options::none,
+		error_code);
+#endif
+
+	if (!error_code) { count_copy(method); }
+	return method;
+}
+
+helpers::copy_method helpers::fast_copy_file(const fs::path &src, const fs::path &dest, bool overwrite, bool hardlink)
+{
+	std::error_code error_code;
+	auto method = fast_copy_file(src, dest, error_code, overwrite, hardlink);
+	if (error_code) {
+		throw filesystem_exception("helpers::fast_copy_file: Cannot copy '" + src.string() + "' to '" + dest.string() +
+			"': " + error_code.message());
+	}
+	return method;
+}
+
+std::uintmax_t helpers::copy_file_prefix(const fs::path &src, const fs::path &dest, std::uintmax_t max_length)
+{
+#ifdef __linux__
+	scoped_fd in(open(src.c_str(), O_RDONLY | O_CLOEXEC));
+	if (in.fd < 0) {
+		throw filesystem_exception("helpers::copy_file_prefix: Cannot open " + src.string() + ": " + strerror(errno));
+	}
+	struct stat st;
+	if (fstat(in.fd, &st) != 0) {
+		throw filesystem_exception("helpers::copy_file_prefix: Cannot stat " + src.string() + ": " + strerror(errno));
+	}
+	scoped_fd out(open(dest.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+	if (out.fd < 0) {
+		throw filesystem_exception("helpers::copy_file_prefix: Cannot open " + dest.string() + ": " + strerror(errno));
+	}
+
+	std::uintmax_t copied;
+	std::error_code error_code;
+	auto method = copy_data(in.fd, out.fd, st.st_size, max_length, copied, error_code);
+	if (!error_code && out.close_fd() != 0) { error_code = last_error(); }
+	if (error_code) {
+		throw filesystem_exception(
+			"helpers::copy_file_prefix: Cannot copy " + src.string() + ": " + error_code.message());
+	}
+	count_copy(method);
+	return copied;
+#else
+	std::ifstream in(src.string(), std::ios::binary);
+	std::ofstream out(dest.string(), std::ios::binary | std::ios::trunc);
+	if (!in.is_open() || !out.is_open()) {
+		throw filesystem_exception("helpers::copy_file_prefix: Cannot open " + src.string() + " or " + dest.string());
+	}
+
+	std::uintmax_t copied = 0;
+	char buffer[65536];
+	while (copied < max_length && in) {
+		in.read(buffer, static_cast<std::streamsize>(std::min<std::uintmax_t>(sizeof(buffer), max_length - copied)));
+		out.write(buffer, in.gcount());
+		copied += in.gcount();
+	}
+	if (!out) { throw filesystem_exception("helpers::copy_file_prefix: Cannot write " + dest.string()); }
+	count_copy(copy_method::BUFFER);
+	return copied;
+#endif
+}
+
+helpers::copy_statistics helpers::get_copy_statistics()
+{
+	copy_statistics statistics;
+	statistics.reflinks = copy_counts[static_cast<std::size_t>(copy_method::REFLINK)];
+	statistics.hardlinks = copy_counts[static_cast<std::size_t>(copy_method::HARDLINK)];
+	statistics.kernel_copies = copy_counts[static_cast<std::size_t>(copy_method::KERNEL)];
+	statistics.buffer_copies = copy_counts[static_cast<std::size_t>(copy_method::BUFFER)];
+	return statistics;
 }
 
 fs::path helpers::normalize_path(const fs::path &path)
@@ -136,7 +575,8 @@ bool helpers::check_relative(const fs::path &path)
 fs::path helpers::find_path_outside_sandbox(const std::string &inside_path,
 	const std::string &sandbox_chdir,
 	std::vector<std::tuple<std::string, std::string, sandbox_limits::dir_perm>> &bound_dirs,
-	const std::string &source_dir)
+	const std::string &source_dir,
+	bool must_exist)
 {
 	auto file_path = fs::path(inside_path);
 	if (!file_path.has_root_directory()) {
@@ -164,6 +604,7 @@ fs::path helpers::find_path_outside_sandbox(const std::string &inside_path,
 		}
 	}
 
-	// not found
+	// not found, it may be created in the source directory
+	if (!must_exist && !file_path.relative_path().empty()) { return source_path; }
 	return fs::path();
 }
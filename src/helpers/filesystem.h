@@ -3,6 +3,7 @@
 
 #include "config/sandbox_limits.h"
 #include <filesystem>
+#include <system_error>
 
 namespace fs = std::filesystem;
 
@@ -18,6 +19,99 @@ namespace helpers
 	 */
 	void copy_directory(const fs::path &src, const fs::path &dest, bool skip_symlinks = false);
 
+	/**
+	 * Compute total size of all regular files in the directory (recursively, symlinks are not followed).
+	 * @param dir directory to be measured
+	 * @return size in bytes, zero if the directory does not exist
+	 * @throws filesystem_exception if the directory cannot be read
+	 */
+	std::uintmax_t directory_size(const fs::path &dir);
+
+	/**
+	 * Read a file limited to the given length. Longer files are cut in the middle, so both their beginning and end
+	 * are kept (separated by a line with three dots). Memory is allocated according to the returned content only.
+	 * @param file file to be read
+	 * @param max_length maximal length of the result
+	 * @return the content, empty if the file does not exist or cannot be read
+	 */
+	std::string read_head_tail(const fs::path &file, std::size_t max_length);
+
+	/**
+	 * Limit the content to the given length, it is cut in the middle the same way as by @ref read_head_tail.
+	 * @param content content to be limited
+	 * @param max_length maximal length of the result
+	 * @return the limited content
+	 */
+	std::string head_tail(const std::string &content, std::size_t max_length);
+
+	/**
+	 * Way in which a file was copied by @ref fast_copy_file.
+	 */
+	enum class copy_method {
+		REFLINK, /**< data are shared by the files until they are modified (FICLONE on btrfs, XFS, ...) */
+		HARDLINK, /**< destination is a hard link of the source */
+		KERNEL, /**< data were copied by the kernel (copy_file_range, sendfile across filesystems) */
+		BUFFER /**< data were read and written by the worker */
+	};
+
+	/**
+	 * Numbers of files copied by each method since the start of the worker.
+	 */
+	struct copy_statistics {
+		/** Files shared by reflinks */
+		std::size_t reflinks = 0;
+		/** Hard linked files */
+		std::size_t hardlinks = 0;
+		/** Files copied by the kernel */
+		std::size_t kernel_copies = 0;
+		/** Files copied through a buffer */
+		std::size_t buffer_copies = 0;
+	};
+
+	/**
+	 * Copy a regular file by the cheapest available method: reflink, hard link (only if allowed), copy in kernel and
+	 * copy through a buffer, in this order. Permissions of the source are copied.
+	 * @param src source file
+	 * @param dest destination file
+	 * @param error_code set if the copying failed
+	 * @param overwrite whether an existing destination is overwritten (otherwise it is an error)
+	 * @param hardlink whether a hard link can be created, i.e., neither of the files is modified in place later
+	 * @return used method (undefined if the copying failed)
+	 */
+	copy_method fast_copy_file(const fs::path &src,
+		const fs::path &dest,
+		std::error_code &error_code,
+		bool overwrite = true,
+		bool hardlink = false);
+
+	/**
+	 * Copy a regular file by the cheapest available method, see the overload with an error code for details.
+	 * @param src source file
+	 * @param dest destination file
+	 * @param overwrite whether an existing destination is overwritten (otherwise it is an error)
+	 * @param hardlink whether a hard link can be created, i.e., neither of the files is modified in place later
+	 * @return used method
+	 * @throws filesystem_exception if the copying failed
+	 */
+	copy_method fast_copy_file(const fs::path &src, const fs::path &dest, bool overwrite = true, bool hardlink = false);
+
+	/**
+	 * Copy the beginning of a file. The whole file is copied by the same methods as by @ref fast_copy_file (except
+	 * for the hard link), a part of it is copied by the kernel if possible.
+	 * @param src source file
+	 * @param dest destination file, it is overwritten if it exists
+	 * @param max_length maximal number of copied bytes
+	 * @return number of copied bytes
+	 * @throws filesystem_exception if the files cannot be opened or copying fails
+	 */
+	std::uintmax_t copy_file_prefix(const fs::path &src, const fs::path &dest, std::uintmax_t max_length);
+
+	/**
+	 * Get numbers of files copied by @ref fast_copy_file and @ref copy_file_prefix.
+	 * @return statistics since the start of the worker
+	 */
+	copy_statistics get_copy_statistics();
+
 	/**
 	 * Normalize dots and double dots from given path.
 	 * @param path path which will be processed
@@ -38,12 +132,14 @@ namespace helpers
 	 * @param sandbox_chdir directory where sandbox is chdir-ed
 	 * @param bound_dirs directories bound to sandbox
 	 * @param source_dir source directory on local filesystem
-	 * @return path outside sandbox
+	 * @param must_exist if false, path in source directory is returned for files which do not exist yet
+	 * @return path outside sandbox, empty if not found
 	 */
 	fs::path find_path_outside_sandbox(const std::string &inside_path,
 		const std::string &sandbox_chdir,
 		std::vector<std::tuple<std::string, std::string, sandbox_limits::dir_perm>> &bound_dirs,
-		const std::string &source_dir);
+		const std::string &source_dir,
+		bool must_exist = true);
 
 
 	/**
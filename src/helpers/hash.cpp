@@ -0,0 +1,182 @@
+#include "hash.h"
+#include "filesystem.h"
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	const std::array<std::uint32_t, 64> round_constants = {
+		0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+		0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+		0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+		0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+		0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+		0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+		0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+		0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+	inline std::uint32_t rotr(std::uint32_t value, unsigned bits)
+	{
+		return (value >> bits) | (value << (32 - bits));
+	}
+
+	/** Remembered digest of a file */
+	struct file_digest {
+		std::uintmax_t size;
+		fs::file_time_type modified;
+		std::string digest;
+	};
+
+	/** Maximal number of remembered digests, all of them are forgotten when it is reached */
+	const std::size_t max_file_digests = 65536;
+
+	std::mutex file_digests_mutex;
+	std::unordered_map<std::string, file_digest> file_digests;
+} // namespace
+
+
+helpers::sha256::sha256()
+	: state_({0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19})
+{
+}
+
+void helpers::sha256::update(const void *data, std::size_t length)
+{
+	auto bytes = static_cast<const unsigned char *>(data);
+	length_ += length;
+
+	while (length > 0) {
+		std::size_t chunk = std::min(length, buffer_.size() - buffered_);
+		std::copy(bytes, bytes + chunk, buffer_.begin() + buffered_);
+		buffered_ += chunk;
+		bytes += chunk;
+		length -= chunk;
+
+		if (buffered_ == buffer_.size()) {
+			transform();
+			buffered_ = 0;
+		}
+	}
+}
+
+void helpers::sha256::update(const std::string &text)
+{
+	update((std::uint64_t) text.size());
+	update(text.data(), text.size());
+}
+
+void helpers::sha256::update(std::uint64_t value)
+{
+	unsigned char bytes[8];
+	for (int i = 0; i < 8; ++i) { bytes[i] = (unsigned char) (value >> (8 * i)); }
+	update(bytes, sizeof(bytes));
+}
+
+void helpers::sha256::update_file(const fs::path &path)
+{
+	std::ifstream file(path.string(), std::ios::binary);
+	if (!file.is_open()) { throw filesystem_exception("Cannot open file " + path.string() + " for hashing"); }
+
+	std::vector<char> buffer(1 << 16);
+	std::uint64_t size = 0;
+	while (file) {
+		file.read(buffer.data(), buffer.size());
+		update(buffer.data(), (std::size_t) file.gcount());
+		size += (std::uint64_t) file.gcount();
+	}
+
+	if (file.bad()) { throw filesystem_exception("Cannot read file " + path.string() + " for hashing"); }
+	update(size);
+}
+
+std::string helpers::sha256::hexdigest()
+{
+	std::uint64_t bit_length = length_ * 8;
+
+	// padding - one bit, zeros and the length in bits (big endian)
+	unsigned char padding = 0x80;
+	update(&padding, 1);
+	padding = 0;
+	while (buffered_ != 56) { update(&padding, 1); }
+	unsigned char length_bytes[8];
+	for (int i = 0; i < 8; ++i) { length_bytes[i] = (unsigned char) (bit_length >> (56 - 8 * i)); }
+	update(length_bytes, sizeof(length_bytes));
+
+	static const char digits[] = "0123456789abcdef";
+	std::string result;
+	for (auto word : state_) {
+		for (int shift = 28; shift >= 0; shift -= 4) { result += digits[(word >> shift) & 0xf]; }
+	}
+	return result;
+}
+
+void helpers::sha256::transform()
+{
+	std::array<std::uint32_t, 64> w;
+	for (std::size_t i = 0; i < 16; ++i) {
+		w[i] = ((std::uint32_t) buffer_[4 * i] << 24) | ((std::uint32_t) buffer_[4 * i + 1] << 16) |
+			((std::uint32_t) buffer_[4 * i + 2] << 8) | (std::uint32_t) buffer_[4 * i + 3];
+	}
+	for (std::size_t i = 16; i < 64; ++i) {
+		std::uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		std::uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	std::uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+	std::uint32_t e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+	for (std::size_t i = 0; i < 64; ++i) {
+		std::uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+		std::uint32_t ch = (e & f) ^ (~e & g);
+		std::uint32_t temp1 = h + s1 + ch + round_constants[i] + w[i];
+		std::uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+		std::uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+		std::uint32_t temp2 = s0 + maj;
+
+		h = g;
+		g = f;
+		f = e;
+		e = d + temp1;
+		d = c;
+		c = b;
+		b = a;
+		a = temp1 + temp2;
+	}
+
+	state_[0] += a;
+	state_[1] += b;
+	state_[2] += c;
+	state_[3] += d;
+	state_[4] += e;
+	state_[5] += f;
+	state_[6] += g;
+	state_[7] += h;
+}
+
+std::string helpers::cached_file_digest(const fs::path &path)
+{
+	std::error_code ec;
+	auto size = fs::file_size(path, ec);
+	auto modified = ec ? fs::file_time_type() : fs::last_write_time(path, ec);
+	if (ec) { throw filesystem_exception("Cannot get status of file " + path.string() + " for hashing"); }
+
+	{
+		std::lock_guard<std::mutex> lock(file_digests_mutex);
+		auto it = file_digests.find(path.string());
+		if (it != file_digests.end() && it->second.size == size && it->second.modified == modified) {
+			return it->second.digest;
+		}
+	}
+
+	sha256 hash;
+	hash.update_file(path);
+	auto digest = hash.hexdigest();
+
+	std::lock_guard<std::mutex> lock(file_digests_mutex);
+	if (file_digests.size() >= max_file_digests) { file_digests.clear(); }
+	file_digests[path.string()] = {size, modified, digest};
+	return digest;
+}
@@ -0,0 +1,81 @@
+#ifndef RECODEX_WORKER_HELPERS_HASH_H
+#define RECODEX_WORKER_HELPERS_HASH_H
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace helpers
+{
+	/**
+	 * Incremental SHA-256 hash. Data are added by @a update methods, the digest is computed by @a hexdigest.
+	 */
+	class sha256
+	{
+	public:
+		/**
+		 * Constructor, starts an empty hash.
+		 */
+		sha256();
+
+		/**
+		 * Add raw data to the hash.
+		 * @param data pointer to the data
+		 * @param length number of bytes
+		 */
+		void update(const void *data, std::size_t length);
+
+		/**
+		 * Add a string to the hash. Its length is added as well, so the boundaries of strings are not ambiguous.
+		 * @param text added string
+		 */
+		void update(const std::string &text);
+
+		/**
+		 * Add a number to the hash.
+		 * @param value added number
+		 */
+		void update(std::uint64_t value);
+
+		/**
+		 * Add content of the file to the hash (including its length).
+		 * @param path file to be read
+		 * @throws filesystem_exception if the file cannot be read
+		 */
+		void update_file(const fs::path &path);
+
+		/**
+		 * Finish the hash and get its value. No more data can be added afterwards.
+		 * @return lowercase hexadecimal digest (64 characters)
+		 */
+		std::string hexdigest();
+
+	private:
+		/** Process one full block in @a buffer_. */
+		void transform();
+
+		/** Current state of the hash. */
+		std::array<std::uint32_t, 8> state_;
+		/** Unprocessed data. */
+		std::array<unsigned char, 64> buffer_;
+		/** Number of bytes in @a buffer_. */
+		std::size_t buffered_ = 0;
+		/** Total number of added bytes. */
+		std::uint64_t length_ = 0;
+	};
+
+	/**
+	 * Get digest of the content of a file (as added by @a sha256::update_file). Digests are remembered by the path,
+	 * size and modification time of the file, so a file which does not change is read only once.
+	 * @param path file to be read
+	 * @return lowercase hexadecimal digest
+	 * @throws filesystem_exception if the file cannot be read
+	 */
+	std::string cached_file_digest(const fs::path &path);
+} // namespace helpers
+
+
+#endif // RECODEX_WORKER_HELPERS_HASH_H
@@ -0,0 +1,190 @@
+#include "trace.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace
+{
+	/** Protects the trace file */
+	std::mutex trace_mutex;
+	/** The trace file, written only when @a trace_enabled is set */
+	std::ofstream trace_file;
+	/** Whether spans are recorded, checked without the lock */
+	std::atomic<bool> trace_enabled(false);
+	/** Process identifier of the events */
+	std::size_t trace_pid = 0;
+#ifndef _WIN32
+	/** The worker process, forked children (isolate) must not write into the file */
+	pid_t trace_owner = 0;
+#endif
+	/** Identifier of the next span (unique in the worker run) */
+	std::atomic<std::uint64_t> next_span_id(1);
+	/** Number of the next thread which records a span */
+	std::atomic<std::size_t> next_thread_id(1);
+
+	/** Innermost running span of the thread */
+	thread_local helpers::trace_span *current_span = nullptr;
+
+	/**
+	 * Small sequential identifier of the calling thread (readable in the trace viewer).
+	 */
+	std::size_t thread_id()
+	{
+		thread_local std::size_t id = next_thread_id++;
+		return id;
+	}
+
+	/**
+	 * Format a string as a JSON string literal.
+	 */
+	std::string json_string(const std::string &value)
+	{
+		std::string result = "\"";
+		for (char c : value) {
+			switch (c) {
+			case '"': result += "\\\""; break;
+			case '\\': result += "\\\\"; break;
+			case '\n': result += "\\n"; break;
+			case '\r': result += "\\r"; break;
+			case '\t': result += "\\t"; break;
+			default:
+				if ((unsigned char) c < 0x20) {
+					char escaped[8];
+					std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned) c);
+					result += escaped;
+				} else {
+					result += c;
+				}
+			}
+		}
+		return result + "\"";
+	}
+
+	/**
+	 * Microseconds since the epoch of the steady clock.
+	 */
+	long long micros(std::chrono::steady_clock::time_point time)
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+	}
+} // namespace
+
+
+bool helpers::open_trace(const std::string &file, std::size_t worker_id)
+{
+	std::lock_guard<std::mutex> lock(trace_mutex);
+	trace_enabled = false;
+	if (trace_file.is_open()) { trace_file.close(); }
+
+	trace_file.open(file, std::ios::out | std::ios::app);
+	if (!trace_file.is_open()) { return false; }
+
+	// the array is never closed, trace viewers accept that (the worker may be killed anyway)
+	if (trace_file.tellp() == 0) { trace_file << "[" << std::endl; }
+	trace_pid = worker_id;
+#ifndef _WIN32
+	trace_owner = getpid();
+#endif
+	trace_enabled = true;
+	return true;
+}
+
+void helpers::close_trace()
+{
+	std::lock_guard<std::mutex> lock(trace_mutex);
+	trace_enabled = false;
+	if (trace_file.is_open()) { trace_file.close(); }
+}
+
+helpers::trace_span::trace_span(const std::string &name)
+{
+	start(name, current());
+}
+
+helpers::trace_span::trace_span(const std::string &name, const std::string &trace_id)
+{
+	trace_context root;
+	root.trace_id = trace_id;
+	start(name, root);
+}
+
+helpers::trace_span::trace_span(const std::string &name, const trace_context &parent)
+{
+	start(name, parent);
+}
+
+helpers::trace_span::~trace_span()
+{
+	end();
+}
+
+void helpers::trace_span::start(const std::string &name, const trace_context &parent)
+{
+	if (!trace_enabled) { return; }
+
+	recorded_ = true;
+	name_ = name;
+	context_.trace_id = parent.trace_id;
+	context_.span_id = next_span_id++;
+	parent_id_ = parent.span_id;
+	previous_ = current_span;
+	current_span = this;
+	start_ = std::chrono::steady_clock::now();
+}
+
+void helpers::trace_span::set(const std::string &key, const std::string &value)
+{
+	if (recorded_) { add_attribute(key, json_string(value)); }
+}
+
+void helpers::trace_span::set(const std::string &key, const char *value)
+{
+	set(key, std::string(value));
+}
+
+void helpers::trace_span::set(const std::string &key, bool value)
+{
+	if (recorded_) { add_attribute(key, value ? "true" : "false"); }
+}
+
+void helpers::trace_span::add_attribute(const std::string &key, const std::string &json_value)
+{
+	attributes_ += "," + json_string(key) + ":" + json_value;
+}
+
+void helpers::trace_span::end()
+{
+	if (!recorded_) { return; }
+	recorded_ = false;
+	auto now = std::chrono::steady_clock::now();
+	if (current_span == this) { current_span = previous_; }
+#ifndef _WIN32
+	// the lock may be held by another thread of the parent in a forked child
+	if (getpid() != trace_owner) { return; }
+#endif
+
+	std::string event = "{\"name\":" + json_string(name_) + ",\"cat\":\"worker\",\"ph\":\"X\",\"ts\":" +
+		std::to_string(micros(start_)) + ",\"dur\":" + std::to_string(micros(now) - micros(start_)) +
+		",\"tid\":" + std::to_string(thread_id()) + ",\"args\":{\"trace_id\":" + json_string(context_.trace_id) +
+		",\"span_id\":" + std::to_string(context_.span_id) + ",\"parent_id\":" + std::to_string(parent_id_) +
+		attributes_ + "}";
+
+	std::lock_guard<std::mutex> lock(trace_mutex);
+	if (!trace_enabled) { return; }
+	trace_file << event << ",\"pid\":" << trace_pid << "}," << std::endl;
+}
+
+helpers::trace_context helpers::trace_span::context() const
+{
+	return context_;
+}
+
+helpers::trace_context helpers::trace_span::current()
+{
+	return current_span != nullptr ? current_span->context() : trace_context();
+}
@@ -0,0 +1,153 @@
+#ifndef RECODEX_WORKER_HELPERS_TRACE_H
+#define RECODEX_WORKER_HELPERS_TRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace helpers
+{
+	/**
+	 * Open the trace file of the worker, spans are recorded only while it is open.
+	 *
+	 * Spans are written as complete events of the Chrome trace-event format (JSON array without the closing bracket,
+	 * one event per line), which can be loaded into Perfetto or chrome://tracing. The file is appended to, so a
+	 * restarted worker continues in the same file.
+	 * @param file path to the file
+	 * @param worker_id identifier of the worker, used as the process identifier of the events
+	 * @return false if the file cannot be opened
+	 */
+	bool open_trace(const std::string &file, std::size_t worker_id);
+
+	/**
+	 * Stop recording and close the trace file.
+	 */
+	void close_trace();
+
+	/**
+	 * Identification of a span, used as a parent of spans in other threads.
+	 */
+	struct trace_context {
+		/** Identifier of the trace (the job), empty if the span is not a part of a job */
+		std::string trace_id;
+		/** Identifier of the span, zero if there is no span (or the recording is off) */
+		std::uint64_t span_id = 0;
+	};
+
+	/**
+	 * Timed section of the work of the worker with attributes, written to the trace file when it ends.
+	 *
+	 * Spans form a tree in each thread: a new span is a child of the innermost running span of the thread and takes
+	 * over its trace identifier, unless the parent is given explicitly. Spans must end in the reverse order of their
+	 * start, which is guaranteed when they are local variables. Nothing is recorded if the trace file is not open.
+	 */
+	class trace_span
+	{
+	public:
+		/**
+		 * Start a child span of the current span of this thread (or a span without a trace if there is none).
+		 * @param name name of the span
+		 */
+		explicit trace_span(const std::string &name);
+
+		/**
+		 * Start a root span of a trace.
+		 * @param name name of the span
+		 * @param trace_id identifier of the trace (job identifier)
+		 */
+		trace_span(const std::string &name, const std::string &trace_id);
+
+		/**
+		 * Start a child span of a span from another thread.
+		 * @param name name of the span
+		 * @param parent context of the parent span
+		 */
+		trace_span(const std::string &name, const trace_context &parent);
+
+		trace_span(const trace_span &source) = delete;
+		trace_span &operator=(const trace_span &source) = delete;
+
+		/**
+		 * Destructor, ends the span if it is still running.
+		 */
+		~trace_span();
+
+		/**
+		 * Add a textual attribute.
+		 * @param key name of the attribute
+		 * @param value its value
+		 */
+		void set(const std::string &key, const std::string &value);
+
+		/**
+		 * Add a textual attribute.
+		 * @param key name of the attribute
+		 * @param value its value
+		 */
+		void set(const std::string &key, const char *value);
+
+		/**
+		 * Add a boolean attribute.
+		 * @param key name of the attribute
+		 * @param value its value
+		 */
+		void set(const std::string &key, bool value);
+
+		/**
+		 * Add a numeric attribute.
+		 * @param key name of the attribute
+		 * @param value its value
+		 */
+		template <typename T>
+		typename std::enable_if<std::is_arithmetic<T>::value>::type set(const std::string &key, T value)
+		{
+			if (recorded_) { add_attribute(key, std::to_string(value)); }
+		}
+
+		/**
+		 * End the span and write it to the trace file.
+		 */
+		void end();
+
+		/**
+		 * Get identification of this span, to be used as a parent in another thread.
+		 */
+		trace_context context() const;
+
+		/**
+		 * Get identification of the current span of this thread.
+		 */
+		static trace_context current();
+
+	private:
+		/**
+		 * Start the span if the recording is on.
+		 */
+		void start(const std::string &name, const trace_context &parent);
+
+		/**
+		 * Append an attribute to @a attributes_.
+		 * @param key name of the attribute
+		 * @param json_value value already formatted as JSON
+		 */
+		void add_attribute(const std::string &key, const std::string &json_value);
+
+		/** Whether the span is recorded and has not ended yet */
+		bool recorded_ = false;
+		/** Name of the span */
+		std::string name_;
+		/** Identification of the span */
+		trace_context context_;
+		/** Identifier of the parent span, zero for root spans */
+		std::uint64_t parent_id_ = 0;
+		/** Attributes formatted as JSON members, each preceded by a comma */
+		std::string attributes_;
+		/** Start of the span */
+		std::chrono::steady_clock::time_point start_;
+		/** Span which was current in this thread before this one started */
+		trace_span *previous_ = nullptr;
+	};
+} // namespace helpers
+
+#endif // RECODEX_WORKER_HELPERS_TRACE_H
@@ -1,4 +1,5 @@
 #include "zmq_socket.h"
+#include <cstring>
 
 bool helpers::send_through_socket(zmq::socket_t &socket, const std::vector<std::string> &msg)
 {
@@ -13,6 +14,25 @@ bool helpers::send_through_socket(zmq::socket_t &socket, const std::vector<std::
 	return true;
 }
 
+bool helpers::send_through_socket(zmq::socket_t &socket, std::vector<zmq::message_t> &msg)
+{
+	for (auto it = std::begin(msg); it != std::end(msg); ++it) {
+		try {
+			if (!socket.send(*it, std::next(it) != std::end(msg) ? ZMQ_SNDMORE : 0)) { return false; }
+		} catch (const zmq::error_t &) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+zmq::message_t helpers::static_frame(const char *data)
+{
+	// no deallocation function, the data are owned by the caller
+	return zmq::message_t(const_cast<char *>(data), std::strlen(data), nullptr);
+}
+
 bool helpers::recv_from_socket(zmq::socket_t &socket, std::vector<std::string> &target, bool *terminate)
 {
 	zmq::message_t msg;
@@ -35,3 +55,33 @@ bool helpers::recv_from_socket(zmq::socket_t &socket, std::vector<std::string> &
 
 	return true;
 }
+
+bool helpers::forward_through_socket(zmq::socket_t &from, zmq::socket_t &to, bool *terminate)
+{
+	bool sent = true;
+	bool more;
+
+	do {
+		zmq::message_t msg;
+
+		try {
+			if (!from.recv(&msg)) { return false; }
+		} catch (const zmq::error_t &) {
+			if (terminate != nullptr) { *terminate = true; }
+			return false;
+		}
+
+		// remaining frames are still received, so they do not mix with the next message
+		more = msg.more();
+		if (!sent) { continue; }
+
+		try {
+			// message content is handed over to the target socket, msg is empty afterwards
+			sent = to.send(msg, more ? ZMQ_SNDMORE : 0);
+		} catch (const zmq::error_t &) {
+			sent = false;
+		}
+	} while (more);
+
+	return sent;
+}
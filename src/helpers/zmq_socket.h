@@ -14,6 +14,20 @@ namespace helpers
 	 * @return true on success, false otherwise.
 	 */
 	bool send_through_socket(zmq::socket_t &socket, const std::vector<std::string> &msg);
+	/**
+	 * Sends multipart message consisting of prepared frames through given zmq socket. Frame contents are handed over
+	 * to the socket without copying, the frames are empty afterwards.
+	 * @param socket socket to which messages will be sent
+	 * @param msg frames of the multipart message
+	 * @return true on success, false otherwise.
+	 */
+	bool send_through_socket(zmq::socket_t &socket, std::vector<zmq::message_t> &msg);
+	/**
+	 * Create message frame which refers to static data (e.g. a string literal), the data are not copied.
+	 * @param data null-terminated string which outlives the message
+	 * @return frame with the string (without the terminating null)
+	 */
+	zmq::message_t static_frame(const char *data);
 	/**
 	 * Receive multipart message from given zmq socket.
 	 * @param socket messages should be received here
@@ -23,6 +37,16 @@ namespace helpers
 	 * @return true on success, false otherwise
 	 */
 	bool recv_from_socket(zmq::socket_t &socket, std::vector<std::string> &target, bool *terminate = nullptr);
+	/**
+	 * Receive multipart message from one socket and send it through another one. Frames are passed as they are
+	 * (without copying their content).
+	 * @param from socket from which the message is received
+	 * @param to socket to which the message is sent
+	 * @param terminate pointer to boolean variable which will be set to true if the source socket cannot be read from
+	 *        anymore (e.g. when an exception occurs)
+	 * @return true on success, false otherwise (the whole message is received from @a from even then)
+	 */
+	bool forward_through_socket(zmq::socket_t &from, zmq::socket_t &to, bool *terminate = nullptr);
 } // namespace helpers
 
 #endif // RECODEX_HELPERS_ZMQ_SOCKET_H
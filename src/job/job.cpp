@@ -1,6 +1,7 @@
 #include "job.h"
 #include "job_exception.h"
 #include "helpers/type_utils.h"
+#include "helpers/trace.h"
 
 job::job(std::shared_ptr<job_metadata> job_meta,
 	std::shared_ptr<worker_config> worker_conf,
@@ -8,9 +9,11 @@ job::job(std::shared_ptr<job_metadata> job_meta,
 	fs::path source_path,
 	fs::path result_path,
 	std::shared_ptr<task_factory_interface> factory,
-	std::shared_ptr<progress_callback_interface> progr_callback)
+	std::shared_ptr<progress_callback_interface> progr_callback,
+	std::shared_ptr<helpers::cancellation_token> cancellation)
 	: job_meta_(job_meta), worker_config_(worker_conf), temporary_directory_(temporary_directory),
-	  source_path_(source_path), result_path_(result_path), factory_(factory), progress_callback_(progr_callback)
+	  source_path_(source_path), result_path_(result_path), factory_(factory), progress_callback_(progr_callback),
+	  box_session_(std::make_shared<box_session>()), cancellation_(cancellation)
 {
 	// check construction parameters if they are in right format
 	if (job_meta_ == nullptr) {
@@ -33,6 +36,14 @@ job::job(std::shared_ptr<job_metadata> job_meta,
 	// construct system logger for this job
 	init_logger();
 
+	// boxes of the next tasks are initialized in advance only if the worker has spare ones
+	if (!worker_config_->get_spare_box_ids().empty()) {
+		std::vector<std::size_t> box_ids = {worker_config_->get_worker_id()};
+		const auto &spare_ids = worker_config_->get_spare_box_ids();
+		box_ids.insert(box_ids.end(), spare_ids.begin(), spare_ids.end());
+		box_pool_ = std::make_shared<box_pool>(box_ids, logger_);
+	}
+
 	// build job from given job configuration
 	build_job();
 }
@@ -107,8 +118,9 @@ void job::build_job()
 
 		std::shared_ptr<task_base> task;
 
-		// distinguish internal/external command and construct suitable object
-		if (task_meta->sandbox != nullptr) {
+		// distinguish internal/external command and construct suitable object,
+		// the internal judge uses only the output flag of its sandbox section
+		if (task_meta->sandbox != nullptr && task_meta->binary != "judge") {
 
 			// //////////////// //
 			// external command //
@@ -143,6 +155,7 @@ void job::build_job()
 			sandbox->std_error = parse_job_var(sandbox->std_error);
 			sandbox->carboncopy_stdout = parse_job_var(sandbox->carboncopy_stdout);
 			sandbox->carboncopy_stderr = parse_job_var(sandbox->carboncopy_stderr);
+			for (auto &output : sandbox->outputs) { output = parse_job_var(output); }
 			std::vector<std::tuple<std::string, std::string, sandbox_limits::dir_perm>> new_bnd_dirs;
 			for (auto &bnd_dir : limits->bound_dirs) {
 				new_bnd_dirs.emplace_back(
@@ -158,7 +171,10 @@ void job::build_job()
 				logger_,
 				temporary_directory_.string(),
 				source_path_,
-				sandbox_working_path_};
+				sandbox_working_path_,
+				box_session_,
+				box_pool_,
+				cancellation_};
 
 			task = factory_->create_sandboxed_task(data);
 
@@ -288,16 +304,31 @@ std::vector<std::pair<std::string, std::shared_ptr<task_results>>> job::run()
 	progress_callback_->job_started(job_meta_->job_id);
 
 	// simply run all tasks in given topological order
-	for (auto &task : task_queue_) {
+	for (std::size_t i = 0; i < task_queue_.size(); ++i) {
+		auto &task = task_queue_[i];
 		// we don't want nullptr dereference
 		if (task == nullptr) { continue; }
 
+		// remaining tasks are skipped, the job is cleaned up as usual
+		check_cancelled();
+
 		auto task_id = task->get_task_id();
 		if (task->is_executable()) {
+			helpers::trace_span span("task");
+			span.set("task_id", task_id);
+			span.set("binary", task->get_cmd());
 			std::shared_ptr<task_results> res = nullptr;
 			try {
+				// box of the previous test is kept only for following sandboxed tasks of the same test
+				if (!task->is_sandboxed() || box_session_->get_box(task->get_test_id()) == nullptr) {
+					box_session_->close();
+				}
+				prepare_next_task(i);
 				res = task->run();
 			} catch (std::exception &e) {
+				close_box_session();
+				// the program of the task was terminated because of the cancellation
+				check_cancelled();
 				throw job_unrecoverable_exception(e.what());
 			}
 
@@ -306,6 +337,7 @@ std::vector<std::pair<std::string, std::shared_ptr<task_results>>> job::run()
 
 			// if task has some results then process them
 			if (res != nullptr) {
+				span.set("status", res->status == task_status::OK ? "OK" : "FAILED");
 				if (res->status == task_status::OK) {
 					// task executed successfully
 
@@ -349,6 +381,14 @@ std::vector<std::pair<std::string, std::shared_ptr<task_results>>> job::run()
 		}
 	}
 
+	// results of the last test are moved out of its box
+	try {
+		box_session_->close();
+	} catch (std::exception &e) {
+		throw job_unrecoverable_exception(e.what());
+	}
+	if (box_pool_ != nullptr) { box_pool_->discard(); }
+
 	progress_callback_->job_ended(job_meta_->job_id);
 	return results;
 }
@@ -397,7 +437,42 @@ void job::cleanup_job()
 	// destroy all files in working directory
 	// -> job_evaluator will handle this for us...
 
-	return;
+	close_box_session();
+}
+
+void job::prepare_next_task(std::size_t current)
+{
+	if (box_pool_ == nullptr) { return; }
+
+	auto &task = task_queue_[current];
+	for (std::size_t i = current + 1; i < task_queue_.size(); ++i) {
+		auto &next = task_queue_[i];
+		if (next == nullptr) { continue; }
+
+		// the next task of the same test runs in the box of the current one
+		bool same_box = task->is_sandboxed() && !task->get_test_id().empty() &&
+			task->get_test_id() == next->get_test_id();
+		if (next->is_executable() && next->is_sandboxed() && !same_box) { next->prepare(); }
+		return;
+	}
+}
+
+void job::check_cancelled()
+{
+	if (cancellation_ == nullptr || !cancellation_->is_cancelled()) { return; }
+
+	logger_->info("Job was cancelled, remaining tasks are not executed");
+	close_box_session();
+	throw job_cancelled_exception("Job was cancelled");
+}
+
+void job::close_box_session()
+{
+	try {
+		box_session_->close();
+	} catch (std::exception &e) {
+		logger_->warn("Isolate box of the test was not closed properly: {}", e.what());
+	}
 }
 
 const std::vector<std::shared_ptr<task_base>> &job::get_task_queue() const
@@ -12,6 +12,7 @@
 #include "helpers/logger.h"
 #include "helpers/topological_sort.h"
 #include "helpers/filesystem.h"
+#include "helpers/cancellation_token.h"
 #include "config/worker_config.h"
 #include "config/job_metadata.h"
 #include "config/task_metadata.h"
@@ -46,6 +47,7 @@ public:
 	 * @param result_path path to directory containing all results
 	 * @param factory used in creation of task objects
 	 * @param progr_callback used to notify the broker of progress
+	 * @param cancellation cancellation of the job by the broker (optional)
 	 * @throws job_exception if there is problem during loading of configuration
 	 */
 	job(std::shared_ptr<job_metadata> job_meta,
@@ -54,7 +56,8 @@ public:
 		fs::path source_path,
 		fs::path result_path,
 		std::shared_ptr<task_factory_interface> factory,
-		std::shared_ptr<progress_callback_interface> progr_callback);
+		std::shared_ptr<progress_callback_interface> progr_callback,
+		std::shared_ptr<helpers::cancellation_token> cancellation = nullptr);
 
 	/**
 	 * Job cleanup (if needed) is executed.
@@ -66,6 +69,7 @@ public:
 	 * Should not throw an exception.
 	 * @return Vector with pairs task id - task_results. Values are not @a nullptr.
 	 * @throws task_exception in case of internal execution error
+	 * @throws job_cancelled_exception if the job was cancelled (the remaining tasks are not executed)
 	 * @throws std::exception in case of fatal error
 	 */
 	std::vector<std::pair<std::string, std::shared_ptr<task_results>>> run();
@@ -93,6 +97,20 @@ private:
 	 * Cleanup after job evaluation, should be enough to delete all created files
 	 */
 	void cleanup_job();
+	/**
+	 * Close the shared isolate box session, errors are only logged.
+	 */
+	void close_box_session();
+	/**
+	 * Stop the evaluation if the job was cancelled.
+	 * @throws job_cancelled_exception if the job was cancelled
+	 */
+	void check_cancelled();
+	/**
+	 * Let the next executable task prepare itself while the given one is running.
+	 * @param current index of the task which is going to run in @a task_queue_
+	 */
+	void prepare_next_task(std::size_t current);
 	/**
 	 * Build job from @a job_meta_. Should be called in constructor.
 	 */
@@ -143,6 +161,12 @@ private:
 	std::shared_ptr<task_factory_interface> factory_;
 	/** Progress callback which is called on some important points */
 	std::shared_ptr<progress_callback_interface> progress_callback_;
+	/** Isolate box shared by consecutive sandboxed tasks of one test */
+	std::shared_ptr<box_session> box_session_;
+	/** Isolate boxes of the worker which may be initialized in advance, @a nullptr if not enabled */
+	std::shared_ptr<box_pool> box_pool_;
+	/** Cancellation of the job by the broker, @a nullptr if it cannot be cancelled */
+	std::shared_ptr<helpers::cancellation_token> cancellation_;
 
 	/** Variables which can be used in job configuration */
 	std::map<std::string, std::string> job_variables_;
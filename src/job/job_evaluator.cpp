@@ -4,21 +4,43 @@
 #include "fileman/fallback_file_manager.h"
 #include "fileman/prefixed_file_manager.h"
 #include "helpers/config.h"
+#include "helpers/trace.h"
 
 job_evaluator::job_evaluator(std::shared_ptr<spdlog::logger> logger,
 	std::shared_ptr<worker_config> config,
 	std::shared_ptr<file_manager_interface> remote_fm,
 	std::shared_ptr<file_manager_interface> cache_fm,
 	fs::path working_directory,
-	std::shared_ptr<progress_callback_interface> progr_callback)
+	std::shared_ptr<progress_callback_interface> progr_callback,
+	std::shared_ptr<helpers::cancellation_token> cancellation)
 	: working_directory_(working_directory), job_(nullptr), job_results_(), remote_fm_(remote_fm), cache_fm_(cache_fm),
-	  logger_(logger), config_(config), progress_callback_(progr_callback)
+	  logger_(logger), config_(config), progress_callback_(progr_callback), cancellation_(cancellation)
 {
 	if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
 
+	if (config_ != nullptr) {
+		compilation_cache_ = create_task_cache(
+			config_->get_compilation_cache_dir(), config_->get_compilation_cache_max_size(), "Compilation");
+		judge_cache_ = create_task_cache(config_->get_judge_cache_dir(), config_->get_judge_cache_max_size(), "Judge");
+	}
+
 	init_progress_callback();
 }
 
+std::shared_ptr<task_cache> job_evaluator::create_task_cache(
+	const std::string &dir, std::size_t max_size, const std::string &name)
+{
+	if (dir.empty()) { return nullptr; }
+
+	// the cache is only an optimization, jobs are evaluated without it if it cannot be used
+	try {
+		return std::make_shared<task_cache>(dir, max_size, logger_);
+	} catch (task_exception &e) {
+		logger_->error("{} cache disabled: {}", name, e.what());
+		return nullptr;
+	}
+}
+
 void job_evaluator::init_progress_callback()
 {
 	if (progress_callback_ == nullptr) { progress_callback_ = std::make_shared<empty_progress_callback>(); }
@@ -26,6 +48,8 @@ void job_evaluator::init_progress_callback()
 
 void job_evaluator::download_submission()
 {
+	helpers::trace_span span("download");
+	span.set("url", archive_url_);
 	logger_->info("Trying to download submission archive...");
 
 	// create directory for downloaded archive
@@ -41,12 +65,16 @@ void job_evaluator::download_submission()
 	remote_fm_->get_file(archive_url.string(), (archive_path_ / archive_name_).string());
 
 	logger_->info("Submission archive downloaded succesfully.");
+	auto size = fs::file_size(archive_path_ / archive_name_);
+	span.set("size", size);
+	check_staging_budget(size, "submission archive");
 	progress_callback_->job_archive_downloaded(job_id_);
 	return;
 }
 
 void job_evaluator::prepare_submission()
 {
+	helpers::trace_span span("extract");
 	logger_->info("Preparing submission for usage...");
 
 	// decompress downloaded archive directly to source path (eval dir)
@@ -70,6 +98,10 @@ void job_evaluator::prepare_submission()
 		throw job_exception("Cannot create directories: " + std::string(e.what()));
 	}
 
+	if (staged_) {
+		check_staging_budget(helpers::directory_size(archive_path_) + helpers::directory_size(source_path_),
+			"submission archive and its contents");
+	}
 
 	logger_->info("Submission prepared.");
 	return;
@@ -78,6 +110,7 @@ void job_evaluator::prepare_submission()
 void job_evaluator::build_job()
 {
 	namespace fs = std::filesystem;
+	helpers::trace_span span("build");
 	logger_->info("Building job...");
 
 	// find job-config.yml to load configuration
@@ -115,34 +148,121 @@ void job_evaluator::build_job()
 		throw job_unrecoverable_exception("Job identification from broker and in configuration are different");
 	}
 
+	// fetched files are in the job directories as well, their sizes are known only if they are cached
+	if (staged_) {
+		std::uintmax_t size = helpers::directory_size(archive_path_) + helpers::directory_size(source_path_);
+		for (auto &task : job_meta->tasks) {
+			if (task->binary != "fetch" || task->cmd_args.size() != 2) { continue; }
+
+			std::uintmax_t file_size = 0;
+			if (!cache_fm_->get_file_size(task->cmd_args[0], file_size)) {
+				unstage("size of fetched file " + task->cmd_args[0] + " is not known");
+				break;
+			}
+			size += file_size;
+		}
+		check_staging_budget(size, "submission and fetched files");
+	}
+
 	// construct manager which is used in task factory
 	auto task_fileman = std::make_shared<fallback_file_manager>(
 		cache_fm_, std::make_shared<prefixed_file_manager>(remote_fm_, job_meta->file_server_url + "/"));
 
-	auto factory = std::make_shared<task_factory>(task_fileman);
+	// internal judges are bounded by the default limits of the worker
+	auto factory =
+		std::make_shared<task_factory>(task_fileman, compilation_cache_, judge_cache_, config_, cancellation_);
 
 	// ... and construct job itself
 	job_ = std::make_shared<job>(
-		job_meta, config_, job_temp_dir_, source_path_, results_path_, factory, progress_callback_);
+		job_meta, config_, job_temp_dir_, source_path_, results_path_, factory, progress_callback_, cancellation_);
 
+	span.set("tasks", job_meta->tasks.size());
+	span.set("staged", staged_);
 	logger_->info("Job building done.");
 	return;
 }
 
 void job_evaluator::run_job()
 {
+	helpers::trace_span span("run");
 	logger_->info("Ready for evaluation...");
 	job_results_ = job_->run();
 	logger_->info("Job evaluated.");
+
+	auto copies = helpers::get_copy_statistics();
+	logger_->debug("Files copied since start: {} reflinks, {} hard links, {} in kernel, {} through buffer",
+		copies.reflinks,
+		copies.hardlinks,
+		copies.kernel_copies,
+		copies.buffer_copies);
 }
 
 void job_evaluator::init_submission_paths()
 {
-	source_path_ = working_directory_ / "eval" / std::to_string(config_->get_worker_id()) / job_id_;
-	archive_path_ = working_directory_ / "downloads" / std::to_string(config_->get_worker_id()) / job_id_;
+	staged_ = false;
+
+	// the job is staged only if the budget surely fits into the staging filesystem
+	const std::string &staging_dir = config_->get_staging_dir();
+	if (!staging_dir.empty()) {
+		std::error_code ec;
+		fs::create_directories(staging_dir, ec);
+		auto space = fs::space(staging_dir, ec);
+		if (ec) {
+			logger_->warn("Staging directory {} is not usable: {}", staging_dir, ec.message());
+		} else if (space.available < config_->get_staging_job_budget()) {
+			logger_->info("Staging directory {} is full, job is evaluated on disk", staging_dir);
+		} else {
+			staged_ = true;
+		}
+	}
+
+	set_submission_paths(staged_ ? fs::path(staging_dir) : working_directory_);
+	if (staged_) { logger_->info("Job is staged in {}", staging_dir); }
+}
+
+void job_evaluator::set_submission_paths(const fs::path &base_dir)
+{
+	source_path_ = base_dir / "eval" / std::to_string(config_->get_worker_id()) / job_id_;
+	archive_path_ = base_dir / "downloads" / std::to_string(config_->get_worker_id()) / job_id_;
 	// set temporary directory for tasks in job
-	job_temp_dir_ = working_directory_ / "temp" / std::to_string(config_->get_worker_id()) / job_id_;
-	results_path_ = working_directory_ / "results" / std::to_string(config_->get_worker_id()) / job_id_;
+	job_temp_dir_ = base_dir / "temp" / std::to_string(config_->get_worker_id()) / job_id_;
+	results_path_ = base_dir / "results" / std::to_string(config_->get_worker_id()) / job_id_;
+}
+
+void job_evaluator::check_staging_budget(std::uintmax_t size, const std::string &what)
+{
+	if (!staged_ || size <= config_->get_staging_job_budget()) { return; }
+
+	unstage(what + " take " + std::to_string(size) + " bytes, budget is " +
+		std::to_string(config_->get_staging_job_budget()));
+}
+
+void job_evaluator::unstage(const std::string &reason)
+{
+	logger_->info("Moving job from staging directory to disk: {}", reason);
+
+	std::vector<fs::path> staged_paths = {source_path_, archive_path_, job_temp_dir_, results_path_};
+	set_submission_paths(working_directory_);
+	std::vector<fs::path> disk_paths = {source_path_, archive_path_, job_temp_dir_, results_path_};
+	staged_ = false;
+
+	try {
+		for (std::size_t i = 0; i < staged_paths.size(); ++i) {
+			fs::remove_all(disk_paths[i]);
+			if (!fs::exists(staged_paths[i])) { continue; }
+
+			fs::create_directories(disk_paths[i].parent_path());
+			// it is a different filesystem (unless the staging directory is misconfigured)
+			std::error_code ec;
+			fs::rename(staged_paths[i], disk_paths[i], ec);
+			if (ec) {
+				helpers::copy_directory(staged_paths[i], disk_paths[i]);
+				fs::remove_all(staged_paths[i]);
+			}
+		}
+	} catch (std::exception &e) {
+		throw job_exception("Cannot move job from staging directory: " + std::string(e.what()));
+	}
 }
 
 void job_evaluator::cleanup_submission()
@@ -203,6 +323,7 @@ void job_evaluator::cleanup_variables()
 
 		job_id_ = "";
 		job_ = nullptr;
+		staged_ = false;
 	} catch (std::exception &e) {
 		logger_->error("Error in deinicialization of evaluator: {}", e.what());
 	}
@@ -210,19 +331,24 @@ void job_evaluator::cleanup_variables()
 
 void job_evaluator::prepare_evaluator()
 {
+	helpers::trace_span span("prepare");
 	init_submission_paths();
 	cleanup_submission();
 }
 
 void job_evaluator::cleanup_evaluator()
 {
-	if (config_->get_cleanup_submission() == true) { cleanup_submission(); }
+	helpers::trace_span span("cleanup");
+	// RAM-backed staging directory is always cleaned
+	if (config_->get_cleanup_submission() == true || staged_) { cleanup_submission(); }
 
 	cleanup_variables();
 }
 
 void job_evaluator::push_result()
 {
+	helpers::trace_span span("upload");
+	span.set("url", result_url_);
 	logger_->info("Trying to upload results of job...");
 
 	// just checkout for errors
@@ -282,6 +408,23 @@ void job_evaluator::push_result()
 			subnode["csw-voluntary"] = sandbox->csw_voluntary;
 			subnode["csw-forced"] = sandbox->csw_forced;
 
+			if (!sandbox->samples.empty()) {
+				// one compact line per sample
+				YAML::Node samples;
+				for (auto &sample : sandbox->samples) {
+					YAML::Node sample_node;
+					sample_node.SetStyle(YAML::EmitterStyle::Flow);
+					sample_node["time"] = sample.time;
+					sample_node["memory"] = sample.memory;
+					sample_node["cpu-time"] = sample.cpu_time;
+					sample_node["io-read"] = sample.io_read;
+					sample_node["io-write"] = sample.io_write;
+					sample_node["pids"] = sample.pids;
+					samples.push_back(sample_node);
+				}
+				subnode["samples"] = samples;
+			}
+
 			node["sandbox_results"] = subnode;
 		}
 
@@ -321,6 +464,9 @@ eval_response job_evaluator::evaluate(eval_request request)
 	logger_->info("Request for job evaluation arrived to worker");
 	logger_->info("Job ID of incoming job is: {}", request.job_id);
 
+	// all spans of the evaluation belong to the trace of the job
+	helpers::trace_span span("job", request.job_id);
+
 	// set all needed variables for evaluation
 	job_id_ = request.job_id;
 	archive_url_ = request.job_url;
@@ -329,6 +475,7 @@ eval_response job_evaluator::evaluate(eval_request request)
 	// prepare response which will be sent to broker
 	eval_response_holder response(request.job_id, "OK");
 
+	if (cancellation_ != nullptr) { cancellation_->start(job_id_); }
 	prepare_evaluator();
 	try {
 		download_submission();
@@ -339,6 +486,13 @@ eval_response job_evaluator::evaluate(eval_request request)
 
 		progress_callback_->job_finished(job_id_);
 
+	} catch (job_cancelled_exception &e) {
+		// results of a cancelled job are not wanted, so they are not uploaded
+		logger_->info("Job evaluation was cancelled by the broker");
+		progress_callback_->job_aborted(job_id_);
+
+		response.set_result("CANCELLED", e.what());
+
 	} catch (job_unrecoverable_exception &e) {
 		logger_->error("Job evaluator encountered unrecoverable error: {}", e.what());
 		progress_callback_->job_build_failed(job_id_);
@@ -355,6 +509,9 @@ eval_response job_evaluator::evaluate(eval_request request)
 
 	logger_->info("Job ({}) ended.", job_id_);
 	cleanup_evaluator();
+	if (cancellation_ != nullptr) { cancellation_->finish(); }
 
-	return response.get_eval_response();
+	auto result = response.get_eval_response();
+	span.set("result", result.result);
+	return result;
 }
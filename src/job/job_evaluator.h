@@ -38,13 +38,15 @@ public:
 	 * @param cache_fm a file manager that works with a local cache
 	 * @param working_directory a directory in which the evaluation is done
 	 * @param progr_callback a callback for notifying the broker of progress
+	 * @param cancellation cancellation of jobs by the broker (optional)
 	 */
 	job_evaluator(std::shared_ptr<spdlog::logger> logger,
 		std::shared_ptr<worker_config> config,
 		std::shared_ptr<file_manager_interface> remote_fm,
 		std::shared_ptr<file_manager_interface> cache_fm,
 		fs::path working_directory,
-		std::shared_ptr<progress_callback_interface> progr_callback);
+		std::shared_ptr<progress_callback_interface> progr_callback,
+		std::shared_ptr<helpers::cancellation_token> cancellation = nullptr);
 
 	/**
 	 * Process an "eval" request
@@ -110,20 +112,51 @@ private:
 
 	/**
 	 * Initialize all paths used in job_evaluator. Has to be done before any other action.
+	 * The job is placed into the staging directory if it is enabled and has enough free space.
 	 * No throw function.
 	 */
 	void init_submission_paths();
 
+	/**
+	 * Set all paths of the submission under given base directory.
+	 * @param base_dir working directory or staging directory
+	 */
+	void set_submission_paths(const fs::path &base_dir);
+
+	/**
+	 * Move the job from the staging directory to the working directory if it takes more than the budget.
+	 * @param size size of the job input files in bytes
+	 * @param what description of the measured files for logging
+	 */
+	void check_staging_budget(std::uintmax_t size, const std::string &what);
+
+	/**
+	 * Move all directories of the job from the staging directory to the working directory.
+	 * @param reason why the job is moved, for logging
+	 */
+	void unstage(const std::string &reason);
+
 	/**
 	 * Initialize progress callback.
 	 * If given callback is nullptr, then construct empty one which can be called without doubts.
 	 */
 	void init_progress_callback();
 
+	/**
+	 * Construct cache of task results.
+	 * @param dir directory of the cache, empty if the cache is disabled
+	 * @param max_size maximal size of the cache in bytes
+	 * @param name name of the cache for logging
+	 * @return the cache or @a nullptr if it is disabled or cannot be used
+	 */
+	std::shared_ptr<task_cache> create_task_cache(const std::string &dir, std::size_t max_size, const std::string &name);
+
 
 	// PRIVATE DATA MEMBERS
 	/** Working directory of this whole program */
 	fs::path working_directory_;
+	/** Whether the job is placed in the staging directory (on a RAM-backed filesystem) */
+	bool staged_ = false;
 	/** URL of remote archive in which is job configuration and source codes */
 	std::string archive_url_;
 	/** Archive filename is just a name and not a path */
@@ -150,12 +183,18 @@ private:
 	std::shared_ptr<file_manager_interface> remote_fm_;
 	/** File manager used to download submission archives without caching */
 	std::shared_ptr<file_manager_interface> cache_fm_;
+	/** Cache of initiation tasks results, @a nullptr if it is disabled */
+	std::shared_ptr<task_cache> compilation_cache_;
+	/** Cache of judges verdicts, @a nullptr if it is disabled */
+	std::shared_ptr<task_cache> judge_cache_;
 	/** Logger given during construction */
 	std::shared_ptr<spdlog::logger> logger_;
 	/** Default configuration of worker */
 	std::shared_ptr<worker_config> config_;
 	/** Progress callback which is used to signal progress to whoever wants */
 	std::shared_ptr<progress_callback_interface> progress_callback_;
+	/** Cancellation of jobs by the broker, @a nullptr if jobs cannot be cancelled */
+	std::shared_ptr<helpers::cancellation_token> cancellation_;
 };
 
 #endif // RECODEX_WORKER_JOB_EVALUATOR_HPP
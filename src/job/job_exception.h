@@ -63,4 +63,25 @@ public:
 	~job_unrecoverable_exception() override = default;
 };
 
+
+/**
+ * Job was cancelled by the broker, remaining tasks are not executed.
+ */
+class job_cancelled_exception : public job_exception
+{
+public:
+	/**
+	 * Constructor with specified cause.
+	 * @param what cause of this exception
+	 */
+	job_cancelled_exception(const std::string &what) : job_exception(what)
+	{
+	}
+
+	/**
+	 * Stated for completion.
+	 */
+	~job_cancelled_exception() override = default;
+};
+
 #endif // RECODEX_WORKER_JOB_EXCEPTION_H
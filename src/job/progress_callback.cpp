@@ -18,12 +18,16 @@ void progress_callback::connect()
 	}
 }
 
-void progress_callback::send_job_status(
-	const std::string &func_name, const std::string &job_id, const std::string &job_status)
+void progress_callback::send_job_status(const char *func_name, const std::string &job_id, const char *job_status)
 {
 	try {
 		connect();
-		std::vector<std::string> msg = {command_, job_id, job_status};
+		// constant frames are not copied, identifiers are copied only into their frames
+		std::vector<zmq::message_t> msg;
+		msg.reserve(3);
+		msg.push_back(helpers::static_frame(command_));
+		msg.emplace_back(job_id.begin(), job_id.end());
+		msg.push_back(helpers::static_frame(job_status));
 		helpers::send_through_socket(socket_, msg);
 	} catch (...) {
 		logger_->warn("progress_callback: call of {} failed", func_name);
@@ -67,11 +71,17 @@ void progress_callback::job_aborted(const std::string &job_id)
 }
 
 void progress_callback::send_task_status(
-	const std::string &func_name, const std::string &job_id, const std::string &task_id, const std::string &task_status)
+	const char *func_name, const std::string &job_id, const std::string &task_id, const char *task_status)
 {
 	try {
 		connect();
-		std::vector<std::string> msg = {command_, job_id, "TASK", task_id, task_status};
+		std::vector<zmq::message_t> msg;
+		msg.reserve(5);
+		msg.push_back(helpers::static_frame(command_));
+		msg.emplace_back(job_id.begin(), job_id.end());
+		msg.push_back(helpers::static_frame("TASK"));
+		msg.emplace_back(task_id.begin(), task_id.end());
+		msg.push_back(helpers::static_frame(task_status));
 		helpers::send_through_socket(socket_, msg);
 	} catch (...) {
 		logger_->warn("progress_callback: call of {} failed", func_name);
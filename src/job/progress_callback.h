@@ -19,8 +19,8 @@ class progress_callback : public progress_callback_interface
 private:
 	/** Socket used to send progress information to broker_connection */
 	zmq::socket_t socket_;
-	/** String which is used as command in message */
-	std::string command_;
+	/** String which is used as command in message (static, it is sent without copying) */
+	const char *command_;
 	/** False if socket is not connected to another side */
 	bool connected_;
 	/** Spdlog logger shared among whole project */
@@ -36,21 +36,19 @@ private:
 	 * Helper function for sending job progress state to broker and beyond.
 	 * @param func_name name of function which calls this one
 	 * @param job_id identification of job
-	 * @param job_status status of job
+	 * @param job_status status of job (static string, it is sent without copying)
 	 */
-	void send_job_status(const std::string &func_name, const std::string &job_id, const std::string &job_status);
+	void send_job_status(const char *func_name, const std::string &job_id, const char *job_status);
 
 	/**
 	 * Helpers function for sending task progress state to broker and beyond.
 	 * @param func_name name of function which calls this one
 	 * @param job_id identification of job
 	 * @param task_id identification of task
-	 * @param task_status status of task
+	 * @param task_status status of task (static string, it is sent without copying)
 	 */
-	void send_task_status(const std::string &func_name,
-		const std::string &job_id,
-		const std::string &task_id,
-		const std::string &task_status);
+	void send_task_status(
+		const char *func_name, const std::string &job_id, const std::string &task_id, const char *task_status);
 
 public:
 	/**
@@ -0,0 +1,106 @@
+#include "box_pool.h"
+#include "isolate_box.h"
+#include "sandbox_base.h"
+#include "helpers/trace.h"
+#include <algorithm>
+
+box_pool::box_pool(const std::vector<std::size_t> &ids, std::shared_ptr<spdlog::logger> logger)
+	: ids_(ids), logger_(logger)
+{
+	if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
+}
+
+box_pool::~box_pool()
+{
+	discard();
+}
+
+void box_pool::prepare(const sandbox_limits &limits, const std::string &data_dir)
+{
+#ifndef _WIN32
+	std::size_t id;
+	if (!find_free_id(id)) {
+		logger_->debug("No free isolate box to be prepared in advance");
+		return;
+	}
+
+	auto logger = logger_;
+	auto parent = helpers::trace_span::current();
+	prepared_.push_back({id, data_dir, std::async(std::launch::async, [limits, id, data_dir, logger, parent]() {
+							 helpers::trace_span span("box_prepare", parent);
+							 span.set("box_id", id);
+							 return std::make_shared<isolate_box>(limits, id, data_dir, logger);
+						 })});
+	logger_->debug("Isolate box {} is being prepared in advance", id);
+#endif
+}
+
+std::shared_ptr<isolate_box> box_pool::get(const sandbox_limits &limits, const std::string &data_dir)
+{
+#ifndef _WIN32
+	// boxes are prepared in the order of tasks, so the oldest suitable one belongs to the current task
+	std::shared_ptr<isolate_box> box;
+	for (auto it = prepared_.begin(); it != prepared_.end(); ++it) {
+		if (it->data_dir != data_dir) { continue; }
+
+		box = take_prepared(*it);
+		prepared_.erase(it);
+		if (box != nullptr && !box->is_compatible(limits, data_dir)) {
+			logger_->debug("Isolate box {} prepared in advance does not suit the task", box->get_id());
+			box = nullptr; // cleaned up, so its id can be used right now
+		}
+		break;
+	}
+
+	if (box == nullptr) {
+		std::size_t id;
+		while (!find_free_id(id)) {
+			if (prepared_.empty()) { log_and_throw(logger_, "No free isolate box, all of them are in use"); }
+
+			// boxes prepared for tasks which were not run (e.g., skipped ones) are not needed anymore
+			take_prepared(prepared_.front());
+			prepared_.pop_front();
+		}
+		box = std::make_shared<isolate_box>(limits, id, data_dir, logger_);
+	}
+
+	boxes_[box->get_id()] = box;
+	return box;
+#else
+	log_and_throw(logger_, "Isolate boxes are not supported on this platform");
+	return nullptr; // never reached
+#endif
+}
+
+void box_pool::discard()
+{
+	for (auto &prepared : prepared_) { take_prepared(prepared); }
+	prepared_.clear();
+}
+
+bool box_pool::find_free_id(std::size_t &id)
+{
+	for (auto candidate : ids_) {
+		auto prepared = std::find_if(prepared_.begin(), prepared_.end(), [candidate](const prepared_box &item) {
+			return item.id == candidate;
+		});
+		if (prepared != prepared_.end()) { continue; }
+		auto it = boxes_.find(candidate);
+		if (it != boxes_.end() && !it->second.expired()) { continue; }
+
+		id = candidate;
+		return true;
+	}
+
+	return false;
+}
+
+std::shared_ptr<isolate_box> box_pool::take_prepared(prepared_box &prepared)
+{
+	try {
+		return prepared.box.get();
+	} catch (std::exception &e) {
+		logger_->warn("Isolate box {} was not prepared in advance: {}", prepared.id, e.what());
+		return nullptr;
+	}
+}
@@ -0,0 +1,98 @@
+#ifndef RECODEX_WORKER_FILE_BOX_POOL_H
+#define RECODEX_WORKER_FILE_BOX_POOL_H
+
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "helpers/logger.h"
+#include "config/sandbox_limits.h"
+
+class isolate_box;
+
+/**
+ * Isolate boxes of one worker, which can be initialized in advance.
+ *
+ * The worker has more box identifiers, so the box of the next task can be initialized in the background while
+ * the program of the current task runs in another box. Only the initialization is done in advance, the data are
+ * moved into the box when the task runs (i.e., when the outputs of its dependencies are available).
+ */
+class box_pool
+{
+public:
+	/**
+	 * Constructor.
+	 * @param ids identifiers of boxes which belong to this worker (unique on the machine)
+	 * @param logger Set system logger (optional).
+	 */
+	box_pool(const std::vector<std::size_t> &ids, std::shared_ptr<spdlog::logger> logger = nullptr);
+
+	box_pool(const box_pool &source) = delete;
+	box_pool &operator=(const box_pool &source) = delete;
+
+	/**
+	 * Destructor, waits for the boxes being prepared and cleans them up.
+	 */
+	~box_pool();
+
+	/**
+	 * Start initialization of a box for a task in the background. Nothing happens if there is no free identifier.
+	 * Errors are only logged, the box is then initialized when it is needed.
+	 * @param limits limits of the task (only disk quotas are used)
+	 * @param data_dir data directory of the task
+	 */
+	void prepare(const sandbox_limits &limits, const std::string &data_dir);
+
+	/**
+	 * Get a box for a task. A prepared box is used if it is compatible, otherwise a new box is initialized
+	 * (prepared boxes are cleaned up if there is no free identifier for it).
+	 * @param limits limits of the task
+	 * @param data_dir data directory of the task
+	 * @return initialized box, its identifier is free again when the box is destroyed
+	 * @throws sandbox_exception if the box cannot be initialized or all identifiers are used
+	 */
+	std::shared_ptr<isolate_box> get(const sandbox_limits &limits, const std::string &data_dir);
+
+	/**
+	 * Clean up all prepared boxes.
+	 */
+	void discard();
+
+private:
+	/** Box initialized in the background */
+	struct prepared_box {
+		/** Identifier of the box */
+		std::size_t id;
+		/** Data directory of the box */
+		std::string data_dir;
+		/** The box, when it is initialized */
+		std::future<std::shared_ptr<isolate_box>> box;
+	};
+
+	/**
+	 * Find an identifier which is not used by any existing or prepared box.
+	 * @param id found identifier
+	 * @return false if all identifiers are used
+	 */
+	bool find_free_id(std::size_t &id);
+
+	/**
+	 * Wait for a prepared box.
+	 * @param prepared the box
+	 * @return the box or @a nullptr if the preparation failed
+	 */
+	std::shared_ptr<isolate_box> take_prepared(prepared_box &prepared);
+
+	/** Identifiers of boxes of this worker */
+	std::vector<std::size_t> ids_;
+	/** Boxes given to tasks, by their identifiers */
+	std::map<std::size_t, std::weak_ptr<isolate_box>> boxes_;
+	/** Boxes being prepared in the background, the oldest first */
+	std::list<prepared_box> prepared_;
+	/** System logger */
+	std::shared_ptr<spdlog::logger> logger_;
+};
+
+#endif // RECODEX_WORKER_FILE_BOX_POOL_H
@@ -0,0 +1,27 @@
+#include "box_session.h"
+#include "isolate_box.h"
+
+std::shared_ptr<isolate_box> box_session::get_box(const std::string &test_id) const
+{
+	if (test_id.empty() || test_id != test_id_) { return nullptr; }
+	return box_;
+}
+
+void box_session::open(const std::string &test_id, std::shared_ptr<isolate_box> box)
+{
+	close();
+	test_id_ = test_id;
+	box_ = box;
+}
+
+void box_session::close()
+{
+	auto box = box_;
+	test_id_.clear();
+	box_ = nullptr;
+
+#ifndef _WIN32
+	// the box is cleaned up when the last reference is dropped, only the data are moved out explicitly
+	if (box != nullptr) { box->move_out(); }
+#endif
+}
@@ -0,0 +1,46 @@
+#ifndef RECODEX_WORKER_FILE_BOX_SESSION_H
+#define RECODEX_WORKER_FILE_BOX_SESSION_H
+
+#include <memory>
+#include <string>
+
+class isolate_box;
+
+/**
+ * Sandbox box shared by consecutive tasks of one test.
+ *
+ * The first sandboxed task of a test opens the session with a new box, following sandboxed tasks of the same test
+ * reuse the box with the data directory already inside. The job closes the session whenever the chain of tasks
+ * of the test ends (i.e., before any other task and at the end of the job), which moves the data out of the box.
+ */
+class box_session
+{
+public:
+	/**
+	 * Get the box of the session if it belongs to given test.
+	 * @param test_id identification of the test, sessions are never opened for an empty one
+	 * @return the box or @a nullptr if the session is closed or belongs to another test
+	 */
+	std::shared_ptr<isolate_box> get_box(const std::string &test_id) const;
+
+	/**
+	 * Open the session for given test, previously opened session is closed first.
+	 * @param test_id identification of the test
+	 * @param box initialized box
+	 */
+	void open(const std::string &test_id, std::shared_ptr<isolate_box> box);
+
+	/**
+	 * Close the session, move the data out of the box and clean it up. Nothing happens if no session is open.
+	 * @throws sandbox_exception if the data cannot be moved out of the box
+	 */
+	void close();
+
+private:
+	/** Test which owns the box */
+	std::string test_id_;
+	/** Box of the session, @a nullptr if the session is closed */
+	std::shared_ptr<isolate_box> box_;
+};
+
+#endif // RECODEX_WORKER_FILE_BOX_SESSION_H
@@ -0,0 +1,118 @@
+#include "cgroup_sampler.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	/**
+	 * Read a single number from a cgroup file.
+	 */
+	bool read_value(const fs::path &file, std::size_t &value)
+	{
+		std::ifstream in(file.string());
+		return static_cast<bool>(in >> value);
+	}
+} // namespace
+
+
+cgroup_sampler::cgroup_sampler(const fs::path &cgroup_dir, std::chrono::milliseconds interval, std::size_t max_samples)
+	: cgroup_dir_(cgroup_dir), interval_(std::max(interval, std::chrono::milliseconds(1))),
+	  max_samples_(std::max(max_samples, (std::size_t) 2))
+{
+}
+
+cgroup_sampler::~cgroup_sampler()
+{
+	stop();
+}
+
+void cgroup_sampler::start()
+{
+	stopped_ = false;
+	samples_.clear();
+	thread_ = std::thread(&cgroup_sampler::sample_loop, this);
+}
+
+std::vector<resource_sample> cgroup_sampler::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopped_ = true;
+	}
+	stop_cv_.notify_all();
+	if (thread_.joinable()) { thread_.join(); }
+
+	return samples_;
+}
+
+bool cgroup_sampler::read_sample(const fs::path &cgroup_dir, resource_sample &sample)
+{
+	std::size_t memory;
+	if (!read_value(cgroup_dir / "memory.current", memory)) { return false; }
+	sample.memory = memory / 1024;
+
+	std::ifstream cpu_stat((cgroup_dir / "cpu.stat").string());
+	std::string key;
+	std::size_t value;
+	while (cpu_stat >> key >> value) {
+		if (key == "usage_usec") {
+			sample.cpu_time = value / 1000;
+			break;
+		}
+	}
+
+	// one line per device, e.g. "8:0 rbytes=1459200 wbytes=314773504 rios=192 wios=353 dbytes=0 dios=0"
+	std::ifstream io_stat((cgroup_dir / "io.stat").string());
+	std::string line;
+	sample.io_read = 0;
+	sample.io_write = 0;
+	while (std::getline(io_stat, line)) {
+		std::istringstream fields(line);
+		std::string field;
+		fields >> field; // device
+		while (fields >> field) {
+			auto pos = field.find('=');
+			if (pos == std::string::npos) { continue; }
+			auto name = field.substr(0, pos);
+			if (name != "rbytes" && name != "wbytes") { continue; }
+			try {
+				(name == "rbytes" ? sample.io_read : sample.io_write) += std::stoul(field.substr(pos + 1));
+			} catch (std::exception &) {
+				// malformed value, ignored
+			}
+		}
+	}
+
+	read_value(cgroup_dir / "pids.current", sample.pids);
+	return true;
+}
+
+void cgroup_sampler::sample_loop()
+{
+	auto begin = std::chrono::steady_clock::now();
+	auto next = begin;
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	while (!stopped_) {
+		lock.unlock();
+		resource_sample sample;
+		if (read_sample(cgroup_dir_, sample)) {
+			sample.time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin)
+							  .count();
+
+			if (samples_.size() >= max_samples_) {
+				// halve the resolution, keep every other sample (including the first one)
+				std::size_t kept = 0;
+				for (std::size_t i = 0; i < samples_.size(); i += 2) { samples_[kept++] = samples_[i]; }
+				samples_.resize(kept);
+				interval_ *= 2;
+			}
+			samples_.push_back(sample);
+		}
+		lock.lock();
+
+		next += interval_;
+		stop_cv_.wait_until(lock, next, [this] { return stopped_; });
+	}
+}
@@ -0,0 +1,83 @@
+#ifndef RECODEX_WORKER_FILE_CGROUP_SAMPLER_H
+#define RECODEX_WORKER_FILE_CGROUP_SAMPLER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "config/task_results.h"
+
+namespace fs = std::filesystem;
+
+
+/**
+ * Periodic sampling of resource usage of a cgroup (version 2) in a background thread.
+ *
+ * Samples are taken from @a memory.current, @a cpu.stat, @a io.stat and @a pids.current files of the cgroup. The cgroup
+ * need not exist when the sampling starts (isolate creates it when the program is started), moments when it does not
+ * exist are skipped. The number of samples is bounded, when the limit is reached, every other sample is dropped and
+ * the interval is doubled, so the samples cover the whole run with decreasing resolution.
+ */
+class cgroup_sampler
+{
+public:
+	/**
+	 * Constructor.
+	 * @param cgroup_dir directory of the sampled cgroup
+	 * @param interval initial interval of sampling
+	 * @param max_samples maximal number of kept samples (at least 2)
+	 */
+	cgroup_sampler(const fs::path &cgroup_dir, std::chrono::milliseconds interval, std::size_t max_samples);
+
+	cgroup_sampler(const cgroup_sampler &source) = delete;
+	cgroup_sampler &operator=(const cgroup_sampler &source) = delete;
+
+	/**
+	 * Destructor, stops the sampling if it is running.
+	 */
+	~cgroup_sampler();
+
+	/**
+	 * Start the sampling thread.
+	 */
+	void start();
+
+	/**
+	 * Stop the sampling thread.
+	 * @return taken samples, ordered by time
+	 */
+	std::vector<resource_sample> stop();
+
+	/**
+	 * Read current resource usage of a cgroup.
+	 * @param cgroup_dir directory of the cgroup
+	 * @param sample the sample to be filled (except for the time)
+	 * @return false if the cgroup does not exist (memory usage cannot be read), missing other files are ignored
+	 */
+	static bool read_sample(const fs::path &cgroup_dir, resource_sample &sample);
+
+private:
+	/** Body of the sampling thread. */
+	void sample_loop();
+
+	/** Directory of the sampled cgroup */
+	fs::path cgroup_dir_;
+	/** Current interval of sampling */
+	std::chrono::milliseconds interval_;
+	/** Maximal number of samples */
+	std::size_t max_samples_;
+	/** Taken samples */
+	std::vector<resource_sample> samples_;
+	/** Sampling thread */
+	std::thread thread_;
+	/** Protects @a stopped_ */
+	std::mutex mutex_;
+	/** Wakes up the sampling thread when it should stop */
+	std::condition_variable stop_cv_;
+	/** Whether the sampling should stop */
+	bool stopped_ = false;
+};
+
+#endif // RECODEX_WORKER_FILE_CGROUP_SAMPLER_H
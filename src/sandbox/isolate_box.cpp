@@ -0,0 +1,243 @@
+#ifndef _WIN32
+
+#include "isolate_box.h"
+#include "sandbox_base.h"
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mount.h>
+#include <sys/wait.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <vector>
+#include <filesystem>
+#include "helpers/affinity.h"
+#include "helpers/filesystem.h"
+#include "helpers/trace.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	void move_or_throw(std::shared_ptr<spdlog::logger> logger, const std::string &from, const std::string &to)
+	{
+		try {
+			helpers::copy_directory(from, to, true); // true = skip symlinks for security reasons
+		} catch (fs::filesystem_error &e) {
+			log_and_throw(logger, "Failed moving ", from, " to ", to, ", error: ", e.what());
+		}
+
+		try {
+			fs::remove_all(from);
+		} catch (fs::filesystem_error &) {
+		}
+	}
+} // namespace
+
+isolate_box::isolate_box(
+	const sandbox_limits &limits, std::size_t id, const std::string &data_dir, std::shared_ptr<spdlog::logger> logger)
+	: logger_(logger), id_(id), isolate_binary_("isolate"), disk_quotas_(limits.disk_quotas),
+	  disk_size_(limits.disk_size), disk_files_(limits.disk_files), data_dir_(data_dir), data_inside_(false)
+{
+	if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
+
+	isolate_init();
+}
+
+isolate_box::~isolate_box()
+{
+	try {
+		move_out();
+	} catch (...) {
+		// already logged, the data are lost anyway
+	}
+
+	try {
+		isolate_cleanup();
+	} catch (...) {
+		// We don't care if this failed. We can't fix it either. Just don't throw an exception in destructor.
+	}
+}
+
+std::size_t isolate_box::get_id() const
+{
+	return id_;
+}
+
+const std::string &isolate_box::get_dir() const
+{
+	return sandboxed_dir_;
+}
+
+const std::string &isolate_box::get_data_dir() const
+{
+	return data_inside_ ? sandboxed_dir_ : data_dir_;
+}
+
+bool isolate_box::is_compatible(const sandbox_limits &limits, const std::string &data_dir) const
+{
+	if (data_dir != data_dir_ || limits.disk_quotas != disk_quotas_) { return false; }
+	return !disk_quotas_ || (limits.disk_size == disk_size_ && limits.disk_files == disk_files_);
+}
+
+void isolate_box::move_in()
+{
+	if (data_dir_ == "") { return; }
+
+	if (data_inside_) {
+		// temporary files of the previous run are not visible to the next one, as if the box was fresh
+		std::error_code ec;
+		fs::path tmp_dir = fs::path(sandboxed_dir_).parent_path() / "tmp";
+		for (auto &entry : fs::directory_iterator(tmp_dir, ec)) { fs::remove_all(entry.path(), ec); }
+		return;
+	}
+
+	helpers::trace_span span("box_move_in");
+	span.set("box_id", id_);
+	move_or_throw(logger_, data_dir_, sandboxed_dir_);
+	data_inside_ = true;
+}
+
+void isolate_box::move_out()
+{
+	if (!data_inside_) { return; }
+
+	// the data are considered outside even if moving fails, there is no point in trying again
+	data_inside_ = false;
+	helpers::trace_span span("box_move_out");
+	span.set("box_id", id_);
+	move_or_throw(logger_, sandboxed_dir_, data_dir_);
+}
+
+void isolate_box::isolate_init()
+{
+	int fd[2];
+	pid_t childpid;
+
+	helpers::trace_span span("box_init");
+	span.set("box_id", id_);
+	logger_->debug("Initializing isolate...");
+
+	// arguments are prepared before the fork, the child must not take any lock (of the logger, ...), which could be
+	// held by another thread at the time of the fork (boxes are prepared in parallel with runs)
+	auto args = isolate_init_args();
+	std::vector<char *> c_args;
+	for (auto &arg : args) { c_args.push_back(&arg[0]); }
+	c_args.push_back(nullptr);
+
+	// Create unnamend pipe, children forked by other threads must not inherit it, the read would not end
+	if (pipe2(fd, O_CLOEXEC) == -1) { log_and_throw(logger_, "Cannot create pipe: ", strerror(errno)); }
+
+	childpid = fork();
+
+	switch (childpid) {
+	case -1: log_and_throw(logger_, "Fork failed: ", strerror(errno)); break;
+	case 0: isolate_init_child(fd[0], fd[1], c_args.data()); break;
+	default:
+		//---Parent---
+		// Close up input side of pipe
+		close(fd[1]);
+
+		char buf[256];
+		int ret;
+		while ((ret = read(fd[0], (void *) buf, 256)) > 0) {
+			if (buf[ret - 1] == '\n') { buf[ret - 1] = '\0'; }
+			sandboxed_dir_ += std::string(buf);
+		}
+		sandboxed_dir_ += "/box";
+		if (ret == -1) { log_and_throw(logger_, "Read from pipe error."); }
+
+		int status;
+		waitpid(childpid, &status, 0);
+		if (WEXITSTATUS(status) != 0) {
+			log_and_throw(logger_, "Isolate init error. Return value: ", WEXITSTATUS(status));
+		}
+		logger_->debug("Isolate initialized in {}", sandboxed_dir_);
+		close(fd[0]);
+		break;
+	}
+}
+
+std::vector<std::string> isolate_box::isolate_init_args()
+{
+	std::vector<std::string> args {isolate_binary_, "--cg", "--box-id=" + std::to_string(id_)};
+
+	if (disk_quotas_) {
+		// Calculate number of required blocks - total number of bytes divided by block size
+		auto disk_size_blocks = (disk_size_ * 1024) / BLOCK_SIZE; // BLOCK_SIZE is from sys/mount.h
+		args.push_back("--quota=" + std::to_string(disk_size_blocks) + "," + std::to_string(disk_files_));
+	}
+
+	args.push_back("--init");
+	return args;
+}
+
+void isolate_box::isolate_init_child(int fd_0, int fd_1, char **args)
+{
+	// Close up output side of pipe
+	close(fd_0);
+
+	// Close stdout, duplicate the input side of pipe to stdout
+	dup2(fd_1, 1);
+
+	// Redirect stderr to /dev/null file
+	int devnull;
+	devnull = open("/dev/null", O_WRONLY);
+	if (devnull == -1) { _exit(isolate_child_error); }
+	dup2(devnull, 2);
+
+	// isolate must not inherit the CPUs reserved for the worker (the box pool prepares boxes on worker threads)
+	helpers::reset_thread_cpu_affinity();
+
+	// Exec isolate init command
+	execvp(args[0], args);
+
+	// never reached unless exec explodes in our face, the parent reports the exit code
+	_exit(isolate_child_error);
+}
+
+void isolate_box::isolate_cleanup()
+{
+	pid_t childpid;
+
+	helpers::trace_span span("box_cleanup");
+	span.set("box_id", id_);
+	logger_->debug("Cleaning up isolate...");
+
+	// see isolate_init(), the child must not allocate or log
+	std::string box_id_arg("--box-id=" + std::to_string(id_));
+	const char *args[] = {isolate_binary_.c_str(), "--cg", box_id_arg.c_str(), "--cleanup", nullptr};
+
+	childpid = fork();
+
+	switch (childpid) {
+	case -1: log_and_throw(logger_, "Fork failed: ", strerror(errno)); break;
+	case 0:
+		//---Child---
+		// Redirect stderr to /dev/null file
+		int devnull;
+		devnull = open("/dev/null", O_WRONLY);
+		if (devnull == -1) { _exit(isolate_child_error); }
+		dup2(devnull, 2);
+		helpers::reset_thread_cpu_affinity();
+
+		// Exec isolate cleanup command
+		// const_cast is ugly, but this is working with C code - execv does not modify its arguments
+		execvp(args[0], const_cast<char **>(args));
+
+		// Never reached
+		_exit(isolate_child_error);
+		break;
+	default:
+		//---Parent---
+		int status;
+		waitpid(childpid, &status, 0);
+		if (WEXITSTATUS(status) != 0) {
+			log_and_throw(logger_, "Isolate cleanup error. Return value: ", WEXITSTATUS(status));
+		}
+		logger_->debug("Isolate box {} cleaned up.", id_);
+		break;
+	}
+}
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef RECODEX_WORKER_FILE_ISOLATE_BOX_H
+#define RECODEX_WORKER_FILE_ISOLATE_BOX_H
+
+#ifndef _WIN32
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "helpers/logger.h"
+#include "config/sandbox_limits.h"
+
+/**
+ * Initialized box of Isolate sandbox together with the data directory moved into it.
+ *
+ * The box is initialized on construction and cleaned up on destruction. Data directory is moved into the box
+ * before the first run and stays there until it is explicitly moved out, so consecutive runs in the same box
+ * (e.g., a solution and its judge) share the data without copying them back and forth.
+ * Disk quotas are set on initialization, so they are fixed for the whole life of the box.
+ */
+class isolate_box
+{
+public:
+	/**
+	 * Constructor, initializes the box.
+	 * @param limits Limits of the first command, only disk quotas are used.
+	 * @param id Number of current worker. This must be unique for each worker on one machine!
+	 * @param data_dir Directory containing sources which will be moved into the box (may be empty).
+	 * @param logger Set system logger (optional).
+	 * @throws sandbox_exception if isolate cannot be initialized
+	 */
+	isolate_box(const sandbox_limits &limits,
+		std::size_t id,
+		const std::string &data_dir,
+		std::shared_ptr<spdlog::logger> logger = nullptr);
+
+	isolate_box(const isolate_box &source) = delete;
+	isolate_box &operator=(const isolate_box &source) = delete;
+
+	/**
+	 * Destructor, moves the data out of the box (if they are inside) and cleans the box up.
+	 */
+	~isolate_box();
+
+	/**
+	 * Get identifier of the box.
+	 */
+	std::size_t get_id() const;
+
+	/**
+	 * Get directory of the box (as seen from outside).
+	 */
+	const std::string &get_dir() const;
+
+	/**
+	 * Get directory where the data currently are, i.e., the box when they were moved inside and the original
+	 * data directory otherwise.
+	 */
+	const std::string &get_data_dir() const;
+
+	/**
+	 * Check whether a command with given limits and data directory can run in this box.
+	 * @param limits limits of the command
+	 * @param data_dir data directory of the command
+	 * @return true if the data directory and disk quotas are the same
+	 */
+	bool is_compatible(const sandbox_limits &limits, const std::string &data_dir) const;
+
+	/**
+	 * Move the data directory into the box, nothing happens if the data are already inside.
+	 * Files left by previous runs in the temporary directory of the box are removed.
+	 * @throws sandbox_exception if the data cannot be moved
+	 */
+	void move_in();
+
+	/**
+	 * Move the data directory out of the box, nothing happens if the data are not inside.
+	 * @throws sandbox_exception if the data cannot be moved
+	 */
+	void move_out();
+
+private:
+	/** Initialize isolate */
+	void isolate_init();
+	/** Get isolate command line arguments of the initialization. */
+	std::vector<std::string> isolate_init_args();
+	/** Actual code for isolate initialization inside a process. Called by isolate_init(). */
+	void isolate_init_child(int fd_0, int fd_1, char **args);
+	/** Cleanup isolate after finish evaluation */
+	void isolate_cleanup();
+
+	/** Logger */
+	std::shared_ptr<spdlog::logger> logger_;
+	/** Identifier of this isolate's instance. Must be unique on each server. */
+	std::size_t id_;
+	/** Name of isolate binary - defaults "isolate" */
+	std::string isolate_binary_;
+	/** Whether disk quotas are set */
+	bool disk_quotas_;
+	/** Disk quota in kilobytes */
+	std::size_t disk_size_;
+	/** Disk quota in number of files */
+	std::size_t disk_files_;
+	/** Path to the directory containing sources moved to the box and back */
+	std::string data_dir_;
+	/** Path to the box (as seen from outside) */
+	std::string sandboxed_dir_;
+	/** Whether the data are inside the box */
+	bool data_inside_;
+};
+
+
+#endif // _WIN32
+#endif // RECODEX_WORKER_FILE_ISOLATE_BOX_H
@@ -1,6 +1,9 @@
 #ifndef _WIN32
 
 #include "isolate_sandbox.h"
+#include "cgroup_sampler.h"
+#include "helpers/affinity.h"
+#include "helpers/trace.h"
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/mount.h>
@@ -14,41 +17,53 @@
 #include <fstream>
 #include <map>
 #include <filesystem>
-#include "helpers/filesystem.h"
 
 namespace fs = std::filesystem;
 
-namespace
+isolate_sandbox::isolate_sandbox(std::shared_ptr<sandbox_config> sandbox_config,
+	sandbox_limits limits,
+	std::size_t id,
+	const std::string &temp_dir,
+	const std::string &data_dir,
+	std::shared_ptr<spdlog::logger> logger)
+	: sandbox_config_(sandbox_config), limits_(limits), logger_(logger), id_(id), isolate_binary_("isolate"),
+	  shared_box_(false), sampling_interval_(0), sampling_max_samples_(0)
 {
-	void move_or_throw(std::shared_ptr<spdlog::logger> logger, const std::string &from, const std::string &to)
-	{
-		try {
-			helpers::copy_directory(from, to, true); // true = skip symlinks for security reasons
-		} catch (fs::filesystem_error &e) {
-			log_and_throw(logger, "Failed moving ", from, " to ", to, ", error: ", e.what());
-		}
+	if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
 
-		try {
-			fs::remove_all(from);
-		} catch (fs::filesystem_error &) {
-		}
+	if (data_dir == "") { logger_->info("Empty data directory for moving to sandbox."); }
+
+	init(temp_dir);
+
+	try {
+		box_ = std::make_shared<isolate_box>(limits_, id_, data_dir, logger_);
+	} catch (...) {
+		fs::remove_all(temp_dir_);
+		throw;
 	}
-} // namespace
+	sandboxed_dir_ = box_->get_dir();
+}
 
 isolate_sandbox::isolate_sandbox(std::shared_ptr<sandbox_config> sandbox_config,
 	sandbox_limits limits,
-	std::size_t id,
+	std::shared_ptr<isolate_box> box,
 	const std::string &temp_dir,
-	const std::string &data_dir,
 	std::shared_ptr<spdlog::logger> logger)
-	: sandbox_config_(sandbox_config), limits_(limits), logger_(logger), id_(id), isolate_binary_("isolate"),
-	  data_dir_(data_dir)
+	: sandbox_config_(sandbox_config), limits_(limits), logger_(logger), id_(0), isolate_binary_("isolate"), box_(box),
+	  shared_box_(true), sampling_interval_(0), sampling_max_samples_(0)
 {
 	if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
 
-	if (sandbox_config_ == nullptr) { log_and_throw(logger_, "No sandbox configuration provided."); }
+	if (box_ == nullptr) { log_and_throw(logger_, "No isolate box provided."); }
+
+	id_ = box_->get_id();
+	init(temp_dir);
+	sandboxed_dir_ = box_->get_dir();
+}
 
-	if (data_dir_ == "") { logger_->info("Empty data directory for moving to sandbox."); }
+void isolate_sandbox::init(const std::string &temp_dir)
+{
+	if (sandbox_config_ == nullptr) { log_and_throw(logger_, "No sandbox configuration provided."); }
 
 	// Set backup limit (for killing isolate if it hasn't finished yet)
 	max_timeout_ = limits_.wall_time > limits_.cpu_time ? limits_.wall_time : limits_.cpu_time;
@@ -63,19 +78,13 @@ isolate_sandbox::isolate_sandbox(std::shared_ptr<sandbox_config> sandbox_config,
 	}
 
 	meta_file_ = (fs::path(temp_dir_) / "meta.log").string();
-
-	try {
-		isolate_init();
-	} catch (...) {
-		fs::remove_all(temp_dir_);
-		throw;
-	}
 }
 
 isolate_sandbox::~isolate_sandbox()
 {
 	try {
-		isolate_cleanup();
+		// own box is cleaned up here, shared one by its last owner
+		box_ = nullptr;
 		fs::remove_all(temp_dir_);
 	} catch (...) {
 		// We don't care if this failed. We can't fix it either. Just don't throw an exception in destructor.
@@ -84,183 +93,96 @@ isolate_sandbox::~isolate_sandbox()
 
 sandbox_results isolate_sandbox::run(const std::string &binary, const std::vector<std::string> &arguments)
 {
-	// move data to isolate directory
-	if (data_dir_ != "") { move_or_throw(logger_, data_dir_, sandboxed_dir_); }
+	helpers::trace_span span("sandbox");
+	span.set("box_id", id_);
+	span.set("binary", binary);
+
+	// move data to isolate directory (shared box may have them inside already)
+	box_->move_in();
 
 	try {
 		// run isolate
 		isolate_run(binary, arguments);
 
-		// move data from isolate directory back to data directory
-		if (data_dir_ != "") { move_or_throw(logger_, sandboxed_dir_, data_dir_); }
+		// move data from isolate directory back to data directory, unless following commands use them
+		if (!shared_box_) { box_->move_out(); }
 	} catch (const std::exception &) {
 		// on errors also move data from isolate directory back to data directory
-		if (data_dir_ != "") { move_or_throw(logger_, sandboxed_dir_, data_dir_); }
+		box_->move_out();
 
 		// rethrow the original exception when data are saved
 		throw;
 	}
 
-	return process_meta_file();
+	auto results = process_meta_file();
+	results.samples = samples_;
+	span.set("exitcode", results.exitcode);
+	span.set("exitsig", results.exitsig);
+	span.set("killed", results.killed);
+	span.set("time", results.time);
+	span.set("wall_time", results.wall_time);
+	span.set("memory", results.memory);
+	return results;
 }
 
-void isolate_sandbox::isolate_init()
+void isolate_sandbox::set_cpuset(const std::vector<std::size_t> &cpus, const std::vector<std::size_t> &mems)
 {
-	int fd[2];
-	pid_t childpid;
-
-	logger_->debug("Initializing isolate...");
-
-	// Create unnamend pipe
-	if (pipe(fd) == -1) { log_and_throw(logger_, "Cannot create pipe: ", strerror(errno)); }
-
-	childpid = fork();
-
-	switch (childpid) {
-	case -1: log_and_throw(logger_, "Fork failed: ", strerror(errno)); break;
-	case 0: isolate_init_child(fd[0], fd[1]); break;
-	default:
-		//---Parent---
-		// Close up input side of pipe
-		close(fd[1]);
-
-		char buf[256];
-		int ret;
-		while ((ret = read(fd[0], (void *) buf, 256)) > 0) {
-			if (buf[ret - 1] == '\n') { buf[ret - 1] = '\0'; }
-			sandboxed_dir_ += std::string(buf);
-		}
-		sandboxed_dir_ += "/box";
-		if (ret == -1) { log_and_throw(logger_, "Read from pipe error."); }
-
-		int status;
-		waitpid(childpid, &status, 0);
-		if (WEXITSTATUS(status) != 0) {
-			log_and_throw(logger_, "Isolate init error. Return value: ", WEXITSTATUS(status));
-		}
-		logger_->debug("Isolate initialized in {}", sandboxed_dir_);
-		close(fd[0]);
-		break;
-	}
+	cpus_ = cpus;
+	mems_ = mems;
 }
 
-void isolate_sandbox::isolate_init_child(int fd_0, int fd_1)
+void isolate_sandbox::set_sampling(
+	std::chrono::milliseconds interval, std::size_t max_samples, const std::string &cgroup_root)
 {
-	// Close up output side of pipe
-	close(fd_0);
-
-	// Close stdout, duplicate the input side of pipe to stdout
-	dup2(fd_1, 1);
-
-	// Redirect stderr to /dev/null file
-	int devnull;
-	devnull = open("/dev/null", O_WRONLY);
-	if (devnull == -1) { log_and_throw(logger_, "Cannot open /dev/null file for writing."); }
-	dup2(devnull, 2);
-
-	std::string box_id_arg("--box-id=" + std::to_string(id_));
-
-	// Exec isolate init command
-	std::vector<const char *> args {
-		isolate_binary_.c_str(),
-		"--cg",
-		box_id_arg.c_str(),
-	};
-
-	std::string quota_arg;
-	if (limits_.disk_quotas) {
-		// Calculate number of required blocks - total number of bytes divided by block size
-		auto disk_size_blocks = (limits_.disk_size * 1024) / BLOCK_SIZE; // BLOCK_SIZE is from sys/mount.h
-		quota_arg = "--quota=" + std::to_string(disk_size_blocks) + "," + std::to_string(limits_.disk_files);
-		args.push_back(quota_arg.c_str());
-	}
-
-	args.push_back("--init");
-	args.push_back(nullptr);
-
-	// const_cast is ugly, but this is working with C code - execv does not modify its arguments
-	execvp(isolate_binary_.c_str(), const_cast<char **>(&args[0]));
-
-	// never reached unless exec explodes in our face
-	log_and_throw(logger_, "Exec returned to child: ", strerror(errno));
+	sampling_interval_ = interval;
+	sampling_max_samples_ = max_samples;
+	sampling_cgroup_root_ = cgroup_root;
 }
 
-void isolate_sandbox::isolate_cleanup()
+void isolate_sandbox::set_cancellation(std::shared_ptr<helpers::cancellation_token> cancellation)
 {
-	pid_t childpid;
-
-	logger_->debug("Cleaning up isolate...");
-
-	childpid = fork();
-
-	switch (childpid) {
-	case -1: log_and_throw(logger_, "Fork failed: ", strerror(errno)); break;
-	case 0:
-		//---Child---
-		// Redirect stderr to /dev/null file
-		int devnull;
-		devnull = open("/dev/null", O_WRONLY);
-		if (devnull == -1) { log_and_throw(logger_, "Cannot open /dev/null file for writing."); }
-		dup2(devnull, 2);
-
-		// Exec isolate cleanup command
-		const char *args[5];
-		args[0] = isolate_binary_.c_str();
-		args[1] = "--cg";
-		args[2] = strdup(("--box-id=" + std::to_string(id_)).c_str());
-		args[3] = "--cleanup";
-		args[4] = NULL;
-		// const_cast is ugly, but this is working with C code - execv does not modify its arguments
-		execvp(isolate_binary_.c_str(), const_cast<char **>(args));
-
-		// Never reached
-		free(const_cast<char *>(args[2]));
-
-		log_and_throw(logger_, "Exec returned to child: ", strerror(errno));
-		break;
-	default:
-		//---Parent---
-		int status;
-		waitpid(childpid, &status, 0);
-		if (WEXITSTATUS(status) != 0) {
-			log_and_throw(logger_, "Isolate cleanup error. Return value: ", WEXITSTATUS(status));
-		}
-		logger_->debug("Isolate box {} cleaned up.", id_);
-		break;
-	}
+	cancellation_ = cancellation;
 }
 
 void isolate_sandbox::isolate_run(const std::string &binary, const std::vector<std::string> &arguments)
 {
 	pid_t childpid;
 
+	helpers::trace_span span("isolate_run");
+	span.set("box_id", id_);
 	logger_->debug("Running isolate...");
-	logger_->debug("Running the first fork");
 
+	// everything is prepared (and logged) before the fork, the child must not take any lock (of the logger, ...),
+	// which could be held by another thread at the time of the fork
+	auto args = isolate_run_args(binary, arguments);
+	std::vector<char *> c_args;
+	for (auto &arg : args) { c_args.push_back(&arg[0]); }
+	c_args.push_back(nullptr);
+
+	logger_->debug("Running the first fork");
 	childpid = fork();
 
 	switch (childpid) {
 	case -1: log_and_throw(logger_, "Fork failed: ", strerror(errno)); break;
 	case 0: {
 		//---Child---
-		logger_->debug("Returned from the first fork as child");
-
 		// Redirect stderr and stdout to /dev/null file
 		int devnull;
 		devnull = open("/dev/null", O_WRONLY);
-		if (devnull == -1) { log_and_throw(logger_, "Cannot open /dev/null file for writing."); }
+		if (devnull == -1) { _exit(isolate_child_error); }
 		dup2(devnull, 0); // Don't allow process inside isolate to read from current standard input
 		dup2(devnull, 1);
 		dup2(devnull, 2);
 
-		auto args = isolate_run_args(binary, arguments);
-		execvp(isolate_binary_.c_str(), args);
+		// affinity and memory policy are inherited by isolate and the sandboxed program, without box CPUs the thread
+		// gets back the affinity of the process before the worker was pinned, failures are reported on worker start
+		helpers::set_thread_cpu_affinity(cpus_);
+		helpers::set_thread_memory_nodes(mems_);
 
-		// Never reached
-		for(char **arg = args; *arg; arg++) { free(*arg); }
-		delete[] args;
+		execvp(c_args[0], c_args.data());
 
-		log_and_throw(logger_, "Exec returned to child: ", strerror(errno));
+		// exec failed, reported by the parent as an internal error of isolate
+		_exit(isolate_child_error);
 	} break;
 	default: {
 		//---Parent---
@@ -271,6 +193,11 @@ void isolate_sandbox::isolate_run(const std::string &binary, const std::vector<s
 
 		logger_->debug("Returned from the first fork as parent");
 
+		// cancellation of the job terminates isolate, which kills the program and cleans up the box
+		if (cancellation_ != nullptr && !cancellation_->attach_process(childpid)) {
+			logger_->info("Job was cancelled, isolate process is terminated");
+		}
+
 		pid_t controlpid;
 		logger_->debug("Running the second fork");
 		controlpid = fork();
@@ -279,26 +206,49 @@ void isolate_sandbox::isolate_run(const std::string &binary, const std::vector<s
 		case 0:
 			// Child---
 			{
-				logger_->debug("Returned from the second fork as child (control process)");
-
+				// no logging here either, see the first fork
 				int remaining = max_timeout_;
 				// Sleep can be interrupted by signal, so make sure to sleep whole time
 				while (remaining > 0) { remaining = sleep(remaining); }
 				kill(childpid, SIGKILL);
+				_exit(0);
 			}
 			break;
 		default:
 			// Parent---
 			logger_->debug("Returned from the second fork as parent");
 
+			// sample resource usage of the box while isolate is running (threads are started after the forks)
+			std::unique_ptr<cgroup_sampler> sampler;
+			samples_.clear();
+			if (sampling_interval_.count() > 0) {
+				sampler = std::make_unique<cgroup_sampler>(fs::path(sampling_cgroup_root_) / ("box-" + std::to_string(id_)),
+					sampling_interval_,
+					sampling_max_samples_);
+				sampler->start();
+			}
+
 			int status;
-			// Wait for isolate process. Waitpid returns no much longer than timeout if not earlier.
-			waitpid(childpid, &status, 0);
+			// Wait for isolate process. Waitid returns no much longer than timeout if not earlier. The process is
+			// left as a zombie until nobody can signal it (the cancellation and the control process), so its pid
+			// cannot be reused by an unrelated process in the meantime.
+			siginfo_t info;
+			while (waitid(P_PID, childpid, &info, WEXITED | WNOWAIT) == -1 && errno == EINTR) {}
+			if (cancellation_ != nullptr) { cancellation_->detach_process(); }
+			if (sampler != nullptr) {
+				samples_ = sampler->stop();
+				logger_->debug("Taken {} resource usage samples of box {}", samples_.size(), id_);
+			}
 			// Kill control process. If it already exits, nothing will be done
 			kill(controlpid, SIGKILL);
 			// Remove zombie from controll process.
 			waitpid(controlpid, NULL, 0);
+			// Remove zombie from isolate process.
+			waitpid(childpid, &status, 0);
 
+			if (cancellation_ != nullptr && cancellation_->is_cancelled()) {
+				log_and_throw(logger_, "Isolate run was cancelled together with the job.");
+			}
 			// isolate was killed
 			if (WIFSIGNALED(status)) {
 				log_and_throw(logger_, "Isolate process was killed by signal ", WTERMSIG(status), " due to timeout.");
@@ -314,7 +264,7 @@ void isolate_sandbox::isolate_run(const std::string &binary, const std::vector<s
 	}
 }
 
-char **isolate_sandbox::isolate_run_args(const std::string &binary, const std::vector<std::string> &arguments)
+std::vector<std::string> isolate_sandbox::isolate_run_args(const std::string &binary, const std::vector<std::string> &arguments)
 {
 	std::vector<std::string> vargs;
 
@@ -369,15 +319,8 @@ char **isolate_sandbox::isolate_run_args(const std::string &binary, const std::v
 	vargs.push_back(binary);
 	for (auto &i : arguments) { vargs.push_back(i); }
 
-	// Convert string to char ** for execv call
-	char **c_args = new char *[vargs.size() + 1];
-	int i = 0;
-	for (auto &it : vargs) {
-		c_args[i++] = strdup(it.c_str());
-		logger_->debug("  {}", it);
-	}
-	c_args[i] = NULL;
-	return c_args;
+	for (auto &it : vargs) { logger_->debug("  {}", it); }
+	return vargs;
 }
 
 sandbox_results isolate_sandbox::process_meta_file()
@@ -3,10 +3,13 @@
 
 #ifndef _WIN32
 
+#include <chrono>
 #include <memory>
 #include <vector>
 #include "helpers/logger.h"
+#include "helpers/cancellation_token.h"
 #include "sandbox_base.h"
+#include "isolate_box.h"
 #include "config/sandbox_config.h"
 
 /**
@@ -24,6 +27,10 @@
  * usage, but it's another safety feature when the app inside can break isolate (which
  * is unlikely).
  *
+ * The box itself is represented by @ref isolate_box. It is either created and destroyed with the sandbox or shared
+ * by more sandboxes run one after another. The data directory stays in a shared box after the run, limits and meta
+ * file are separate for each sandbox.
+ *
  * @note Requirements are Linux OS with Isolate installed. For detailed instructions see
  * Isolate's manual page. Isolate binary must be named "isolate" and must be in PATH
  * (default installer of Isolate meets these requirements).
@@ -45,12 +52,46 @@ public:
 		const std::string &temp_dir,
 		const std::string &data_dir,
 		std::shared_ptr<spdlog::logger> logger = nullptr);
+	/**
+	 * Constructor which runs the command in an already initialized box. The data directory of the box is moved
+	 * into it on run and it is left there, the owner of the box moves it out.
+	 * @param limits Limits for current command, disk quotas must match the ones of the box.
+	 * @param box Shared isolate box.
+	 * @param temp_dir Directory to store temporary files (generated isolate's meta log)
+	 * @param logger Set system logger (optional).
+	 */
+	isolate_sandbox(std::shared_ptr<sandbox_config> sandbox_config,
+		sandbox_limits limits,
+		std::shared_ptr<isolate_box> box,
+		const std::string &temp_dir,
+		std::shared_ptr<spdlog::logger> logger = nullptr);
 	/**
 	 * Destructor.
 	 */
 	~isolate_sandbox() override;
 	sandbox_results run(const std::string &binary, const std::vector<std::string> &arguments) override;
 
+	/**
+	 * Enable sampling of resource usage of the program from the cgroup of the box during the run.
+	 * @param interval interval of sampling, zero disables the sampling
+	 * @param max_samples maximal number of samples
+	 * @param cgroup_root directory containing cgroups of isolate boxes
+	 */
+	void set_sampling(std::chrono::milliseconds interval, std::size_t max_samples, const std::string &cgroup_root);
+
+	/**
+	 * Restrict the program to given CPUs and NUMA memory nodes.
+	 * @param cpus list of CPUs, empty if not restricted
+	 * @param mems list of memory nodes, empty if not restricted
+	 */
+	void set_cpuset(const std::vector<std::size_t> &cpus, const std::vector<std::size_t> &mems);
+
+	/**
+	 * Terminate the program when the job is cancelled.
+	 * @param cancellation cancellation of the job, @a nullptr if it cannot be cancelled
+	 */
+	void set_cancellation(std::shared_ptr<helpers::cancellation_token> cancellation);
+
 private:
 	/** General sandbox configuration */
 	std::shared_ptr<sandbox_config> sandbox_config_;
@@ -68,18 +109,30 @@ private:
 	std::string meta_file_;
 	/** Maximum time to run separate isolate process */
 	int max_timeout_;
-	/** Path to the directory containing sources moved to sandbox and back */
-	std::string data_dir_;
-	/** Initialize isolate */
-	void isolate_init();
-	/** Actual code for isolate initialization inside a process. Called by isolate_init(). */
-	void isolate_init_child(int fd_0, int fd_1);
-	/** Cleanup isolate after finish evaluation */
-	void isolate_cleanup();
+	/** Isolate box in which the command runs */
+	std::shared_ptr<isolate_box> box_;
+	/** Whether the box is shared with other sandboxes (data are not moved out after the run) */
+	bool shared_box_;
+	/** Interval of resource usage sampling, zero if disabled */
+	std::chrono::milliseconds sampling_interval_;
+	/** Maximal number of resource usage samples */
+	std::size_t sampling_max_samples_;
+	/** Directory containing cgroups of isolate boxes */
+	std::string sampling_cgroup_root_;
+	/** CPUs of the program, empty if not restricted */
+	std::vector<std::size_t> cpus_;
+	/** NUMA memory nodes of the program, empty if not restricted */
+	std::vector<std::size_t> mems_;
+	/** Cancellation of the job, isolate process is terminated when it is cancelled (optional) */
+	std::shared_ptr<helpers::cancellation_token> cancellation_;
+	/** Resource usage samples of the last run */
+	std::vector<resource_sample> samples_;
+	/** Common initialization of both constructors */
+	void init(const std::string &temp_dir);
 	/** Run isolate evaluation with sandboxed program inside. */
 	void isolate_run(const std::string &binary, const std::vector<std::string> &arguments);
-	/** Get isolate command line arguments as plain C string including sandboxed binary with its arguments. */
-	char **isolate_run_args(const std::string &binary, const std::vector<std::string> &arguments);
+	/** Get isolate command line arguments including sandboxed binary with its arguments. */
+	std::vector<std::string> isolate_run_args(const std::string &binary, const std::vector<std::string> &arguments);
 	/** Parse isolate's meta file with evaluation informations. Must be called after isolate_run() method. */
 	sandbox_results process_meta_file();
 };
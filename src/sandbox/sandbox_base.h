@@ -98,5 +98,11 @@ template <typename... T> void log_and_throw(std::shared_ptr<spdlog::logger> logg
 	throw sandbox_exception(message);
 }
 
+/**
+ * Exit code of a forked child which failed before the sandbox was executed (isolate uses 2 for internal errors).
+ * Such children exit without logging, the lock of the logger can be held by a thread which does not exist in them.
+ */
+const int isolate_child_error = 2;
+
 
 #endif // RECODEX_WORKER_FILE_SANDBOX_BASE_H
@@ -7,6 +7,9 @@
 #include "config/sandbox_config.h"
 #include "config/sandbox_limits.h"
 #include "config/task_metadata.h"
+#include "sandbox/box_session.h"
+#include "sandbox/box_pool.h"
+#include "helpers/cancellation_token.h"
 
 /** data for proper construction of @ref external_task class */
 struct create_params {
@@ -26,6 +29,12 @@ struct create_params {
 	fs::path source_path;
 	/** working directory which points inside sandbox */
 	fs::path sandbox_working_path;
+	/** box shared by consecutive tasks of one test (optional) */
+	std::shared_ptr<box_session> session;
+	/** isolate boxes of the worker which may be initialized in advance (optional) */
+	std::shared_ptr<box_pool> boxes;
+	/** cancellation of the job, the sandboxed program is terminated when the job is cancelled (optional) */
+	std::shared_ptr<helpers::cancellation_token> cancellation;
 };
 
 
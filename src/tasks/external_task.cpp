@@ -1,5 +1,6 @@
 #include "external_task.h"
 #include "sandbox/isolate_sandbox.h"
+#include "sandbox/isolate_box.h"
 #include "helpers/string_utils.h"
 #include "helpers/filesystem.h"
 #include <fstream>
@@ -10,10 +11,79 @@
 
 namespace fs = std::filesystem;
 
-external_task::external_task(const create_params &data)
+namespace
+{
+	/**
+	 * Get all files and symlinks in the directory (in a stable order).
+	 */
+	std::vector<fs::path> list_directory(const fs::path &dir)
+	{
+		std::vector<fs::path> files;
+		for (auto &entry : fs::recursive_directory_iterator(dir)) {
+			if (entry.is_symlink() || entry.is_regular_file()) { files.push_back(entry.path()); }
+		}
+		std::sort(files.begin(), files.end());
+		return files;
+	}
+
+	/**
+	 * Add names and content of all files in the directory to the hash.
+	 * @param cached digests of files are remembered (for directories which outlive the job, e.g. bound ones)
+	 */
+	void hash_directory(helpers::sha256 &hash, const fs::path &dir, bool cached)
+	{
+		auto files = list_directory(dir);
+		hash.update((std::uint64_t) files.size());
+		for (auto &file : files) {
+			hash.update(file.lexically_relative(dir).generic_string());
+			if (fs::is_symlink(file)) {
+				hash.update(fs::read_symlink(file).string());
+			} else if (cached) {
+				hash.update(helpers::cached_file_digest(file));
+			} else {
+				hash.update_file(file);
+			}
+		}
+	}
+
+	/**
+	 * Add names, sizes and modification times of the file or of all files in the directory to the hash. Content
+	 * is not read, installed packages are replaced as whole files.
+	 */
+	void hash_metadata(helpers::sha256 &hash, const fs::path &path)
+	{
+		std::error_code ec;
+		std::vector<fs::path> files;
+		if (fs::is_directory(path, ec)) {
+			files = list_directory(path);
+		} else if (fs::exists(fs::symlink_status(path, ec))) {
+			files.push_back(path);
+		}
+
+		hash.update(path.string());
+		hash.update((std::uint64_t) files.size());
+		for (auto &file : files) {
+			hash.update(file.string());
+			if (fs::is_symlink(file)) {
+				hash.update(fs::read_symlink(file).string());
+				continue;
+			}
+			auto size = fs::file_size(file, ec);
+			hash.update((std::uint64_t) (ec ? 0 : size));
+			auto modified = fs::last_write_time(file, ec);
+			hash.update((std::uint64_t) (ec ? 0 : modified.time_since_epoch().count()));
+		}
+	}
+} // namespace
+
+external_task::external_task(const create_params &data,
+	std::shared_ptr<task_cache> compilation_cache,
+	std::shared_ptr<task_cache> judge_cache)
 	: task_base(data.id, data.task_meta), worker_config_(data.worker_conf), sandbox_(nullptr),
 	  sandbox_config_(data.task_meta->sandbox), limits_(data.limits), logger_(data.logger), temp_dir_(data.temp_dir),
-	  evaluation_dir_(data.source_path), sandbox_working_dir_(data.sandbox_working_path)
+	  evaluation_dir_(data.source_path), sandbox_working_dir_(data.sandbox_working_path),
+	  compilation_cache_(compilation_cache), judge_cache_(judge_cache), session_(data.session), boxes_(data.boxes),
+	  cancellation_(data.cancellation)
 {
 	if (worker_config_ == nullptr) { throw task_exception("No worker configuration provided."); }
 
@@ -53,31 +123,94 @@ void external_task::sandbox_init()
 
 			// TODO: a better way would be to make this optional (a job will define, whether it requires net or not)
 		}
-		sandbox_ = std::make_shared<isolate_sandbox>(
-			sandbox_config_, limits, worker_config_->get_worker_id(), temp_dir_, evaluation_dir_.string(), logger_);
+
+		// tasks of one test share the box, so the data are not copied out and in between them
+		std::shared_ptr<isolate_box> box;
+		if (session_ != nullptr && !task_meta_->test_id.empty()) {
+			box = session_->get_box(task_meta_->test_id);
+			if (box == nullptr) {
+				// box of another test has to be cleaned up first, it may have the same id
+				session_->close();
+				box = acquire_box(limits);
+				session_->open(task_meta_->test_id, box);
+			}
+		} else if (boxes_ != nullptr) {
+			// box possibly initialized in advance, it is not shared, so the data are moved out right after the run
+			box = own_box_ = acquire_box(limits);
+		}
+
+		std::shared_ptr<isolate_sandbox> sandbox;
+		if (box != nullptr) {
+			sandbox = std::make_shared<isolate_sandbox>(sandbox_config_, limits, box, temp_dir_, logger_);
+		} else {
+			sandbox = std::make_shared<isolate_sandbox>(
+				sandbox_config_, limits, worker_config_->get_worker_id(), temp_dir_, evaluation_dir_.string(), logger_);
+		}
+		sandbox->set_sampling(worker_config_->get_sampling_interval(),
+			worker_config_->get_sampling_max_samples(),
+			worker_config_->get_sampling_cgroup_root());
+		sandbox->set_cpuset(worker_config_->get_box_cpus(), worker_config_->get_box_mems());
+		sandbox->set_cancellation(cancellation_);
+		sandbox_ = sandbox;
 	}
 #endif
 }
 
+std::shared_ptr<isolate_box> external_task::acquire_box(const sandbox_limits &limits)
+{
+#ifndef _WIN32
+	if (boxes_ != nullptr) { return boxes_->get(limits, evaluation_dir_.string()); }
+	return std::make_shared<isolate_box>(limits, worker_config_->get_worker_id(), evaluation_dir_.string(), logger_);
+#else
+	return nullptr;
+#endif
+}
+
 void external_task::sandbox_fini()
 {
 	sandbox_ = nullptr;
+	own_box_ = nullptr;
 }
 
-std::shared_ptr<task_results> external_task::run()
+void external_task::prepare()
 {
-	sandbox_init();
+	if (boxes_ != nullptr) { boxes_->prepare(*limits_, evaluation_dir_.string()); }
+}
 
-	if (sandbox_ == nullptr) {
-		// should never happen, unless we are doomed
-		return nullptr;
+void external_task::session_check()
+{
+#ifndef _WIN32
+	if (session_ == nullptr) { return; }
+
+	auto box = session_->get_box(task_meta_->test_id);
+	if (box != nullptr && !box->is_compatible(*limits_, evaluation_dir_.string())) {
+		logger_->debug("Task {} cannot reuse the isolate box of its test", task_meta_->task_id);
+		session_->close();
 	}
+#endif
+}
 
+fs::path external_task::get_data_dir()
+{
+#ifndef _WIN32
+	if (session_ != nullptr) {
+		auto box = session_->get_box(task_meta_->test_id);
+		if (box != nullptr) { return box->get_data_dir(); }
+	}
+#endif
+	return evaluation_dir_;
+}
+
+std::shared_ptr<task_results> external_task::run()
+{
 	// initialize output from stdout and stderr
 	results_output_init();
 
+	// data may be left in the box by the previous task of the same test
+	session_check();
+
 	// check if evaluation directory exists
-	if (!fs::exists(evaluation_dir_)) {
+	if (!fs::exists(get_data_dir())) {
 		throw task_exception("Evaluation directory '" + evaluation_dir_.string() + "' of sandbox does not exists");
 	}
 
@@ -85,8 +218,7 @@ std::shared_ptr<task_results> external_task::run()
 	make_binary_executable(task_meta_->binary);
 
 	auto res = std::make_shared<task_results>();
-	res->sandbox_status =
-		std::unique_ptr<sandbox_results>(new sandbox_results(sandbox_->run(task_meta_->binary, task_meta_->cmd_args)));
+	res->sandbox_status = std::unique_ptr<sandbox_results>(new sandbox_results(run_cached()));
 
 	// fix status if non-zero exit codes are treated as execution success
 	postprocess_exit_codes(res);
@@ -105,6 +237,192 @@ std::shared_ptr<task_results> external_task::run()
 	return res;
 }
 
+sandbox_results external_task::run_cached()
+{
+	// initiation tasks with declared outputs and evaluation tasks of known judges are cached
+	std::shared_ptr<task_cache> cache;
+	std::string cache_name;
+	std::string cache_key;
+	std::vector<fs::path> cached_files;
+	try {
+		if (compilation_cache_ != nullptr && get_type() == task_type::INITIATION && !sandbox_config_->outputs.empty()) {
+			cache_name = "compilation cache";
+			if (get_cached_files(cached_files)) {
+				cache_key = get_compilation_cache_key();
+				cache = compilation_cache_;
+			}
+		} else if (judge_cache_ != nullptr && get_type() == task_type::EVALUATION && is_cached_judge()) {
+			cache_name = "judge cache";
+			if (get_cached_files(cached_files)) {
+				cache_key = get_judge_cache_key();
+				cache = judge_cache_;
+			}
+		}
+	} catch (std::exception &e) {
+		logger_->warn("Key of task {} in {} cannot be computed: {}", task_meta_->task_id, cache_name, e.what());
+		cache = nullptr;
+	}
+
+	sandbox_results results;
+	if (cache != nullptr) {
+		bool hit = cache->restore(cache_key, cached_files, results);
+		logger_->info("Task {} {} {} ({} hits, {} misses)",
+			task_meta_->task_id,
+			hit ? "restored from" : "not found in",
+			cache_name,
+			cache->get_hits(),
+			cache->get_misses());
+		if (hit) { return results; }
+	}
+
+	sandbox_init();
+	if (sandbox_ == nullptr) {
+		// should never happen, unless we are doomed
+		throw task_exception("Sandbox of task " + task_meta_->task_id + " was not initialized");
+	}
+	results = sandbox_->run(task_meta_->binary, task_meta_->cmd_args);
+#ifndef _WIN32
+	if (own_box_ != nullptr) { own_box_->move_out(); }
+#endif
+
+	// time limits and internal errors need not repeat, only deterministic results are cached
+	if (cache != nullptr && (results.status == isolate_status::OK || results.status == isolate_status::RE)) {
+		cache->store(cache_key, cached_files, results);
+	}
+
+	return results;
+}
+
+bool external_task::get_cached_files(std::vector<fs::path> &cached_files)
+{
+	std::vector<std::string> files = sandbox_config_->outputs;
+	if (!sandbox_config_->std_output.empty()) { files.push_back(sandbox_config_->std_output); }
+	if (!sandbox_config_->std_error.empty()) { files.push_back(sandbox_config_->std_error); }
+
+	cached_files.clear();
+	for (auto &file : files) {
+		fs::path path = helpers::find_path_outside_sandbox(
+			file, sandbox_config_->chdir, limits_->bound_dirs, get_data_dir().string(), false);
+		if (path.empty()) {
+			logger_->warn("Output {} of task {} is not accessible outside sandbox, task is not cached",
+				file,
+				task_meta_->task_id);
+			return false;
+		}
+		cached_files.push_back(path);
+	}
+
+	return true;
+}
+
+bool external_task::is_cached_judge()
+{
+	const auto &judges = worker_config_->get_judge_cache_binaries();
+	return std::find(judges.begin(), judges.end(), fs::path(task_meta_->binary).filename().string()) != judges.end();
+}
+
+void external_task::hash_binary(helpers::sha256 &hash)
+{
+	// binary is either in the sandbox or directly on the host (compilers are usually not bound explicitly)
+	fs::path binary_path = find_path_outside_sandbox(task_meta_->binary);
+	if (binary_path.empty() && fs::path(task_meta_->binary).is_absolute()) { binary_path = task_meta_->binary; }
+	if (!binary_path.empty() && fs::is_regular_file(binary_path)) {
+		hash.update_file(binary_path);
+	} else {
+		hash.update(std::string());
+	}
+}
+
+std::string external_task::get_compilation_cache_key()
+{
+	helpers::sha256 hash;
+	hash.update(std::string("recodex-compilation-cache-2"));
+
+	// command
+	hash.update(task_meta_->binary);
+	hash.update((std::uint64_t) task_meta_->cmd_args.size());
+	for (auto &arg : task_meta_->cmd_args) { hash.update(arg); }
+	hash_binary(hash);
+
+	// toolchain outside the sandbox, which is used by the binary (compiler internals, headers, libraries, ...)
+	hash.update(worker_config_->get_compilation_cache_toolchain_version());
+	auto &toolchain = worker_config_->get_compilation_cache_toolchain();
+	hash.update((std::uint64_t) toolchain.size());
+	for (auto &path : toolchain) { hash_metadata(hash, path); }
+
+	// sandbox configuration, generated names of stdout and stderr files are not visible to the program
+	hash.update(sandbox_config_->std_input);
+	hash.update(remove_stdout_ ? std::string() : sandbox_config_->std_output);
+	hash.update(remove_stderr_ ? std::string() : sandbox_config_->std_error);
+	hash.update((std::uint64_t) sandbox_config_->stderr_to_stdout);
+	hash.update(sandbox_config_->chdir);
+	hash.update(sandbox_config_->working_directory);
+	hash.update((std::uint64_t) sandbox_config_->outputs.size());
+	for (auto &output : sandbox_config_->outputs) { hash.update(output); }
+
+	// limits (including the ones which are set for initiation tasks by sandbox_init)
+	hash.update((std::uint64_t) limits_->memory_usage);
+	hash.update((std::uint64_t) limits_->extra_memory);
+	hash.update(std::to_string(limits_->cpu_time));
+	hash.update(std::to_string(limits_->wall_time));
+	hash.update(std::to_string(limits_->extra_time));
+	hash.update((std::uint64_t) limits_->stack_size);
+	hash.update((std::uint64_t) limits_->files_size);
+	hash.update((std::uint64_t) limits_->disk_quotas);
+	hash.update((std::uint64_t) limits_->disk_size);
+	hash.update((std::uint64_t) limits_->disk_files);
+	hash.update((std::uint64_t) limits_->processes);
+	hash.update((std::uint64_t) limits_->share_net);
+	hash.update((std::uint64_t) limits_->environ_vars.size());
+	for (auto &var : limits_->environ_vars) {
+		hash.update(var.first);
+		hash.update(var.second);
+	}
+
+	// content of all directories visible in the sandbox (special filesystems are skipped), files of bound directories
+	// are usually the same for all jobs, so their digests are remembered
+	hash_directory(hash, get_data_dir(), false);
+	hash.update((std::uint64_t) limits_->bound_dirs.size());
+	for (auto &dir : limits_->bound_dirs) {
+		hash.update(std::get<0>(dir));
+		hash.update(std::get<1>(dir));
+		hash.update((std::uint64_t) std::get<2>(dir));
+
+		auto special = sandbox_limits::dir_perm::FS | sandbox_limits::dir_perm::DEV | sandbox_limits::dir_perm::TMP;
+		if ((std::get<2>(dir) & special) == 0 && fs::is_directory(std::get<0>(dir))) {
+			hash_directory(hash, std::get<0>(dir), true);
+		}
+	}
+
+	return hash.hexdigest();
+}
+
+std::string external_task::get_judge_cache_key()
+{
+	helpers::sha256 hash;
+	hash.update(std::string("recodex-judge-cache-1"));
+	hash.update(task_meta_->binary);
+	hash_binary(hash);
+
+	// judges see only the files given in their arguments (and on stdin), so only these are hashed
+	hash.update(sandbox_config_->chdir);
+	hash.update((std::uint64_t) sandbox_config_->stderr_to_stdout);
+	hash.update((std::uint64_t) task_meta_->cmd_args.size());
+	std::vector<std::string> files = task_meta_->cmd_args;
+	files.push_back(sandbox_config_->std_input);
+	for (auto &file : files) {
+		hash.update(file);
+		fs::path path = file.empty() ? fs::path() : find_path_outside_sandbox(file);
+		if (!path.empty() && fs::is_regular_file(path)) {
+			hash.update_file(path);
+		} else {
+			hash.update(std::string());
+		}
+	}
+
+	return hash.hexdigest();
+}
+
 void external_task::postprocess_exit_codes(std::shared_ptr<task_results> result)
 {
 	bool success = task_meta_->is_success_exit_code(result->sandbox_status->exitcode);
@@ -150,7 +468,7 @@ void external_task::results_output_init()
 fs::path external_task::find_path_outside_sandbox(const std::string &file)
 {
 	return helpers::find_path_outside_sandbox(
-		file, sandbox_config_->chdir, limits_->bound_dirs, evaluation_dir_.string());
+		file, sandbox_config_->chdir, limits_->bound_dirs, get_data_dir().string());
 }
 
 void external_task::get_results_output(std::shared_ptr<task_results> result)
@@ -174,57 +492,26 @@ void external_task::process_results_output(
 	const std::shared_ptr<task_results> &result, const fs::path &stdout_path, const fs::path &stderr_path)
 {
 	if (sandbox_config_->output) {
+		// only the beginning and the end of long outputs are kept
 		std::size_t max_length = worker_config_->get_max_output_length();
-		std::string result_stdout(max_length, 0);
-		std::string result_stderr(max_length, 0);
-
-		// open and read files
-		std::ifstream std_out(stdout_path.string());
-		std::ifstream std_err(stderr_path.string());
-		std_out.read(&result_stdout[0], max_length);
-		std_err.read(&result_stderr[0], max_length);
-
-		// if there was something in stdout, write it to result
-		if (std_out.gcount() != 0) { result->output_stdout = result_stdout.substr(0, std_out.gcount()); }
-
-		// if there was something in stderr, write it to result
-		if (std_err.gcount() != 0) { result->output_stderr = result_stderr.substr(0, std_err.gcount()); }
-
-		// be nice and close streams
-		std_out.close();
-		std_err.close();
+		result->output_stdout = helpers::read_head_tail(stdout_path, max_length);
+		result->output_stderr = helpers::read_head_tail(stderr_path, max_length);
 	}
 }
 
 void external_task::process_carboncopy_output(const fs::path &stdout_path, const fs::path &stderr_path)
 {
 	std::size_t max_length = worker_config_->get_max_carboncopy_length();
-	if (!sandbox_config_->carboncopy_stdout.empty()) {
-		std::ifstream infile(stdout_path.string(), std::ios::binary);
-		std::ofstream copy_file(sandbox_config_->carboncopy_stdout, std::ios::binary);
-
-		// make the copying, by reading the file in memory and writing it to the copy
-		std::string inmemory(max_length, 0);
-		infile.read(&inmemory[0], max_length);
-		copy_file.write(&inmemory[0], infile.gcount());
-
-		// some day we do not close streams... but it is not this day
-		infile.close();
-		copy_file.close();
-	}
-
-	if (!sandbox_config_->carboncopy_stderr.empty()) {
-		std::ifstream infile(stderr_path.string(), std::ios::binary);
-		std::ofstream copy_file(sandbox_config_->carboncopy_stderr, std::ios::binary);
-
-		// make the copying, by reading the file in memory and writing it to the copy
-		std::string inmemory(max_length, 0);
-		infile.read(&inmemory[0], max_length);
-		copy_file.write(&inmemory[0], infile.gcount());
-
-		// close streams, you fools
-		infile.close();
-		copy_file.close();
+	std::vector<std::pair<fs::path, std::string>> copies = {
+		{stdout_path, sandbox_config_->carboncopy_stdout}, {stderr_path, sandbox_config_->carboncopy_stderr}};
+
+	for (auto &[output, copy] : copies) {
+		if (copy.empty()) { continue; }
+		try {
+			helpers::copy_file_prefix(output, copy, max_length);
+		} catch (helpers::filesystem_exception &e) {
+			logger_->warn("Carbon copy of output of task {} failed: {}", task_meta_->task_id, e.what());
+		}
 	}
 }
 
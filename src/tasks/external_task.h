@@ -5,6 +5,8 @@
 #include <memory>
 #include "task_base.h"
 #include "create_params.h"
+#include "task_cache.h"
+#include "helpers/hash.h"
 #include "sandbox/sandbox_base.h"
 #include "config/sandbox_limits.h"
 
@@ -25,9 +27,13 @@ public:
 	 * Only way to construct external task is through this constructor.
 	 * Choosing propriate sandbox and constructing it, is also done here.
 	 * @param data Data to create external task class.
+	 * @param compilation_cache Cache of initiation tasks results, @a nullptr if caching is disabled.
+	 * @param judge_cache Cache of judges verdicts, @a nullptr if caching is disabled.
 	 * @throws task_exception if name of the sandbox in data argument is unknown.
 	 */
-	external_task(const create_params &data);
+	external_task(const create_params &data,
+		std::shared_ptr<task_cache> compilation_cache = nullptr,
+		std::shared_ptr<task_cache> judge_cache = nullptr);
 	/**
 	 * Destructor, empty right now.
 	 */
@@ -40,6 +46,11 @@ public:
 	 */
 	std::shared_ptr<task_results> run() override;
 
+	/**
+	 * Initialize the box of this task in advance (if the boxes of the worker allow it).
+	 */
+	void prepare() override;
+
 	/**
 	 * Get sandbox_limits structure, given during construction.
 	 * @return Restrictive limits for sandboxed program.
@@ -56,10 +67,25 @@ private:
 	 * Construct apropriate sandbox according his name give during construction.
 	 */
 	void sandbox_init();
+	/**
+	 * Get an initialized isolate box for this task.
+	 * @param limits limits of the task
+	 */
+	std::shared_ptr<isolate_box> acquire_box(const sandbox_limits &limits);
 	/**
 	 * Destruction of internal sandbox.
 	 */
 	void sandbox_fini();
+	/**
+	 * Close the box shared with previous tasks of the same test if this task cannot run in it.
+	 */
+	void session_check();
+
+	/**
+	 * Get directory outside sandbox where the data of the task currently are. It is the shared box of the test if
+	 * the previous task left them there, the evaluation directory otherwise.
+	 */
+	fs::path get_data_dir();
 
 	/**
 	 * For the given file find appropriate path outside sandbox in the directories specified in the limits.
@@ -96,6 +122,44 @@ private:
 
 	void process_carboncopy_output(const fs::path &stdout_path, const fs::path &stderr_path);
 
+	/**
+	 * Run the program in the sandbox or restore its results from the compilation cache.
+	 * @return results of the sandbox
+	 */
+	sandbox_results run_cached();
+
+	/**
+	 * Get files which are stored in the cache for this task (outputs, stdout and stderr).
+	 * @param cached_files paths outside sandbox
+	 * @return false if some of the outputs is not accessible from outside (the task is not cached then)
+	 */
+	bool get_cached_files(std::vector<fs::path> &cached_files);
+
+	/**
+	 * Check whether the binary of this task is a judge whose verdicts may be cached.
+	 */
+	bool is_cached_judge();
+
+	/**
+	 * Add content of the binary of this task to the hash.
+	 * @param hash hash to be updated
+	 */
+	void hash_binary(helpers::sha256 &hash);
+
+	/**
+	 * Compute key of this task in the compilation cache. It is a hash of the command, sandbox configuration,
+	 * limits, the configured toolchain and content of the binary and all files visible in the sandbox.
+	 * @return hexadecimal hash
+	 */
+	std::string get_compilation_cache_key();
+
+	/**
+	 * Compute key of this task in the judge cache. It is a hash of the judge binary, its arguments and content
+	 * of the files given in the arguments and on the standard input.
+	 * @return hexadecimal hash
+	 */
+	std::string get_judge_cache_key();
+
 	/** Worker default configuration */
 	std::shared_ptr<worker_config> worker_config_;
 	/** Constructed sandbox itself */
@@ -116,6 +180,18 @@ private:
 	bool remove_stdout_ = false;
 	/** After execution delete stderr file produced by sandbox */
 	bool remove_stderr_ = false;
+	/** Cache of initiation tasks results (optional) */
+	std::shared_ptr<task_cache> compilation_cache_;
+	/** Cache of judges verdicts (optional) */
+	std::shared_ptr<task_cache> judge_cache_;
+	/** Box shared by consecutive tasks of one test (optional) */
+	std::shared_ptr<box_session> session_;
+	/** Isolate boxes of the worker which may be initialized in advance (optional) */
+	std::shared_ptr<box_pool> boxes_;
+	/** Cancellation of the job, the program is terminated when the job is cancelled (optional) */
+	std::shared_ptr<helpers::cancellation_token> cancellation_;
+	/** Box of this task if it is not shared with other tasks of the test (data are moved out after the run) */
+	std::shared_ptr<isolate_box> own_box_;
 };
 
 #endif // RECODEX_WORKER_EXTERNAL_TASK_HPP
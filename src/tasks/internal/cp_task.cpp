@@ -45,7 +45,11 @@ std::shared_ptr<task_results> cp_task::run()
 				helpers::copy_directory(item->path(), target);
 			} else {
 				std::error_code error_code;
-				fs::copy(item->path(), target, error_code);
+				if (fs::is_regular_file(item->path())) {
+					helpers::fast_copy_file(item->path(), target, error_code, false);
+				} else {
+					fs::copy(item->path(), target, error_code);
+				}
 				if (error_code) {
 					result->status = task_status::FAILED;
 					result->error_message = std::string("Cannot copy files. Error: ") + error_code.message();
@@ -1,6 +1,7 @@
 #include <fstream>
 #include "dump_dir_task.h"
 #include "helpers/string_utils.h"
+#include "helpers/filesystem.h"
 
 namespace
 {
@@ -99,7 +100,11 @@ std::shared_ptr<task_results> dump_dir_task::run()
 std::error_code dump_dir_task::copy_file(const fs::path &src, const fs::path &dest)
 {
 	std::error_code error_code;
-	fs::copy(src, dest, error_code);
+	if (fs::is_regular_file(src)) {
+		helpers::fast_copy_file(src, dest, error_code, false);
+	} else {
+		fs::copy(src, dest, error_code);
+	}
 
 	return error_code;
 }
@@ -1,4 +1,5 @@
 #include "fetch_task.h"
+#include "helpers/trace.h"
 
 
 fetch_task::fetch_task(
@@ -15,12 +16,15 @@ fetch_task::fetch_task(
 std::shared_ptr<task_results> fetch_task::run()
 {
 	std::shared_ptr<task_results> result(new task_results());
+	helpers::trace_span span("fetch");
+	span.set("file", task_meta_->cmd_args[0]);
 
 	try {
 		filemanager_->get_file(task_meta_->cmd_args[0], task_meta_->cmd_args[1]);
 	} catch (fm_exception &e) {
 		result->status = task_status::FAILED;
 		result->error_message = std::string("Cannot fetch files. Error: ") + e.what();
+		span.set("error", e.what());
 	}
 
 	return result;
@@ -0,0 +1,292 @@
+#include "judge_task.h"
+#include "token_judge.hpp"
+#include "helpers/filesystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#endif
+
+
+#ifndef _WIN32
+namespace
+{
+	/**
+	 * Set both soft and hard limit of given resource.
+	 */
+	void set_limit(int resource, rlim_t soft, rlim_t hard)
+	{
+		struct rlimit limit;
+		limit.rlim_cur = soft;
+		limit.rlim_max = hard;
+		setrlimit(resource, &limit);
+	}
+
+	/**
+	 * Size of the virtual memory of the current process in bytes (0 if unknown).
+	 */
+	rlim_t virtual_memory_size()
+	{
+		std::ifstream statm("/proc/self/statm");
+		rlim_t pages = 0;
+		if (!(statm >> pages)) { return 0; }
+		return pages * (rlim_t) sysconf(_SC_PAGESIZE);
+	}
+
+	/**
+	 * Write whole string to given file descriptor, errors are ignored (the parent may be gone).
+	 */
+	void write_all(int fd, const std::string &data)
+	{
+		std::size_t written = 0;
+		while (written < data.size()) {
+			ssize_t res = write(fd, data.data() + written, data.size() - written);
+			if (res < 0 && errno == EINTR) { continue; }
+			if (res <= 0) { return; }
+			written += (std::size_t) res;
+		}
+	}
+} // namespace
+#endif
+
+
+judge_task::judge_task(std::size_t id,
+	std::shared_ptr<task_metadata> task_meta,
+	std::shared_ptr<worker_config> worker_conf,
+	std::shared_ptr<helpers::cancellation_token> cancellation)
+	: task_base(id, task_meta), max_output_length_(std::numeric_limits<std::size_t>::max()), cancellation_(cancellation)
+{
+	if (task_meta_->cmd_args.size() < 2) { throw task_exception("At least two arguments required."); }
+
+	if (worker_conf != nullptr) {
+		limits_ = worker_conf->get_limits();
+		max_output_length_ = worker_conf->get_max_output_length();
+	}
+	// the same as sandboxed tasks, the output is reported only if requested
+	if (task_meta_->sandbox == nullptr || !task_meta_->sandbox->output) { max_output_length_ = 0; }
+}
+
+bool judge_task::is_sandboxed()
+{
+	return false;
+}
+
+
+std::shared_ptr<task_results> judge_task::run()
+{
+	std::shared_ptr<task_results> result(new task_results());
+
+	// judge expects regular command line, first argument is the program name
+	std::vector<const char *> argv;
+	argv.push_back("recodex-token-judge");
+	for (auto &arg : task_meta_->cmd_args) { argv.push_back(arg.c_str()); }
+	argv.push_back(nullptr);
+
+	// fill in the same information which would be provided by the sandbox
+	result->sandbox_status = std::unique_ptr<sandbox_results>(new sandbox_results());
+	auto &status = *result->sandbox_status;
+
+#ifndef _WIN32
+	run_child(argv, *result);
+#else
+	std::ostringstream out;
+	std::ostringstream err;
+
+	auto start = std::chrono::steady_clock::now();
+	status.exitcode = runTokenJudge((int) argv.size() - 1, argv.data(), out, err);
+	std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - start;
+
+	result->output_stdout = helpers::head_tail(out.str(), max_output_length_);
+	result->output_stderr = helpers::head_tail(err.str(), max_output_length_);
+	status.time = elapsed.count();
+	status.wall_time = elapsed.count();
+#endif
+
+	if (status.status == isolate_status::OK && !task_meta_->is_success_exit_code(status.exitcode)) {
+		status.status = isolate_status::RE;
+		status.message = "Exited with code " + std::to_string(status.exitcode);
+	}
+	if (status.status != isolate_status::OK) {
+		result->status = task_status::FAILED;
+		result->error_message = "Judge failed: " + status.message;
+	}
+
+	return result;
+}
+
+
+#ifndef _WIN32
+void judge_task::run_child(std::vector<const char *> &argv, task_results &result)
+{
+	auto &status = *result.sandbox_status;
+
+	int out_pipe[2];
+	int err_pipe[2];
+	if (pipe2(out_pipe, O_CLOEXEC) != 0) {
+		throw task_exception("Cannot create pipe for the judge: " + std::string(strerror(errno)));
+	}
+	if (pipe2(err_pipe, O_CLOEXEC) != 0) {
+		int error = errno;
+		close(out_pipe[0]);
+		close(out_pipe[1]);
+		throw task_exception("Cannot create pipe for the judge: " + std::string(strerror(error)));
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	pid_t pid = fork();
+	if (pid == -1) {
+		int error = errno;
+		for (int fd : {out_pipe[0], out_pipe[1], err_pipe[0], err_pipe[1]}) { close(fd); }
+		throw task_exception("Cannot fork the judge: " + std::string(strerror(error)));
+	}
+
+	if (pid == 0) {
+		// judge process, the limits apply to this process only
+		close(out_pipe[0]);
+		close(err_pipe[0]);
+		if (limits_.cpu_time > 0) {
+			auto seconds = (rlim_t) std::ceil(limits_.cpu_time + limits_.extra_time);
+			set_limit(RLIMIT_CPU, seconds, seconds + 1);
+		}
+		if (limits_.memory_usage > 0) {
+			// the inherited address space of the worker is not counted
+			rlim_t bytes = virtual_memory_size() + (rlim_t)(limits_.memory_usage + limits_.extra_memory) * 1024;
+			set_limit(RLIMIT_AS, bytes, bytes);
+		}
+
+		std::ostringstream out;
+		std::ostringstream err;
+		int exitcode = runTokenJudge((int) argv.size() - 1, argv.data(), out, err);
+		write_all(out_pipe[1], helpers::head_tail(out.str(), max_output_length_));
+		write_all(err_pipe[1], helpers::head_tail(err.str(), max_output_length_));
+		_exit(exitcode);
+	}
+
+	// worker process, collect the output until the judge ends or the wall time runs out
+	close(out_pipe[1]);
+	close(err_pipe[1]);
+	// the judge is terminated (SIGTERM) right away if the job is cancelled already
+	if (cancellation_ != nullptr) { cancellation_->attach_process(pid); }
+
+	bool deadline_set = limits_.wall_time > 0;
+	auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+								std::chrono::duration<float>(limits_.wall_time + limits_.extra_time));
+	auto kill_judge = [&](isolate_status reason, const std::string &message) {
+		if (status.killed) { return; }
+		kill(pid, SIGKILL);
+		status.killed = true;
+		status.status = reason;
+		status.message = message;
+	};
+
+	struct pollfd fds[2];
+	std::string *outputs[2] = {&result.output_stdout, &result.output_stderr};
+	fds[0].fd = out_pipe[0];
+	fds[1].fd = err_pipe[0];
+	std::size_t open_pipes = 2;
+	char buffer[4096];
+
+	while (open_pipes > 0) {
+		int timeout = -1;
+		if (deadline_set) {
+			auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+				deadline - std::chrono::steady_clock::now());
+			if (remaining.count() <= 0) {
+				kill_judge(isolate_status::TO, "Time limit exceeded (wall clock)");
+				break;
+			}
+			timeout = (int) remaining.count() + 1;
+		}
+
+		for (auto &fd : fds) { fd.events = POLLIN; }
+		int ready = poll(fds, 2, timeout);
+		if (ready < 0 && errno != EINTR) {
+			kill_judge(isolate_status::XX, "Cannot read output of the judge: " + std::string(strerror(errno)));
+			break;
+		}
+		if (ready <= 0) { continue; }
+
+		for (std::size_t i = 0; i < 2; ++i) {
+			if (fds[i].fd < 0 || fds[i].revents == 0) { continue; }
+			ssize_t size = read(fds[i].fd, buffer, sizeof(buffer));
+			if (size < 0 && errno == EINTR) { continue; }
+			if (size <= 0) {
+				close(fds[i].fd);
+				fds[i].fd = -1; // negative descriptors are ignored by poll
+				--open_pipes;
+				continue;
+			}
+
+			// the judge limits its output itself, this only keeps the worker safe
+			auto &output = *outputs[i];
+			if (output.size() < max_output_length_) {
+				output.append(buffer, std::min((std::size_t) size, max_output_length_ - output.size()));
+			}
+		}
+	}
+
+	for (auto &fd : fds) {
+		if (fd.fd >= 0) { close(fd.fd); }
+	}
+
+	// the judge may still run after closing its output, it has to end within the wall time as well
+	siginfo_t info;
+	while (true) {
+		info.si_pid = 0;
+		int res = waitid(P_PID, pid, &info, WEXITED | WNOWAIT | WNOHANG);
+		if (res == -1 && errno == EINTR) { continue; }
+		if (res == -1 || info.si_pid != 0) { break; }
+		if (deadline_set && std::chrono::steady_clock::now() >= deadline) {
+			kill_judge(isolate_status::TO, "Time limit exceeded (wall clock)");
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	// the finished process is detached before it is reaped, so its pid cannot be reused in the meantime
+	if (cancellation_ != nullptr) { cancellation_->detach_process(); }
+	int wstatus = 0;
+	struct rusage usage;
+	while (wait4(pid, &wstatus, 0, &usage) == -1 && errno == EINTR) {}
+	std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - start;
+
+	status.wall_time = elapsed.count();
+	status.time = (float) usage.ru_utime.tv_sec + (float) usage.ru_utime.tv_usec / 1000000 +
+		(float) usage.ru_stime.tv_sec + (float) usage.ru_stime.tv_usec / 1000000;
+	status.memory = (std::size_t) usage.ru_maxrss;
+	status.max_rss = (std::size_t) usage.ru_maxrss;
+	status.csw_voluntary = (std::size_t) usage.ru_nvcsw;
+	status.csw_forced = (std::size_t) usage.ru_nivcsw;
+
+	if (cancellation_ != nullptr && cancellation_->is_cancelled()) {
+		throw task_exception("Judge was cancelled together with the job.");
+	}
+	if (status.killed) { return; }
+	if (WIFSIGNALED(wstatus)) {
+		status.killed = true;
+		status.exitsig = WTERMSIG(wstatus);
+		if (status.exitsig == SIGXCPU || (status.exitsig == SIGKILL && limits_.cpu_time > 0 &&
+											 status.time >= limits_.cpu_time + limits_.extra_time)) {
+			status.status = isolate_status::TO;
+			status.message = "Time limit exceeded";
+		} else {
+			status.status = isolate_status::SG;
+			status.message = "Caught fatal signal " + std::to_string(status.exitsig);
+		}
+	} else {
+		status.exitcode = WEXITSTATUS(wstatus);
+	}
+}
+#endif
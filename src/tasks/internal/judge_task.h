@@ -0,0 +1,73 @@
+#ifndef RECODEX_WORKER_INTERNAL_JUDGE_TASK_H
+#define RECODEX_WORKER_INTERNAL_JUDGE_TASK_H
+
+#include <vector>
+#include "tasks/task_base.h"
+#include "config/worker_config.h"
+#include "helpers/cancellation_token.h"
+
+
+/**
+ * Compare two files using the token judge directly in the worker process (no sandbox is involved).
+ * Arguments are the same as the arguments of recodex-token-judge binary, files have to be given
+ * by their paths outside of the sandbox (i.e., relative to ${SOURCE_DIR}, not ${EVAL_DIR}).
+ * Output of the judge is stored in the results the same way as output of a sandboxed judge, i.e., only if
+ * @a output is set in the sandbox section of the task (no other item of the section is used) and limited to
+ * the maximal output length of the worker.
+ *
+ * The judge reads files produced by the tested program, so it runs in a forked child process which is bounded by
+ * the CPU time (RLIMIT_CPU), the wall time and the memory (RLIMIT_AS) of the default limits of the worker. Only
+ * the time, wall time, extra time, memory and extra memory items are used. The child process is terminated when
+ * the job is cancelled. On Windows, the judge runs in the worker process unbounded.
+ */
+class judge_task : public task_base
+{
+public:
+	/**
+	 * Constructor with initialization.
+	 * @param id Unique identificator of load order of tasks.
+	 * @param task_meta Variable containing further info about task. It's required that
+	 * @a cmd_args entry has at least two arguments - the correct and the tested file (judge options may precede them).
+	 * @param worker_conf Worker configuration with the limits and the maximal output length (optional, nothing is
+	 * limited without it).
+	 * @param cancellation Cancellation of the job, the judge is terminated when the job is cancelled (optional).
+	 * @throws task_exception when wrong arguments provided.
+	 */
+	judge_task(std::size_t id,
+		std::shared_ptr<task_metadata> task_meta,
+		std::shared_ptr<worker_config> worker_conf = nullptr,
+		std::shared_ptr<helpers::cancellation_token> cancellation = nullptr);
+	/**
+	 * Destructor.
+	 */
+	~judge_task() override = default;
+	/**
+	 * Run the action.
+	 * @return Evaluation results to be pushed back to frontend.
+	 */
+	std::shared_ptr<task_results> run() override;
+	/**
+	 * The judge does not run in a sandbox even if the task has a sandbox section.
+	 * @return Always @a false.
+	 */
+	bool is_sandboxed() override;
+
+private:
+#ifndef _WIN32
+	/**
+	 * Run the judge in a child process and wait for it within the limits.
+	 * @param argv Arguments of the judge terminated by @a nullptr.
+	 * @param result Results to be filled with the output and the status of the judge.
+	 */
+	void run_child(std::vector<const char *> &argv, task_results &result);
+#endif
+
+	/** Limits of the judge process. */
+	sandbox_limits limits_;
+	/** Maximal length of reported stdout and stderr. */
+	std::size_t max_output_length_;
+	/** Cancellation of the job, @a nullptr if it cannot be cancelled. */
+	std::shared_ptr<helpers::cancellation_token> cancellation_;
+};
+
+#endif // RECODEX_WORKER_INTERNAL_JUDGE_TASK_H
@@ -71,6 +71,16 @@ task_type task_base::get_type()
 	return task_meta_->type;
 }
 
+const std::string &task_base::get_test_id()
+{
+	return task_meta_->test_id;
+}
+
+bool task_base::is_sandboxed()
+{
+	return task_meta_->sandbox != nullptr;
+}
+
 bool task_base::is_executable()
 {
 	return execute_;
@@ -43,6 +43,13 @@ public:
 	 * @return Evaluation results to be pushed back to frontend.
 	 */
 	virtual std::shared_ptr<task_results> run() = 0;
+	/**
+	 * Prepare execution of this task in the background, while the previous task is running (e.g., initialize its
+	 * sandbox). Nothing which depends on results of other tasks may be done here. Default does nothing.
+	 */
+	virtual void prepare()
+	{
+	}
 	/**
 	 * Add child to this task. Once given, child cannot be deleted.
 	 * @param add Pointer to child task (task dependent on current one).
@@ -110,6 +117,16 @@ public:
 	 * @return task_type enum with all possible types
 	 */
 	task_type get_type();
+	/**
+	 * Return identification of the test this task belongs to.
+	 * @return Test ID, empty if the task does not belong to any test.
+	 */
+	const std::string &get_test_id();
+	/**
+	 * Tells whether the task runs in a sandbox (ie. it is an external task).
+	 * @return @a true if sandbox configuration was given.
+	 */
+	virtual bool is_sandboxed();
 
 	/**
 	 * Tells whether task can be safely executed or not (ie. if parent task is failed).
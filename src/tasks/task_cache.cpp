@@ -0,0 +1,192 @@
+#include "task_cache.h"
+#include "task_base.h"
+#include "helpers/filesystem.h"
+#include "helpers/string_utils.h"
+#include <algorithm>
+#include <fstream>
+#include <yaml-cpp/yaml.h>
+
+namespace
+{
+	const std::string results_file = "results.yml";
+	const std::string temp_prefix = ".tmp-";
+	/** Temporary entries of crashed writers are removed after this time. */
+	const auto stale_temp_age = std::chrono::hours(1);
+} // namespace
+
+
+task_cache::task_cache(const fs::path &cache_dir, std::uintmax_t max_size, std::shared_ptr<spdlog::logger> logger)
+	: cache_dir_(cache_dir), max_size_(max_size), logger_(logger), hits_(0), misses_(0)
+{
+	if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
+
+	try {
+		fs::create_directories(cache_dir_);
+	} catch (fs::filesystem_error &e) {
+		throw task_exception("Cannot create task cache directory " + cache_dir_.string() + ": " + e.what());
+	}
+}
+
+bool task_cache::restore(const std::string &key, const std::vector<fs::path> &files, sandbox_results &results)
+{
+	fs::path entry = cache_dir_ / key;
+
+	try {
+		if (!fs::is_regular_file(entry / results_file)) {
+			++misses_;
+			return false;
+		}
+
+		YAML::Node node = YAML::LoadFile((entry / results_file).string());
+		YAML::Node stored = node["files"];
+		if (!stored.IsSequence() || stored.size() != files.size()) {
+			logger_->warn("Task cache entry {} does not match the task, ignoring it", key);
+			++misses_;
+			return false;
+		}
+
+		sandbox_results restored;
+		restored.status = static_cast<isolate_status>(node["status"].as<int>());
+		restored.exitcode = node["exitcode"].as<int>();
+		restored.time = node["time"].as<float>();
+		restored.wall_time = node["wall-time"].as<float>();
+		restored.memory = node["memory"].as<std::size_t>();
+		restored.max_rss = node["max-rss"].as<std::size_t>();
+		restored.exitsig = node["exitsig"].as<int>();
+		restored.killed = node["killed"].as<bool>();
+		restored.message = node["message"].as<std::string>();
+		restored.csw_voluntary = node["csw-voluntary"].as<std::size_t>();
+		restored.csw_forced = node["csw-forced"].as<std::size_t>();
+
+		for (std::size_t i = 0; i < files.size(); ++i) {
+			if (stored[i].as<bool>()) {
+				fs::create_directories(files[i].parent_path());
+				helpers::fast_copy_file(entry / std::to_string(i), files[i]);
+			} else {
+				fs::remove(files[i]);
+			}
+		}
+
+		// entry was used recently, it is not evicted soon
+		std::error_code ec;
+		fs::last_write_time(entry, fs::file_time_type::clock::now(), ec);
+		results = restored;
+	} catch (std::exception &e) {
+		// entry might have been evicted by another worker meanwhile
+		logger_->warn("Task cache entry {} cannot be restored: {}", key, e.what());
+		++misses_;
+		return false;
+	}
+
+	++hits_;
+	return true;
+}
+
+void task_cache::store(const std::string &key, const std::vector<fs::path> &files, const sandbox_results &results)
+{
+	fs::path entry = cache_dir_ / key;
+	fs::path temp_entry = cache_dir_ / (temp_prefix + key + "-" + helpers::random_alphanum_string(10));
+
+	try {
+		if (fs::exists(entry)) { return; }
+		fs::create_directories(temp_entry);
+
+		YAML::Node node;
+		node["status"] = static_cast<int>(results.status);
+		node["exitcode"] = results.exitcode;
+		node["time"] = results.time;
+		node["wall-time"] = results.wall_time;
+		node["memory"] = results.memory;
+		node["max-rss"] = results.max_rss;
+		node["exitsig"] = results.exitsig;
+		node["killed"] = results.killed;
+		node["message"] = results.message;
+		node["csw-voluntary"] = results.csw_voluntary;
+		node["csw-forced"] = results.csw_forced;
+
+		node["files"] = YAML::Node(YAML::NodeType::Sequence);
+		for (std::size_t i = 0; i < files.size(); ++i) {
+			bool exists = fs::is_regular_file(files[i]);
+			if (exists) { helpers::fast_copy_file(files[i], temp_entry / std::to_string(i), false); }
+			node["files"].push_back(exists);
+		}
+
+		YAML::Emitter yaml_out;
+		yaml_out << node;
+		std::ofstream out((temp_entry / results_file).string());
+		out << yaml_out.c_str();
+		out.close();
+		if (!out) { throw task_exception("Cannot write " + results_file); }
+
+		// fails if another worker stored the same entry meanwhile, which is fine
+		std::error_code ec;
+		fs::rename(temp_entry, entry, ec);
+		if (ec) { fs::remove_all(temp_entry); }
+	} catch (std::exception &e) {
+		logger_->warn("Task cache entry {} cannot be stored: {}", key, e.what());
+		std::error_code ec;
+		fs::remove_all(temp_entry, ec);
+		return;
+	}
+
+	evict();
+}
+
+void task_cache::evict()
+{
+	if (max_size_ == 0) { return; }
+
+	std::lock_guard<std::mutex> lock(evict_mutex_);
+	std::vector<std::pair<fs::file_time_type, fs::path>> entries;
+	std::uintmax_t total_size = 0;
+
+	try {
+		auto now = fs::file_time_type::clock::now();
+		for (auto &item : fs::directory_iterator(cache_dir_)) {
+			std::error_code ec;
+			auto modified = fs::last_write_time(item.path(), ec);
+			if (ec) { continue; }
+
+			if (item.path().filename().string().compare(0, temp_prefix.size(), temp_prefix) == 0) {
+				if (now - modified > stale_temp_age) { fs::remove_all(item.path(), ec); }
+				continue;
+			}
+
+			total_size += helpers::directory_size(item.path());
+			entries.emplace_back(modified, item.path());
+		}
+	} catch (std::exception &e) {
+		logger_->warn("Task cache cannot be cleaned: {}", e.what());
+		return;
+	}
+
+	if (total_size <= max_size_) { return; }
+
+	std::sort(entries.begin(), entries.end());
+	for (auto &entry : entries) {
+		if (total_size <= max_size_) { break; }
+
+		std::error_code ec;
+		std::uintmax_t size = 0;
+		try {
+			size = helpers::directory_size(entry.second);
+		} catch (helpers::filesystem_exception &) {
+			continue; // removed by another worker
+		}
+		fs::remove_all(entry.second, ec);
+		if (!ec) {
+			total_size -= std::min(size, total_size);
+			logger_->debug("Task cache entry {} evicted", entry.second.filename().string());
+		}
+	}
+}
+
+std::size_t task_cache::get_hits() const
+{
+	return hits_;
+}
+
+std::size_t task_cache::get_misses() const
+{
+	return misses_;
+}
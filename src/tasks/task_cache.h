@@ -0,0 +1,88 @@
+#ifndef RECODEX_WORKER_TASK_CACHE_H
+#define RECODEX_WORKER_TASK_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "helpers/logger.h"
+#include "config/task_results.h"
+
+namespace fs = std::filesystem;
+
+
+/**
+ * Cache of results of deterministic sandboxed tasks (e.g., compilations).
+ *
+ * Every entry is identified by a key (a hash of everything the task depends on, computed by the caller) and holds
+ * the results of the sandbox and copies of the files produced by the task. Entries are directories inside the cache
+ * directory, which may be shared by more workers. They are written under temporary names and renamed atomically.
+ * When the total size exceeds the limit, least recently used entries are removed.
+ */
+class task_cache
+{
+public:
+	/**
+	 * Constructor.
+	 * @param cache_dir Directory of the cache, it is created if it does not exist.
+	 * @param max_size Maximal total size of all entries in bytes, zero means unlimited.
+	 * @param logger Shared pointer to system logger (optional).
+	 * @throws task_exception if the directory cannot be created
+	 */
+	task_cache(const fs::path &cache_dir, std::uintmax_t max_size, std::shared_ptr<spdlog::logger> logger = nullptr);
+
+	task_cache(const task_cache &source) = delete;
+	task_cache &operator=(const task_cache &source) = delete;
+
+	/**
+	 * Restore cached results of a task.
+	 * @param key Key of the entry.
+	 * @param files Files produced by the task, in the same order as they were stored. Cached files are copied to
+	 * these paths, files which the task did not produce are removed.
+	 * @param results Restored sandbox results.
+	 * @return True on hit, false if the entry does not exist or cannot be restored.
+	 */
+	bool restore(const std::string &key, const std::vector<fs::path> &files, sandbox_results &results);
+
+	/**
+	 * Store results of a task. Failures are only logged, the cache is an optimization.
+	 * @param key Key of the entry.
+	 * @param files Files produced by the task, the ones which do not exist are recorded as missing.
+	 * @param results Sandbox results of the task.
+	 */
+	void store(const std::string &key, const std::vector<fs::path> &files, const sandbox_results &results);
+
+	/**
+	 * Get number of successful restores.
+	 */
+	std::size_t get_hits() const;
+
+	/**
+	 * Get number of failed restores.
+	 */
+	std::size_t get_misses() const;
+
+private:
+	/**
+	 * Remove least recently used entries until the cache fits into @a max_size_.
+	 */
+	void evict();
+
+	/** Directory of the cache. */
+	fs::path cache_dir_;
+	/** Maximal total size of entries (zero = unlimited). */
+	std::uintmax_t max_size_;
+	/** System logger. */
+	std::shared_ptr<spdlog::logger> logger_;
+	/** Serializes eviction within this process. */
+	std::mutex evict_mutex_;
+	/** Number of hits. */
+	std::atomic<std::size_t> hits_;
+	/** Number of misses. */
+	std::atomic<std::size_t> misses_;
+};
+
+#endif // RECODEX_WORKER_TASK_CACHE_H
@@ -1,7 +1,13 @@
 #include "task_factory.h"
 
 
-task_factory::task_factory(std::shared_ptr<file_manager_interface> fileman) : fileman_(fileman)
+task_factory::task_factory(std::shared_ptr<file_manager_interface> fileman,
+	std::shared_ptr<task_cache> compilation_cache,
+	std::shared_ptr<task_cache> judge_cache,
+	std::shared_ptr<worker_config> worker_conf,
+	std::shared_ptr<helpers::cancellation_token> cancellation)
+	: fileman_(fileman), compilation_cache_(compilation_cache), judge_cache_(judge_cache), worker_conf_(worker_conf),
+	  cancellation_(cancellation)
 {
 }
 
@@ -31,6 +37,8 @@ std::shared_ptr<task_base> task_factory::create_internal_task(std::size_t id, st
 		task = std::make_shared<truncate_task>(id, task_meta);
 	} else if (task_meta->binary == "exists") {
 		task = std::make_shared<exists_task>(id, task_meta);
+	} else if (task_meta->binary == "judge") {
+		task = std::make_shared<judge_task>(id, task_meta, worker_conf_, cancellation_);
 	} else {
 		task = nullptr;
 	}
@@ -40,5 +48,5 @@ std::shared_ptr<task_base> task_factory::create_internal_task(std::size_t id, st
 
 std::shared_ptr<task_base> task_factory::create_sandboxed_task(const create_params &data)
 {
-	return std::make_shared<external_task>(data);
+	return std::make_shared<external_task>(data, compilation_cache_, judge_cache_);
 }
@@ -4,6 +4,7 @@
 #include <memory>
 #include "task_factory_interface.h"
 #include "external_task.h"
+#include "task_cache.h"
 #include "root_task.h"
 #include "internal/archivate_task.h"
 #include "internal/cp_task.h"
@@ -15,6 +16,7 @@
 #include "internal/rename_task.h"
 #include "internal/rm_task.h"
 #include "internal/exists_task.h"
+#include "internal/judge_task.h"
 #include "fileman/file_manager_interface.h"
 
 
@@ -27,8 +29,16 @@ public:
 	/**
 	 * Constructor
 	 * @param fileman Instance of file manager to be used. It's required by @ref fetch_task to work properly.
+	 * @param compilation_cache Cache of initiation tasks results given to sandboxed tasks (optional).
+	 * @param judge_cache Cache of judges verdicts given to sandboxed tasks (optional).
+	 * @param worker_conf Worker configuration, which limits @ref judge_task (optional, nothing is limited without it).
+	 * @param cancellation Cancellation of the job, which terminates @ref judge_task (optional).
 	 */
-	task_factory(std::shared_ptr<file_manager_interface> fileman);
+	task_factory(std::shared_ptr<file_manager_interface> fileman,
+		std::shared_ptr<task_cache> compilation_cache = nullptr,
+		std::shared_ptr<task_cache> judge_cache = nullptr,
+		std::shared_ptr<worker_config> worker_conf = nullptr,
+		std::shared_ptr<helpers::cancellation_token> cancellation = nullptr);
 
 	/**
 	 * Virtual destructor
@@ -59,6 +69,14 @@ public:
 private:
 	/** Pointer to given file manager instance. */
 	std::shared_ptr<file_manager_interface> fileman_;
+	/** Cache of initiation tasks results, @a nullptr if disabled. */
+	std::shared_ptr<task_cache> compilation_cache_;
+	/** Cache of judges verdicts, @a nullptr if disabled. */
+	std::shared_ptr<task_cache> judge_cache_;
+	/** Worker configuration given to internal judge tasks, @a nullptr if not set. */
+	std::shared_ptr<worker_config> worker_conf_;
+	/** Cancellation of the job given to internal judge tasks, @a nullptr if not set. */
+	std::shared_ptr<helpers::cancellation_token> cancellation_;
 };
 
 
@@ -5,6 +5,10 @@
 #include "worker_core.h"
 #include "fileman/cache_manager.h"
 #include "fileman/http_manager.h"
+#include "fileman/local_file_manager.h"
+#include "helpers/config.h"
+#include "helpers/affinity.h"
+#include "helpers/trace.h"
 #include "job/job_receiver.h"
 #include "job/progress_callback.h"
 
@@ -23,12 +27,14 @@ worker_core::worker_core(std::vector<std::string> args)
 	filesystem_init();
 	// initialize logger
 	log_init();
+	// pin worker threads to reserved CPUs
+	affinity_init();
 	// initialize curl
 	curl_init();
-	// construct and setup broker connection
-	broker_init();
 	// construct filemanagers
 	fileman_init();
+	// construct and setup broker connection
+	broker_init();
 	// evaluator initialization
 	receiver_init();
 }
@@ -37,10 +43,16 @@ worker_core::~worker_core()
 {
 	// curl finalize
 	curl_fini();
+	helpers::close_trace();
 }
 
 void worker_core::run()
 {
+	if (!warmup_files_.empty()) {
+		warmup();
+		return;
+	}
+
 	// connect broker_connection to real broker server
 	broker_->connect();
 	// start execution thread which will be receiving jobs
@@ -68,7 +80,9 @@ void worker_core::parse_params()
 	// Declare the supported options.
 	options_description desc("Allowed options for IsoEval");
 	desc.add_options()("help,h", "Writes this help message to stderr")(
-		"config,c", value<std::string>(), "Set default configuration of this program");
+		"config,c", value<std::string>(), "Set default configuration of this program")("warmup,w",
+		value<std::vector<std::string>>()->multitoken(),
+		"Download given files (URLs or job configurations) into the cache and exit");
 
 	variables_map vm;
 	try {
@@ -87,6 +101,8 @@ void worker_core::parse_params()
 
 	if (vm.count("config")) { config_filename_ = vm["config"].as<std::string>(); }
 
+	if (vm.count("warmup")) { warmup_files_ = vm["warmup"].as<std::vector<std::string>>(); }
+
 	return;
 }
 
@@ -154,6 +170,16 @@ void worker_core::log_init()
 		throw;
 	}
 
+	// trace spans of jobs are recorded only for performance analysis
+	auto &trace_file = config_->get_trace_file();
+	if (!trace_file.empty()) {
+		if (helpers::open_trace(trace_file, config_->get_worker_id())) {
+			logger_->info("Trace spans of jobs are written to {}", trace_file);
+		} else {
+			logger_->warn("Trace file {} cannot be opened, tracing is disabled", trace_file);
+		}
+	}
+
 	return;
 }
 
@@ -182,8 +208,10 @@ void worker_core::broker_init()
 {
 	logger_->info("Initializing broker connection...");
 	auto broker_proxy = std::make_shared<connection_proxy>(zmq_context_);
+	cancellation_ = std::make_shared<helpers::cancellation_token>();
 
-	broker_ = std::make_shared<broker_connection<connection_proxy>>(config_, broker_proxy, logger_);
+	broker_ = std::make_shared<broker_connection<connection_proxy>>(
+		config_, broker_proxy, logger_, warmer_, cancellation_);
 	logger_->info("Broker connection initialized.");
 
 	return;
@@ -193,8 +221,23 @@ void worker_core::fileman_init()
 {
 	logger_->info("Initializing file managers...");
 	auto fileman_conf = config_->get_filemans_configs();
-	remote_fm_ = std::make_shared<http_manager>(fileman_conf, logger_);
-	cache_fm_ = std::make_shared<cache_manager>(config_->get_cache_dir(), logger_);
+	// all transfers share the limits, background ones (cache warm-up) have low priority
+	auto governor =
+		std::make_shared<transfer_governor>(config_->get_max_transfers(), config_->get_max_transfer_bandwidth());
+	// file servers with local storage are accessed directly, HTTP is used for the rest
+	remote_fm_ = std::make_shared<local_file_manager>(
+		fileman_conf, std::make_shared<http_manager>(fileman_conf, logger_, governor), logger_);
+	auto background_fm = std::make_shared<local_file_manager>(fileman_conf,
+		std::make_shared<http_manager>(fileman_conf, logger_, governor, transfer_priority::LOW),
+		logger_);
+	auto cache = std::make_shared<cache_manager>(config_->get_cache_dir(), logger_);
+	cache_fm_ = cache;
+
+	// the command line warm-up needs at least one thread even if it is disabled for the broker
+	std::size_t warmup_threads = config_->get_cache_warmup_threads();
+	if (!warmup_files_.empty() && warmup_threads == 0) { warmup_threads = 1; }
+	auto warmup_dir = working_directory_ / "warmup" / std::to_string(config_->get_worker_id());
+	warmer_ = std::make_shared<cache_warmer>(background_fm, cache, warmup_dir, warmup_threads, logger_);
 	logger_->info("File managers initialized.");
 
 	return;
@@ -204,13 +247,67 @@ void worker_core::receiver_init()
 {
 	logger_->info("Initializing job receiver and evaluator...");
 	auto progr_callback = std::make_shared<progress_callback>(zmq_context_, logger_);
-	auto evaluator =
-		std::make_shared<job_evaluator>(logger_, config_, remote_fm_, cache_fm_, working_directory_, progr_callback);
+	auto evaluator = std::make_shared<job_evaluator>(
+		logger_, config_, remote_fm_, cache_fm_, working_directory_, progr_callback, cancellation_);
 	job_receiver_ = std::make_shared<job_receiver>(zmq_context_, evaluator, logger_);
 	logger_->info("Job receiver and evaluator initialized.");
 	return;
 }
 
+void worker_core::warmup()
+{
+	// load all job configurations first, so that nothing is downloaded if any of them is broken
+	std::vector<std::string> urls;
+	std::vector<std::shared_ptr<job_metadata>> jobs;
+	for (auto &item : warmup_files_) {
+		// URLs are passed to the file managers, which serve HTTP(S) and configured local (file://) servers
+		auto scheme_end = item.find("://");
+		if (scheme_end != std::string::npos) {
+			auto scheme = item.substr(0, scheme_end);
+			if (scheme != "http" && scheme != "https" && scheme != "file") {
+				force_exit("Unsupported scheme of warm-up URL " + item);
+			}
+			urls.push_back(item);
+			continue;
+		}
+
+		// anything else is a job configuration
+		try {
+			jobs.push_back(helpers::build_job_metadata(YAML::LoadFile(item)));
+		} catch (std::exception &e) {
+			force_exit("Error loading job configuration " + item + ": " + e.what());
+		}
+	}
+
+	warmer_->warmup(urls);
+	for (auto &job : jobs) { warmer_->warmup(*job); }
+
+	logger_->info("Waiting for the cache warm-up to finish...");
+	warmer_->wait();
+}
+
+void worker_core::affinity_init()
+{
+	// sandboxed programs are pinned in a forked child just before isolate is executed, where failures cannot be
+	// reported, so the settings are tried in a throwaway thread first
+	bool box_cpus_ok = true;
+	bool box_mems_ok = true;
+	std::thread check([&] {
+		box_cpus_ok = helpers::set_thread_cpu_affinity(config_->get_box_cpus());
+		box_mems_ok = helpers::set_thread_memory_nodes(config_->get_box_mems());
+	});
+	check.join();
+	if (!box_cpus_ok) { logger_->warn("CPUs of sandboxed programs cannot be set, they are not restricted"); }
+	if (!box_mems_ok) { logger_->warn("Memory nodes of sandboxed programs cannot be set, they are not restricted"); }
+
+	if (config_->get_worker_cpus().empty()) { return; }
+	if (helpers::set_process_cpu_affinity(config_->get_worker_cpus())) {
+		logger_->info("Worker threads pinned to their reserved CPUs");
+	} else {
+		logger_->warn("Worker threads cannot be pinned to their reserved CPUs");
+	}
+}
+
 void worker_core::filesystem_init()
 {
 	try {
@@ -17,6 +17,7 @@
 #include "config/log_config.h"
 #include "config/worker_config.h"
 #include "connection_proxy.h"
+#include "fileman/cache_warmer.h"
 #include "fileman/fallback_file_manager.h"
 #include "fileman/file_manager_interface.h"
 #include "job/job_receiver.h"
@@ -52,6 +53,8 @@ public:
 	/**
 	 * Constructors initializes all things,	all we have to do now is launch all the fun.
 	 * This method creates separate thread for broker_connection and starts job_evaluator service.
+	 * If files to prefetch were given on command line, they are downloaded into the cache instead and
+	 * the method returns when it is done.
 	 */
 	void run();
 
@@ -111,6 +114,16 @@ private:
 	 */
 	void filesystem_init();
 
+	/**
+	 * Pin the worker to its reserved CPUs and check CPUs and memory nodes of sandboxed programs.
+	 */
+	void affinity_init();
+
+	/**
+	 * Prefetch files given on command line into the cache and wait until they are downloaded.
+	 */
+	void warmup();
+
 
 	// PRIVATE DATA MEMBERS
 	/** Cmd line parameters */
@@ -118,6 +131,8 @@ private:
 
 	/** Filename of default configuration of worker */
 	std::string config_filename_;
+	/** URLs of files or paths to job configurations which should be prefetched into the cache */
+	std::vector<std::string> warmup_files_;
 	/** Loaded worker configuration */
 	std::shared_ptr<worker_config> config_;
 
@@ -131,6 +146,10 @@ private:
 	std::shared_ptr<file_manager_interface> remote_fm_;
 	/** File manager that works with a local cache */
 	std::shared_ptr<file_manager_interface> cache_fm_;
+	/** Prefetching of files into the local cache */
+	std::shared_ptr<cache_warmer> warmer_;
+	/** Cancellation of jobs requested by the broker, shared by the broker connection and the evaluator */
+	std::shared_ptr<helpers::cancellation_token> cancellation_;
 
 	/** Handles evaluation and all things around */
 	std::shared_ptr<job_receiver> job_receiver_;
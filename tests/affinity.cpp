@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "helpers/affinity.h"
+
+using namespace testing;
+
+
+TEST(affinity, ParseCpuList)
+{
+	EXPECT_THAT(helpers::parse_cpu_list(""), IsEmpty());
+	EXPECT_THAT(helpers::parse_cpu_list("3"), ElementsAre(3));
+	EXPECT_THAT(helpers::parse_cpu_list("0-3"), ElementsAre(0, 1, 2, 3));
+	EXPECT_THAT(helpers::parse_cpu_list("8, 2-3,6,3"), ElementsAre(2, 3, 6, 8));
+}
+
+TEST(affinity, ParseMalformedCpuList)
+{
+	EXPECT_THROW(helpers::parse_cpu_list("a"), std::invalid_argument);
+	EXPECT_THROW(helpers::parse_cpu_list("1,"), std::invalid_argument);
+	EXPECT_THROW(helpers::parse_cpu_list("1-"), std::invalid_argument);
+	EXPECT_THROW(helpers::parse_cpu_list("-1"), std::invalid_argument);
+	EXPECT_THROW(helpers::parse_cpu_list("3-1"), std::invalid_argument);
+}
+
+TEST(affinity, EmptyListsAreNoop)
+{
+	EXPECT_TRUE(helpers::set_process_cpu_affinity({}));
+	EXPECT_TRUE(helpers::set_thread_cpu_affinity({}));
+	EXPECT_TRUE(helpers::set_thread_memory_nodes({}));
+}
+
+#ifndef _WIN32
+TEST(affinity, ResetThreadAffinity)
+{
+	cpu_set_t original;
+	ASSERT_EQ(0, sched_getaffinity(0, sizeof(original), &original));
+	std::size_t cpu = 0;
+	while (!CPU_ISSET(cpu, &original)) { ++cpu; }
+
+	// the process is pinned in a child, the test process must not be affected
+	pid_t pid = fork();
+	ASSERT_NE(-1, pid);
+	if (pid == 0) {
+		cpu_set_t current;
+		bool ok = helpers::set_process_cpu_affinity({cpu});
+		ok = ok && sched_getaffinity(0, sizeof(current), &current) == 0 && CPU_COUNT(&current) == 1;
+		ok = ok && helpers::set_thread_cpu_affinity({});
+		ok = ok && sched_getaffinity(0, sizeof(current), &current) == 0 && CPU_EQUAL(&current, &original);
+		_exit(ok ? 0 : 1);
+	}
+	int status;
+	ASSERT_EQ(pid, waitpid(pid, &status, 0));
+	EXPECT_TRUE(WIFEXITED(status));
+	EXPECT_EQ(0, WEXITSTATUS(status));
+}
+#endif
@@ -0,0 +1,124 @@
+#ifndef _WIN32
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <cstdlib>
+#include <filesystem>
+
+#include "sandbox/box_pool.h"
+#include "sandbox/isolate_box.h"
+#include "sandbox/sandbox_base.h"
+
+namespace fs = std::filesystem;
+
+/**
+ * Boxes are initialized by the isolate stub of the load generator, which creates plain directories.
+ */
+class box_pool_test : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		const char *path = std::getenv("PATH");
+		old_path_ = path != nullptr ? path : "";
+		setenv("PATH", (fs::absolute("load_generator").string() + ":" + old_path_).c_str(), 1);
+
+		root_ = fs::temp_directory_path() / "recodex_box_pool_test";
+		fs::remove_all(root_);
+		setenv("ISOLATE_STUB_ROOT", root_.c_str(), 1);
+	}
+
+	void TearDown() override
+	{
+		setenv("PATH", old_path_.c_str(), 1);
+		unsetenv("ISOLATE_STUB_ROOT");
+		fs::remove_all(root_);
+	}
+
+	bool box_exists(std::size_t id)
+	{
+		return fs::exists(root_ / std::to_string(id));
+	}
+
+	std::string old_path_;
+	fs::path root_;
+	sandbox_limits limits_;
+};
+
+TEST_F(box_pool_test, PreparedBoxIsUsed)
+{
+	box_pool pool({5, 6});
+	pool.prepare(limits_, "data");
+	auto box = pool.get(limits_, "data");
+	EXPECT_EQ(5u, box->get_id());
+	EXPECT_EQ((root_ / "5" / "box").string(), box->get_dir());
+
+	// the next box gets the other identifier
+	pool.prepare(limits_, "data");
+	auto next = pool.get(limits_, "data");
+	EXPECT_EQ(6u, next->get_id());
+}
+
+TEST_F(box_pool_test, IncompatiblePreparedBox)
+{
+	box_pool pool({5});
+	pool.prepare(limits_, "data");
+
+	// the prepared box has no quotas, it is cleaned up and its identifier is used for the new box
+	sandbox_limits quotas;
+	quotas.disk_quotas = true;
+	auto box = pool.get(quotas, "data");
+	EXPECT_EQ(5u, box->get_id());
+	EXPECT_TRUE(box->is_compatible(quotas, "data"));
+	EXPECT_TRUE(box_exists(5));
+}
+
+TEST_F(box_pool_test, PreparedBoxOfSkippedTask)
+{
+	box_pool pool({5});
+	pool.prepare(limits_, "skipped");
+
+	// the box of the skipped task is the only one, it is discarded to free the identifier
+	auto box = pool.get(limits_, "data");
+	EXPECT_EQ(5u, box->get_id());
+	EXPECT_EQ("data", box->get_data_dir());
+}
+
+TEST_F(box_pool_test, NoFreeBox)
+{
+	box_pool pool({5});
+	auto box = pool.get(limits_, "data");
+
+	// nothing to be prepared
+	pool.prepare(limits_, "data");
+	EXPECT_THROW(pool.get(limits_, "data"), sandbox_exception);
+
+	// the identifier is free again when the box is destroyed
+	box = nullptr;
+	EXPECT_FALSE(box_exists(5));
+	EXPECT_EQ(5u, pool.get(limits_, "data")->get_id());
+}
+
+TEST_F(box_pool_test, Discard)
+{
+	box_pool pool({5, 6});
+	pool.prepare(limits_, "first");
+	pool.prepare(limits_, "second");
+	pool.discard();
+	EXPECT_FALSE(box_exists(5));
+	EXPECT_FALSE(box_exists(6));
+
+	pool.prepare(limits_, "data");
+	EXPECT_EQ(5u, pool.get(limits_, "data")->get_id());
+}
+
+TEST_F(box_pool_test, FailedPreparation)
+{
+	// isolate cannot be executed, the failure is only logged and the box is initialized again when needed
+	box_pool pool({5});
+	setenv("PATH", "/nonexistent", 1);
+	pool.prepare(limits_, "data");
+	EXPECT_THROW(pool.get(limits_, "data"), sandbox_exception);
+}
+
+#endif
@@ -111,3 +111,22 @@ TEST(broker_connection, sends_ping)
 
 	connection.receive_tasks();
 }
+
+TEST(broker_connection, forwards_progress)
+{
+	auto config = std::make_shared<NiceMock<mock_worker_config>>();
+	auto proxy = std::make_shared<StrictMock<mock_connection_proxy>>();
+	broker_connection<mock_connection_proxy> connection(config, proxy);
+
+	EXPECT_CALL(*proxy, send_broker(ElementsAre("ping"))).WillRepeatedly(Return(true));
+
+	{
+		InSequence s;
+
+		EXPECT_CALL(*proxy, poll(_, _, _, _)).WillOnce(DoAll(ClearFlags(), SetFlag(message_origin::PROGRESS)));
+		EXPECT_CALL(*proxy, forward_progress(_)).WillOnce(Return(true));
+		EXPECT_CALL(*proxy, poll(_, _, _, _)).WillRepeatedly(SetArgReferee<2>(true));
+	}
+
+	connection.receive_tasks();
+}
@@ -34,6 +34,8 @@ TEST(job_metadata, build_all_from_yaml)
 							   "          stderr: before_stderr_${RESULT_DIR}_after_stderr\n"
 							   "          output: true\n"
 							   "          chdir: ${EVAL_DIR}\n"
+							   "          outputs:\n"
+							   "              - ${EVAL_DIR}/a.out\n"
 							   "          limits:\n"
 							   "              - hw-group-id: group1\n"
 							   "                time: 5\n"
@@ -93,6 +95,7 @@ TEST(job_metadata, build_all_from_yaml)
 	EXPECT_EQ(sandbox->std_error, "before_stderr_${RESULT_DIR}_after_stderr");
 	EXPECT_EQ(sandbox->output, true);
 	EXPECT_EQ(sandbox->chdir, "${EVAL_DIR}");
+	EXPECT_EQ(sandbox->outputs, std::vector<std::string>{"${EVAL_DIR}/a.out"});
 
 	EXPECT_EQ(1u, limits->environ_vars.size());
 	auto envs = std::pair<std::string, std::string>{"ISOLATE_TMP", "/tmp"};
@@ -2,6 +2,10 @@
 #include <gmock/gmock.h>
 #include <filesystem>
 #include <fstream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
 
 #include "fileman/cache_manager.h"
 
@@ -80,3 +84,99 @@ TEST(CacheManager, PutNonexistingFile)
 	EXPECT_THROW(m.put_file((tmp / "as4df.txt").string(), "as4df.txt"), fm_exception);
 	fs::remove_all((tmp / "recodex").string());
 }
+
+TEST(CacheManager, PutFileLeavesNoTemporaryFiles)
+{
+	auto tmp = fs::temp_directory_path();
+	cache_manager m((tmp / "recodex").string());
+	EXPECT_THROW(m.put_file((tmp / "as4df.txt").string(), "as4df.txt"), fm_exception);
+	EXPECT_TRUE(fs::is_empty(tmp / "recodex"));
+	fs::remove_all((tmp / "recodex").string());
+}
+
+TEST(CacheManager, GetFileSize)
+{
+	auto tmp = fs::temp_directory_path();
+	fs::create_directory(tmp / "recodex");
+	{
+		ofstream file((tmp / "recodex" / "test.txt").string());
+		file << "testing input";
+	}
+	cache_manager m((tmp / "recodex").string());
+
+	std::uintmax_t size = 0;
+	EXPECT_TRUE(m.get_file_size("test.txt", size));
+	EXPECT_EQ(13u, size);
+	EXPECT_FALSE(m.get_file_size("nonexisting.txt", size));
+
+	fs::remove_all(tmp / "recodex");
+}
+
+// File locking is only supported on linux platform
+#ifndef _WIN32
+TEST(CacheManager, LockFile)
+{
+	auto tmp = fs::temp_directory_path();
+	cache_manager m((tmp / "recodex").string());
+	cache_manager other((tmp / "recodex").string());
+
+	auto lock = m.lock_file("test.txt");
+	ASSERT_NE(lock, nullptr);
+	EXPECT_TRUE(fs::exists(tmp / "recodex" / "test.txt.lock"));
+
+	// lock file is not a cached file
+	EXPECT_THROW(m.get_file("test.txt", (tmp / "test.txt").string()), fm_exception);
+
+	// another holder has to wait until the lock is released
+	std::atomic<bool> locked(false);
+	std::thread waiting([&]() {
+		auto other_lock = other.lock_file("test.txt");
+		locked = true;
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	EXPECT_FALSE(locked);
+
+	lock.reset();
+	waiting.join();
+	EXPECT_TRUE(locked);
+
+	// the lock file exists only while the lock is held
+	EXPECT_FALSE(fs::exists(tmp / "recodex" / "test.txt.lock"));
+
+	// different files do not block each other
+	lock = m.lock_file("test.txt");
+	EXPECT_NE(other.lock_file("another.txt"), nullptr);
+
+	lock.reset();
+	fs::remove_all((tmp / "recodex").string());
+}
+
+TEST(CacheManager, LockFileRemovedByHolder)
+{
+	auto tmp = fs::temp_directory_path();
+	cache_manager m((tmp / "recodex").string());
+	cache_manager other((tmp / "recodex").string());
+
+	// several waiters, each of them has to get the lock alone although the lock file is replaced
+	auto lock = m.lock_file("test.txt");
+	std::atomic<int> holders(0);
+	std::atomic<int> max_holders(0);
+	std::vector<std::thread> waiting;
+	for (int i = 0; i < 4; ++i) {
+		waiting.emplace_back([&]() {
+			auto other_lock = other.lock_file("test.txt");
+			int current = ++holders;
+			if (current > max_holders) { max_holders = current; }
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			--holders;
+		});
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	lock.reset();
+	for (auto &thread : waiting) { thread.join(); }
+
+	EXPECT_EQ(1, max_holders);
+	EXPECT_FALSE(fs::exists(tmp / "recodex" / "test.txt.lock"));
+	fs::remove_all((tmp / "recodex").string());
+}
+#endif
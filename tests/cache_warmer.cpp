@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "mocks.h"
+#include "fileman/cache_warmer.h"
+
+using namespace testing;
+using namespace std;
+
+
+/**
+ * Cache and temporary directory which are removed after each test.
+ */
+class cache_warmer_test : public Test
+{
+protected:
+	fs::path dir_ = fs::temp_directory_path() / "recodex_cache_warmer_test";
+	fs::path cache_dir_ = dir_ / "cache";
+	fs::path temp_dir_ = dir_ / "temp";
+	shared_ptr<cache_manager> cache_;
+	shared_ptr<StrictMock<mock_file_manager>> remote_ = make_shared<StrictMock<mock_file_manager>>();
+
+	void SetUp() override
+	{
+		fs::remove_all(dir_);
+		cache_ = make_shared<cache_manager>(cache_dir_.string());
+	}
+
+	void TearDown() override
+	{
+		fs::remove_all(dir_);
+	}
+};
+
+ACTION_P(WriteFile, content)
+{
+	ofstream file(arg1);
+	file << content;
+}
+
+string read_file(const fs::path &path)
+{
+	ifstream file(path.string());
+	return string(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+}
+
+
+TEST_F(cache_warmer_test, DownloadsFiles)
+{
+	EXPECT_CALL(*remote_, get_file("http://localhost/data/a.in", _)).WillOnce(WriteFile("a"));
+	EXPECT_CALL(*remote_, get_file("http://localhost/data/b.in", _)).WillOnce(WriteFile("b"));
+
+	cache_warmer warmer(remote_, cache_, temp_dir_, 2);
+	warmer.warmup(vector<string>{"http://localhost/data/a.in", "http://localhost/data/b.in"});
+	warmer.wait();
+
+	EXPECT_EQ("a", read_file(cache_dir_ / "a.in"));
+	EXPECT_EQ("b", read_file(cache_dir_ / "b.in"));
+	EXPECT_TRUE(fs::is_empty(temp_dir_));
+}
+
+TEST_F(cache_warmer_test, SkipsCachedFiles)
+{
+	{
+		ofstream file((cache_dir_ / "a.in").string());
+		file << "cached";
+	}
+
+	cache_warmer warmer(remote_, cache_, temp_dir_, 1);
+	warmer.warmup(vector<string>{"http://localhost/a.in", "http://localhost/a.in"});
+	warmer.wait();
+
+	EXPECT_EQ("cached", read_file(cache_dir_ / "a.in"));
+}
+
+TEST_F(cache_warmer_test, DownloadsDuplicatesOnce)
+{
+	EXPECT_CALL(*remote_, get_file("http://localhost/a.in", _)).WillOnce(WriteFile("a"));
+
+	cache_warmer warmer(remote_, cache_, temp_dir_, 2);
+	warmer.warmup(vector<string>{"http://localhost/a.in", "http://localhost/a.in"});
+	warmer.warmup(vector<string>{"http://localhost/a.in"});
+	warmer.wait();
+
+	EXPECT_EQ("a", read_file(cache_dir_ / "a.in"));
+}
+
+TEST_F(cache_warmer_test, DownloadsFilesOfJob)
+{
+	job_metadata job;
+	job.job_id = "job";
+	job.file_server_url = "http://localhost:9999";
+	job.tasks.push_back(make_shared<task_metadata>(
+		"A", 1, false, vector<string>(), task_type::INNER, "fetch", vector<string>{"abc", "${SOURCE_DIR}/a"}));
+	job.tasks.push_back(make_shared<task_metadata>(
+		"B", 1, false, vector<string>(), task_type::INNER, "cp", vector<string>{"a", "b"}));
+	job.tasks.push_back(make_shared<task_metadata>(
+		"C", 1, false, vector<string>(), task_type::INNER, "fetch", vector<string>{"def", "${SOURCE_DIR}/d"}));
+
+	EXPECT_CALL(*remote_, get_file("http://localhost:9999/abc", _)).WillOnce(WriteFile("a"));
+	EXPECT_CALL(*remote_, get_file("http://localhost:9999/def", _)).WillOnce(WriteFile("d"));
+
+	cache_warmer warmer(remote_, cache_, temp_dir_, 2);
+	warmer.warmup(job);
+	warmer.wait();
+
+	EXPECT_EQ("a", read_file(cache_dir_ / "abc"));
+	EXPECT_EQ("d", read_file(cache_dir_ / "def"));
+}
+
+TEST_F(cache_warmer_test, FailedDownloadIsSkipped)
+{
+	EXPECT_CALL(*remote_, get_file("http://localhost/a.in", _)).WillOnce(Throw(fm_exception("Not found")));
+	EXPECT_CALL(*remote_, get_file("http://localhost/b.in", _)).WillOnce(WriteFile("b"));
+
+	cache_warmer warmer(remote_, cache_, temp_dir_, 1);
+	warmer.warmup(vector<string>{"http://localhost/a.in", "http://localhost/b.in"});
+	warmer.wait();
+
+	EXPECT_FALSE(cache_->contains("a.in"));
+	EXPECT_EQ("b", read_file(cache_dir_ / "b.in"));
+	EXPECT_TRUE(fs::is_empty(temp_dir_));
+}
+
+TEST_F(cache_warmer_test, PausedWarmerDoesNotDownload)
+{
+	cache_warmer warmer(remote_, cache_, temp_dir_, 2);
+	warmer.pause();
+	warmer.warmup(vector<string>{"http://localhost/a.in"});
+	this_thread::sleep_for(chrono::milliseconds(50));
+	EXPECT_FALSE(cache_->contains("a.in"));
+
+	EXPECT_CALL(*remote_, get_file("http://localhost/a.in", _)).WillOnce(WriteFile("a"));
+	warmer.resume();
+	warmer.wait();
+
+	EXPECT_EQ("a", read_file(cache_dir_ / "a.in"));
+}
+
+TEST_F(cache_warmer_test, Disabled)
+{
+	cache_warmer warmer(remote_, cache_, temp_dir_, 0);
+	warmer.warmup(vector<string>{"http://localhost/a.in"});
+	warmer.wait();
+
+	EXPECT_FALSE(cache_->contains("a.in"));
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "helpers/cancellation_token.h"
+
+using namespace testing;
+
+
+TEST(cancellation_token, CancelRunningJob)
+{
+	helpers::cancellation_token token;
+	EXPECT_FALSE(token.is_cancelled());
+
+	token.start("job1");
+	EXPECT_FALSE(token.is_cancelled());
+	EXPECT_FALSE(token.cancel("job2"));
+	EXPECT_FALSE(token.is_cancelled());
+	EXPECT_TRUE(token.cancel("job1"));
+	EXPECT_TRUE(token.is_cancelled());
+
+	token.finish();
+	EXPECT_FALSE(token.is_cancelled());
+	token.start("job3");
+	EXPECT_FALSE(token.is_cancelled());
+}
+
+TEST(cancellation_token, CancelBeforeStart)
+{
+	helpers::cancellation_token token;
+	EXPECT_FALSE(token.cancel("job1"));
+	token.start("job1");
+	EXPECT_TRUE(token.is_cancelled());
+}
+
+TEST(cancellation_token, CancelSeveralJobsBeforeStart)
+{
+	helpers::cancellation_token token;
+	EXPECT_FALSE(token.cancel("job1"));
+	EXPECT_FALSE(token.cancel("job2"));
+
+	token.start("job1");
+	EXPECT_TRUE(token.is_cancelled());
+	token.finish();
+
+	// the cancellation is forgotten once the job is evaluated
+	token.start("job1");
+	EXPECT_FALSE(token.is_cancelled());
+	token.finish();
+
+	token.start("job2");
+	EXPECT_TRUE(token.is_cancelled());
+	token.finish();
+}
+
+TEST(cancellation_token, PendingCancellationsAreBounded)
+{
+	helpers::cancellation_token token;
+	for (std::size_t i = 0; i <= helpers::cancellation_token::max_pending_cancellations; ++i) {
+		token.cancel("job" + std::to_string(i));
+	}
+
+	// the oldest cancellation is dropped
+	token.start("job0");
+	EXPECT_FALSE(token.is_cancelled());
+	token.finish();
+	token.start("job1");
+	EXPECT_TRUE(token.is_cancelled());
+}
+
+#ifndef _WIN32
+TEST(cancellation_token, TerminatesAttachedProcess)
+{
+	helpers::cancellation_token token;
+	token.start("job1");
+
+	pid_t pid = fork();
+	ASSERT_NE(-1, pid);
+	if (pid == 0) {
+		pause();
+		_exit(0);
+	}
+
+	EXPECT_TRUE(token.attach_process(pid));
+	token.cancel("job1");
+
+	int status;
+	ASSERT_EQ(pid, waitpid(pid, &status, 0));
+	EXPECT_TRUE(WIFSIGNALED(status));
+	EXPECT_EQ(SIGTERM, WTERMSIG(status));
+
+	// the job is cancelled already, so another process is terminated right away
+	pid = fork();
+	ASSERT_NE(-1, pid);
+	if (pid == 0) {
+		pause();
+		_exit(0);
+	}
+	EXPECT_FALSE(token.attach_process(pid));
+	ASSERT_EQ(pid, waitpid(pid, &status, 0));
+	EXPECT_TRUE(WIFSIGNALED(status));
+}
+#endif
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <fstream>
+#include <thread>
+
+#include "sandbox/cgroup_sampler.h"
+
+using namespace std;
+
+
+class cgroup_sampler_test : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		cgroup_ = fs::temp_directory_path() / "recodex_cgroup_sampler_test";
+		fs::remove_all(cgroup_);
+		fs::create_directories(cgroup_);
+	}
+
+	void TearDown() override
+	{
+		fs::remove_all(cgroup_);
+	}
+
+	void write(const string &name, const string &content)
+	{
+		ofstream out((cgroup_ / name).string());
+		out << content;
+	}
+
+	fs::path cgroup_;
+};
+
+
+TEST_F(cgroup_sampler_test, ReadSample)
+{
+	write("memory.current", "10485760\n");
+	write("cpu.stat", "usage_usec 1500000\nuser_usec 1000000\nsystem_usec 500000\n");
+	write("io.stat",
+		"8:0 rbytes=4096 wbytes=8192 rios=1 wios=2 dbytes=0 dios=0\n"
+		"8:16 rbytes=1024 wbytes=0 rios=1 wios=0 dbytes=0 dios=0\n");
+	write("pids.current", "3\n");
+
+	resource_sample sample;
+	ASSERT_TRUE(cgroup_sampler::read_sample(cgroup_, sample));
+	EXPECT_EQ(10240u, sample.memory);
+	EXPECT_EQ(1500u, sample.cpu_time);
+	EXPECT_EQ(5120u, sample.io_read);
+	EXPECT_EQ(8192u, sample.io_write);
+	EXPECT_EQ(3u, sample.pids);
+}
+
+TEST_F(cgroup_sampler_test, ReadSampleOnlyMemory)
+{
+	write("memory.current", "2048\n");
+
+	resource_sample sample;
+	ASSERT_TRUE(cgroup_sampler::read_sample(cgroup_, sample));
+	EXPECT_EQ(2u, sample.memory);
+	EXPECT_EQ(0u, sample.cpu_time);
+	EXPECT_EQ(0u, sample.io_read);
+	EXPECT_EQ(0u, sample.pids);
+}
+
+TEST_F(cgroup_sampler_test, MissingCgroup)
+{
+	resource_sample sample;
+	EXPECT_FALSE(cgroup_sampler::read_sample(cgroup_ / "nonexisting", sample));
+
+	cgroup_sampler sampler(cgroup_ / "nonexisting", chrono::milliseconds(1), 10);
+	sampler.start();
+	this_thread::sleep_for(chrono::milliseconds(20));
+	EXPECT_TRUE(sampler.stop().empty());
+}
+
+TEST_F(cgroup_sampler_test, BoundedSamples)
+{
+	write("memory.current", "1024\n");
+
+	cgroup_sampler sampler(cgroup_, chrono::milliseconds(1), 4);
+	sampler.start();
+	this_thread::sleep_for(chrono::milliseconds(100));
+	auto samples = sampler.stop();
+
+	// samples are thinned out, but they still span the whole run
+	ASSERT_GE(samples.size(), 2u);
+	EXPECT_LE(samples.size(), 4u);
+	EXPECT_EQ(0u, samples.front().time);
+	EXPECT_GE(samples.back().time, 20u);
+	for (size_t i = 1; i < samples.size(); ++i) { EXPECT_LT(samples[i - 1].time, samples[i].time); }
+	EXPECT_EQ(1u, samples.back().memory);
+}
@@ -45,6 +45,62 @@ TEST(fallback_file_manager, GetFileFromRemote)
 	EXPECT_NO_THROW(m.get_file(remote_path, local_path));
 }
 
+/**
+ * Cache mock which supports locking and counts the acquired locks.
+ */
+class mock_locking_file_manager : public mock_file_manager
+{
+public:
+	std::size_t locks = 0;
+
+	std::unique_ptr<file_lock> lock_file(const std::string &name) override
+	{
+		++locks;
+		return std::unique_ptr<file_lock>(new file_lock());
+	}
+};
+
+TEST(fallback_file_manager, GetFileFromRemoteLocked)
+{
+	auto cache = unique_ptr<mock_locking_file_manager>(new mock_locking_file_manager);
+	auto remote = unique_ptr<mock_file_manager>(new mock_file_manager);
+	auto cache_ptr = cache.get();
+
+	std::string remote_path = "file.txt";
+	std::string local_path = "/tmp/file.txt";
+
+	{
+		InSequence s;
+		EXPECT_CALL((*cache), get_file(remote_path, local_path)).WillOnce(Throw(fm_exception("")));
+		// another holder of the lock might have fetched the file meanwhile
+		EXPECT_CALL((*cache), get_file(remote_path, local_path)).WillOnce(Throw(fm_exception("")));
+		EXPECT_CALL((*remote), get_file(remote_path, local_path)).Times(1);
+		EXPECT_CALL((*cache), put_file(local_path, remote_path)).Times(1);
+	}
+
+	fallback_file_manager m(move(cache), move(remote));
+	EXPECT_NO_THROW(m.get_file(remote_path, local_path));
+	EXPECT_EQ(cache_ptr->locks, 1u);
+}
+
+TEST(fallback_file_manager, GetFileFetchedWhileWaitingForLock)
+{
+	auto cache = unique_ptr<mock_locking_file_manager>(new mock_locking_file_manager);
+	auto remote = unique_ptr<mock_file_manager>(new StrictMock<mock_file_manager>);
+
+	std::string remote_path = "file.txt";
+	std::string local_path = "/tmp/file.txt";
+
+	{
+		InSequence s;
+		EXPECT_CALL((*cache), get_file(remote_path, local_path)).WillOnce(Throw(fm_exception("")));
+		EXPECT_CALL((*cache), get_file(remote_path, local_path)).Times(1);
+	}
+
+	fallback_file_manager m(move(cache), move(remote));
+	EXPECT_NO_THROW(m.get_file(remote_path, local_path));
+}
+
 TEST(fallback_file_manager, PutFileToRemote)
 {
 	auto cache = unique_ptr<mock_file_manager>(new mock_file_manager);
@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <fstream>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
 
 #include "helpers/filesystem.h"
 
@@ -142,3 +147,180 @@ TEST(filesystem_test, test_absolute_8)
 		(fs::path("/path/outside/sandbox") / fs::path("test1") / fs::path("sub") / fs::path("output.stderr")).string(),
 		result.string());
 }
+
+TEST(filesystem_test, directory_size)
+{
+	auto dir = fs::temp_directory_path() / "recodex_directory_size_test";
+	fs::remove_all(dir);
+	EXPECT_EQ(0u, helpers::directory_size(dir));
+
+	fs::create_directories(dir / "sub");
+	{
+		std::ofstream first((dir / "first.txt").string());
+		first << "12345";
+		std::ofstream second((dir / "sub" / "second.txt").string());
+		second << "1234567890";
+	}
+	// symlinks are not counted
+	fs::create_symlink(dir / "first.txt", dir / "sub" / "link.txt");
+
+	EXPECT_EQ(15u, helpers::directory_size(dir));
+	fs::remove_all(dir);
+}
+
+TEST(filesystem_test, read_head_tail)
+{
+	auto file = fs::temp_directory_path() / "recodex_read_head_tail_test";
+	{
+		std::ofstream out(file.string());
+		out << "0123456789abcdefghijklmnopqrstuvwxyz";
+	}
+
+	EXPECT_EQ("0123456789abcdefghijklmnopqrstuvwxyz", helpers::read_head_tail(file, 100));
+	EXPECT_EQ("0123456789abcdefghijklmnopqrstuvwxyz", helpers::read_head_tail(file, 36));
+	EXPECT_EQ("0123456\n...\ntuvwxyz", helpers::read_head_tail(file, 19));
+	EXPECT_EQ("012345\n...\ntuvwxyz", helpers::read_head_tail(file, 18));
+	// too short for the separator
+	EXPECT_EQ("0123456789", helpers::read_head_tail(file, 10));
+	EXPECT_EQ("", helpers::read_head_tail(file, 0));
+	EXPECT_EQ("", helpers::read_head_tail(fs::temp_directory_path() / "recodex_nonexisting_file", 10));
+	fs::remove(file);
+}
+
+TEST(filesystem_test, head_tail)
+{
+	std::string content = "0123456789abcdefghijklmnopqrstuvwxyz";
+	EXPECT_EQ(content, helpers::head_tail(content, 100));
+	EXPECT_EQ(content, helpers::head_tail(content, 36));
+	EXPECT_EQ("0123456\n...\ntuvwxyz", helpers::head_tail(content, 19));
+	EXPECT_EQ("012345\n...\ntuvwxyz", helpers::head_tail(content, 18));
+	EXPECT_EQ("0123456789", helpers::head_tail(content, 10));
+	EXPECT_EQ("", helpers::head_tail(content, 0));
+}
+
+TEST(filesystem_test, copy_file_prefix)
+{
+	auto src = fs::temp_directory_path() / "recodex_copy_file_prefix_src";
+	auto dest = fs::temp_directory_path() / "recodex_copy_file_prefix_dest";
+	{
+		std::ofstream out(src.string());
+		out << "0123456789";
+		std::ofstream old(dest.string());
+		old << "previous content of the file";
+	}
+
+	EXPECT_EQ(4u, helpers::copy_file_prefix(src, dest, 4));
+	EXPECT_EQ(4u, fs::file_size(dest));
+	EXPECT_EQ(10u, helpers::copy_file_prefix(src, dest, 100));
+	std::ifstream in(dest.string());
+	std::string content;
+	in >> content;
+	EXPECT_EQ("0123456789", content);
+
+	fs::remove(src);
+	EXPECT_THROW(helpers::copy_file_prefix(src, dest, 100), helpers::filesystem_exception);
+	fs::remove(dest);
+}
+
+TEST(filesystem_test, fast_copy_file)
+{
+	auto dir = fs::temp_directory_path() / "recodex_fast_copy_file_test";
+	fs::remove_all(dir);
+	fs::create_directories(dir);
+	{
+		std::ofstream out((dir / "src").string());
+		out << "content";
+	}
+	fs::permissions(dir / "src", fs::perms::owner_exec, fs::perm_options::add);
+
+	auto before = helpers::get_copy_statistics();
+	auto method = helpers::fast_copy_file(dir / "src", dir / "copy");
+	EXPECT_NE(helpers::copy_method::HARDLINK, method);
+	EXPECT_FALSE(fs::equivalent(dir / "src", dir / "copy"));
+	EXPECT_EQ(7u, fs::file_size(dir / "copy"));
+	EXPECT_NE(fs::perms::none, fs::status(dir / "copy").permissions() & fs::perms::owner_exec);
+
+	// existing destination
+	EXPECT_THROW(helpers::fast_copy_file(dir / "src", dir / "copy", false), helpers::filesystem_exception);
+	std::error_code error_code;
+	helpers::fast_copy_file(dir / "src", dir / "copy", error_code, false);
+	EXPECT_TRUE(static_cast<bool>(error_code));
+
+	EXPECT_EQ(helpers::copy_method::HARDLINK, helpers::fast_copy_file(dir / "src", dir / "copy", true, true));
+	EXPECT_TRUE(fs::equivalent(dir / "src", dir / "copy"));
+
+	auto after = helpers::get_copy_statistics();
+	EXPECT_EQ(before.hardlinks + 1, after.hardlinks);
+	EXPECT_EQ(before.reflinks + before.kernel_copies + before.buffer_copies + 1,
+		after.reflinks + after.kernel_copies + after.buffer_copies);
+
+	EXPECT_THROW(helpers::fast_copy_file(dir / "nonexisting", dir / "other"), helpers::filesystem_exception);
+	fs::remove_all(dir);
+}
+
+#ifndef _WIN32
+TEST(filesystem_test, fast_copy_file_keeps_mode)
+{
+	auto dir = fs::temp_directory_path() / "recodex_fast_copy_file_mode_test";
+	fs::remove_all(dir);
+	fs::create_directories(dir);
+	{
+		std::ofstream out((dir / "src").string());
+		out << "content";
+	}
+	auto mode = fs::perms::owner_read | fs::perms::owner_write | fs::perms::group_read | fs::perms::group_write |
+		fs::perms::others_read | fs::perms::others_write;
+	fs::permissions(dir / "src", mode);
+
+	// the umask must not strip the bits of the source
+	auto old_umask = umask(022);
+	helpers::fast_copy_file(dir / "src", dir / "new", false);
+	helpers::fast_copy_file(dir / "src", dir / "new", true);
+	helpers::copy_directory(dir, dir.string() + "_copy");
+	umask(old_umask);
+
+	EXPECT_EQ(mode, fs::status(dir / "new").permissions());
+	EXPECT_EQ(mode, fs::status(dir.string() + "_copy/src").permissions());
+
+	fs::remove_all(dir);
+	fs::remove_all(dir.string() + "_copy");
+}
+#endif
+
+TEST(filesystem_test, copy_directory)
+{
+	auto src = fs::temp_directory_path() / "recodex_copy_directory_src";
+	auto dest = fs::temp_directory_path() / "recodex_copy_directory_dest";
+	fs::remove_all(src);
+	fs::remove_all(dest);
+
+	// enough files to be copied in parallel
+	fs::create_directories(src / "sub" / "deeper");
+	for (int i = 0; i < 100; ++i) {
+		std::ofstream out((src / "sub" / ("file" + std::to_string(i))).string());
+		out << i;
+	}
+	{
+		std::ofstream out((src / "data").string());
+		out << "data";
+	}
+	fs::create_hard_link(src / "data", src / "sub" / "deeper" / "link");
+	fs::create_symlink(src / "data", src / "symlink");
+
+	helpers::copy_directory(src, dest, true);
+	EXPECT_EQ(helpers::directory_size(src), helpers::directory_size(dest));
+	EXPECT_EQ(2u, fs::file_size(dest / "sub" / "file42"));
+	EXPECT_TRUE(fs::equivalent(dest / "data", dest / "sub" / "deeper" / "link"));
+	EXPECT_FALSE(fs::equivalent(src / "data", dest / "data"));
+	EXPECT_FALSE(fs::exists(fs::symlink_status(dest / "symlink")));
+
+	// existing files are not overwritten
+	EXPECT_THROW(helpers::copy_directory(src, dest), helpers::filesystem_exception);
+
+	fs::remove_all(dest);
+	helpers::copy_directory(src, dest);
+	EXPECT_TRUE(fs::exists(fs::symlink_status(dest / "symlink")));
+
+	fs::remove_all(src);
+	fs::remove_all(dest);
+}
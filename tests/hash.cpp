@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <fstream>
+
+#include "helpers/hash.h"
+
+
+std::string sha256_of(const std::string &data)
+{
+	helpers::sha256 hash;
+	hash.update(data.data(), data.size());
+	return hash.hexdigest();
+}
+
+TEST(hash_test, sha256_vectors)
+{
+	ASSERT_EQ("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855", sha256_of(""));
+	ASSERT_EQ("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", sha256_of("abc"));
+	ASSERT_EQ("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+		sha256_of("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"));
+	ASSERT_EQ("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0", sha256_of(std::string(1000000, 'a')));
+}
+
+TEST(hash_test, sha256_incremental)
+{
+	helpers::sha256 hash;
+	std::string data = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+	for (char c : data) { hash.update(&c, 1); }
+	ASSERT_EQ(sha256_of(data), hash.hexdigest());
+}
+
+TEST(hash_test, sha256_strings_are_delimited)
+{
+	helpers::sha256 first;
+	first.update(std::string("ab"));
+	first.update(std::string("c"));
+	helpers::sha256 second;
+	second.update(std::string("a"));
+	second.update(std::string("bc"));
+	ASSERT_NE(first.hexdigest(), second.hexdigest());
+}
+
+TEST(hash_test, sha256_file)
+{
+	auto path = fs::temp_directory_path() / "recodex_hash_test.txt";
+	{
+		std::ofstream file(path.string());
+		file << "abc";
+	}
+
+	helpers::sha256 from_file;
+	from_file.update_file(path);
+	helpers::sha256 from_memory;
+	from_memory.update("abc", 3);
+	from_memory.update((std::uint64_t) 3);
+	ASSERT_EQ(from_memory.hexdigest(), from_file.hexdigest());
+
+	fs::remove(path);
+	helpers::sha256 missing;
+	ASSERT_ANY_THROW(missing.update_file(path));
+}
+
+TEST(hash_test, cached_file_digest)
+{
+	auto path = fs::temp_directory_path() / "recodex_hash_cached_test.txt";
+	{
+		std::ofstream file(path.string());
+		file << "abc";
+	}
+
+	helpers::sha256 expected;
+	expected.update_file(path);
+	auto digest = expected.hexdigest();
+	ASSERT_EQ(digest, helpers::cached_file_digest(path));
+	ASSERT_EQ(digest, helpers::cached_file_digest(path));
+
+	// changed size or modification time is noticed
+	{
+		std::ofstream file(path.string());
+		file << "abcd";
+	}
+	ASSERT_NE(digest, helpers::cached_file_digest(path));
+	{
+		std::ofstream file(path.string());
+		file << "xyz";
+	}
+	fs::last_write_time(path, fs::last_write_time(path) + std::chrono::seconds(1));
+	ASSERT_NE(digest, helpers::cached_file_digest(path));
+
+	fs::remove(path);
+	ASSERT_ANY_THROW(helpers::cached_file_digest(path));
+}
@@ -99,6 +99,30 @@ TEST(HttpManager, NonexistingServer)
 	fs::remove(tmp / "test1.txt");
 }
 
+TEST(HttpManager, ThrottledTransferIsNotStalled)
+{
+	auto tmp = fs::temp_directory_path();
+	{
+		std::ofstream out((tmp / "throttled_src.txt").string());
+		out << std::string(60000, 'x');
+	}
+
+	// the governor gives much less than the low speed limit, the download takes about two seconds
+	fileman_config config;
+	config.remote_url = "file://";
+	config.retries = 0;
+	config.low_speed_limit = 100000;
+	config.low_speed_time = 1;
+	auto governor = std::make_shared<transfer_governor>(0, 20000);
+	http_manager m({config}, nullptr, governor, transfer_priority::LOW);
+	EXPECT_NO_THROW(
+		m.get_file("file://" + (tmp / "throttled_src.txt").string(), (tmp / "throttled_dst.txt").string()));
+	EXPECT_EQ(60000u, fs::file_size(tmp / "throttled_dst.txt"));
+
+	fs::remove(tmp / "throttled_src.txt");
+	fs::remove(tmp / "throttled_dst.txt");
+}
+
 // Not testing now ...
 /*TEST(HttpManager, ValidInvalidURLs)
 {
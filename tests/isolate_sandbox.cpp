@@ -181,4 +181,56 @@ TEST(IsolateSandbox, BindDirsExecuteGCC)
 }
 
 
+TEST(IsolateSandbox, SharedBox)
+{
+	auto tmp = fs::temp_directory_path();
+	std::shared_ptr<sandbox_config> config = std::make_shared<sandbox_config>();
+	config->chdir = "";
+	config->std_output = "output.txt";
+	sandbox_limits limits;
+	limits.wall_time = 10;
+	limits.cpu_time = 10;
+	limits.extra_time = 1;
+	limits.processes = 0;
+
+	fs::create_directories(tmp / "recodex_36_test");
+	fs::permissions(tmp / "recodex_36_test", fs::perms::group_write | fs::perms::others_write, fs::perm_options::add);
+	{
+		std::ofstream file((tmp / "recodex_36_test" / "input.txt").string());
+		file << "Hello world!\n";
+	}
+
+	auto box = std::make_shared<isolate_box>(limits, 36, (tmp / "recodex_36_test").string());
+	EXPECT_EQ(box->get_dir(), "/var/local/lib/isolate/36/box");
+	EXPECT_TRUE(box->is_compatible(limits, (tmp / "recodex_36_test").string()));
+	EXPECT_FALSE(box->is_compatible(limits, (tmp / "recodex_37_test").string()));
+
+	{
+		isolate_sandbox is(config, limits, box, tmp.string());
+		auto results = is.run("/bin/cat", std::vector<std::string>{"input.txt"});
+		EXPECT_TRUE(results.status == isolate_status::OK);
+	}
+
+	// data stay in the box between commands
+	EXPECT_FALSE(fs::exists(tmp / "recodex_36_test"));
+	EXPECT_EQ(box->get_data_dir(), box->get_dir());
+
+	{
+		auto second_config = std::make_shared<sandbox_config>();
+		second_config->chdir = "";
+		second_config->std_output = "second.txt";
+		isolate_sandbox is(second_config, limits, box, tmp.string());
+		auto results = is.run("/bin/cat", std::vector<std::string>{"output.txt"});
+		EXPECT_TRUE(results.status == isolate_status::OK);
+	}
+
+	box->move_out();
+	EXPECT_EQ(box->get_data_dir(), (tmp / "recodex_36_test").string());
+	EXPECT_TRUE(fs::is_regular_file(tmp / "recodex_36_test" / "output.txt"));
+	EXPECT_EQ(fs::file_size(tmp / "recodex_36_test" / "second.txt"), 13u);
+	box = nullptr;
+	fs::remove_all(tmp / "recodex_36_test");
+}
+
+
 #endif
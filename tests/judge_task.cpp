@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <cstdio>
+#include <sstream>
+#include <thread>
+#include "tasks/internal/judge_task.h"
+#include "mocks.h"
+
+namespace fs = std::filesystem;
+using namespace testing;
+
+class judge_task_test : public ::testing::Test
+{
+protected:
+	fs::path root;
+	std::shared_ptr<judge_task> task;
+	std::shared_ptr<task_metadata> task_meta;
+
+	virtual void SetUp()
+	{
+		root = fs::temp_directory_path() / std::string(std::tmpnam(nullptr));
+		fs::create_directory(root);
+
+		create_file(root / "correct", "1 2 3\nfoo bar\n");
+		create_file(root / "same", "1 2 3\nfoo bar\n");
+		create_file(root / "shuffled", "2 3 1\nbar foo\n");
+
+		task_meta = std::make_shared<task_metadata>();
+		task_meta->binary = "judge";
+		task_meta->cmd_args = {(root / "correct").string(), (root / "same").string()};
+		task_meta->sandbox = std::make_shared<sandbox_config>();
+		task_meta->sandbox->output = true;
+		task = std::make_shared<judge_task>(1, task_meta);
+	}
+
+	std::shared_ptr<worker_config> make_config(const sandbox_limits &limits, std::size_t max_output_length)
+	{
+		limits_ = limits;
+		auto config = std::make_shared<NiceMock<mock_worker_config>>();
+		ON_CALL(*config, get_limits()).WillByDefault(ReturnRef(limits_));
+		ON_CALL(*config, get_max_output_length()).WillByDefault(Return(max_output_length));
+		return config;
+	}
+
+	sandbox_limits limits_;
+
+	virtual void TearDown()
+	{
+		fs::remove_all(root);
+		fs::remove(root);
+	}
+
+	void create_file(const fs::path &path, const std::string &content)
+	{
+		std::ofstream f(path.string());
+		f << content;
+		f.close();
+	}
+};
+
+TEST_F(judge_task_test, files_match)
+{
+	auto results = task->run();
+	ASSERT_EQ(task_status::OK, results->status) << "Failed with: " + results->error_message;
+	ASSERT_NE(nullptr, results->sandbox_status);
+	EXPECT_EQ(0, results->sandbox_status->exitcode);
+	EXPECT_EQ(isolate_status::OK, results->sandbox_status->status);
+	EXPECT_EQ("1\n", results->output_stdout);
+}
+
+TEST_F(judge_task_test, files_differ)
+{
+	task_meta->cmd_args = {(root / "correct").string(), (root / "shuffled").string()};
+
+	auto results = task->run();
+	ASSERT_EQ(task_status::FAILED, results->status);
+	ASSERT_NE(nullptr, results->sandbox_status);
+	EXPECT_EQ(1, results->sandbox_status->exitcode);
+	EXPECT_EQ(isolate_status::RE, results->sandbox_status->status);
+	EXPECT_EQ("0\n", results->output_stdout);
+	EXPECT_FALSE(results->output_stderr.empty());
+}
+
+TEST_F(judge_task_test, judge_options)
+{
+	task_meta->cmd_args = {"--shuffled-tokens", (root / "correct").string(), (root / "shuffled").string()};
+
+	auto results = task->run();
+	ASSERT_EQ(task_status::OK, results->status) << "Failed with: " + results->error_message;
+	EXPECT_EQ("1\n", results->output_stdout);
+}
+
+TEST_F(judge_task_test, wrong_exit_code_accepted)
+{
+	task_meta->cmd_args = {(root / "correct").string(), (root / "shuffled").string()};
+	task_meta->success_exit_codes = {true, true};
+
+	auto results = task->run();
+	ASSERT_EQ(task_status::OK, results->status) << "Failed with: " + results->error_message;
+	EXPECT_EQ(1, results->sandbox_status->exitcode);
+	EXPECT_EQ("0\n", results->output_stdout);
+}
+
+TEST_F(judge_task_test, missing_file)
+{
+	task_meta->cmd_args = {(root / "correct").string(), (root / "not_a_file").string()};
+
+	auto results = task->run();
+	ASSERT_EQ(task_status::FAILED, results->status);
+	EXPECT_EQ(2, results->sandbox_status->exitcode);
+	EXPECT_EQ("0\n", results->output_stdout);
+}
+
+TEST_F(judge_task_test, invalid_arguments)
+{
+	task_meta->cmd_args = {"--unknown-option", (root / "correct").string(), (root / "same").string()};
+
+	auto results = task->run();
+	ASSERT_EQ(task_status::FAILED, results->status);
+	EXPECT_EQ(2, results->sandbox_status->exitcode);
+	EXPECT_TRUE(results->output_stderr.find("Usage") != std::string::npos);
+}
+
+TEST_F(judge_task_test, wall_time_limit)
+{
+	// full LCS of two long lines takes seconds, much longer than the limit
+	std::ostringstream correct;
+	std::ostringstream tested;
+	for (std::size_t i = 0; i < 20000; ++i) {
+		correct << i % 10 << " ";
+		tested << (i * 7) % 10 << " ";
+	}
+	create_file(root / "correct", correct.str());
+	create_file(root / "tested", tested.str());
+	task_meta->cmd_args = {
+		"--token-lcs-approx-max-window", "0", (root / "correct").string(), (root / "tested").string()};
+
+	sandbox_limits limits;
+	limits.wall_time = 0.05f;
+	task = std::make_shared<judge_task>(1, task_meta, make_config(limits, 1000));
+
+	auto results = task->run();
+	ASSERT_EQ(task_status::FAILED, results->status);
+	EXPECT_EQ(isolate_status::TO, results->sandbox_status->status);
+	EXPECT_TRUE(results->sandbox_status->killed);
+	EXPECT_LT(results->sandbox_status->wall_time, 1.0f);
+}
+
+TEST_F(judge_task_test, memory_limit)
+{
+	std::ostringstream content;
+	for (std::size_t i = 0; i < 200000; ++i) { content << i << " foo bar\n"; }
+	create_file(root / "large", content.str());
+	task_meta->cmd_args = {(root / "large").string(), (root / "large").string()};
+
+	sandbox_limits limits;
+	limits.memory_usage = 1024;
+	task = std::make_shared<judge_task>(1, task_meta, make_config(limits, 1000));
+
+	auto results = task->run();
+	ASSERT_EQ(task_status::FAILED, results->status);
+	EXPECT_NE(isolate_status::OK, results->sandbox_status->status);
+
+	// the limits do not apply to the worker process
+	task = std::make_shared<judge_task>(1, task_meta);
+	results = task->run();
+	EXPECT_EQ(task_status::OK, results->status) << "Failed with: " + results->error_message;
+}
+
+TEST_F(judge_task_test, output_length)
+{
+	task_meta->cmd_args = {(root / "correct").string(), (root / "shuffled").string()};
+
+	// stderr contains the log of the judge, which is cut in the middle
+	task = std::make_shared<judge_task>(1, task_meta, make_config(sandbox_limits(), 20));
+	auto results = task->run();
+	EXPECT_EQ("0\n", results->output_stdout);
+	EXPECT_EQ(20u, results->output_stderr.size());
+	EXPECT_NE(std::string::npos, results->output_stderr.find("\n...\n"));
+
+	// no output is reported unless it is requested
+	task_meta->sandbox->output = false;
+	task = std::make_shared<judge_task>(1, task_meta, make_config(sandbox_limits(), 20));
+	results = task->run();
+	EXPECT_EQ(1, results->sandbox_status->exitcode);
+	EXPECT_TRUE(results->output_stdout.empty());
+	EXPECT_TRUE(results->output_stderr.empty());
+
+	task_meta->sandbox = nullptr;
+	task = std::make_shared<judge_task>(1, task_meta);
+	EXPECT_FALSE(task->is_sandboxed());
+	EXPECT_TRUE(task->run()->output_stdout.empty());
+}
+
+TEST_F(judge_task_test, cancellation)
+{
+	std::ostringstream correct;
+	std::ostringstream tested;
+	for (std::size_t i = 0; i < 20000; ++i) {
+		correct << i % 10 << " ";
+		tested << (i * 7) % 10 << " ";
+	}
+	create_file(root / "correct", correct.str());
+	create_file(root / "tested", tested.str());
+	task_meta->cmd_args = {
+		"--token-lcs-approx-max-window", "0", (root / "correct").string(), (root / "tested").string()};
+
+	auto cancellation = std::make_shared<helpers::cancellation_token>();
+	cancellation->start("job");
+	task = std::make_shared<judge_task>(1, task_meta, nullptr, cancellation);
+
+	std::thread cancel([cancellation]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		cancellation->cancel("job");
+	});
+	auto start = std::chrono::steady_clock::now();
+	EXPECT_THROW(task->run(), task_exception);
+	cancel.join();
+	EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <sstream>
+
+#include "load_generator/latency_histogram.h"
+
+using namespace testing;
+using namespace std::chrono;
+
+
+TEST(latency_histogram, Empty)
+{
+	latency_histogram histogram;
+	EXPECT_EQ(0u, histogram.count());
+	EXPECT_EQ(0, histogram.mean());
+	EXPECT_EQ(0, histogram.percentile(50));
+
+	std::ostringstream out;
+	histogram.print_buckets(out);
+	EXPECT_EQ("", out.str());
+}
+
+TEST(latency_histogram, Percentiles)
+{
+	latency_histogram histogram;
+	// added in reverse order, 1 ms to 100 ms
+	for (int i = 100; i >= 1; --i) { histogram.add(milliseconds(i)); }
+
+	EXPECT_EQ(100u, histogram.count());
+	EXPECT_DOUBLE_EQ(50.5, histogram.mean());
+	EXPECT_DOUBLE_EQ(1, histogram.percentile(0));
+	EXPECT_DOUBLE_EQ(50, histogram.percentile(50));
+	EXPECT_DOUBLE_EQ(99, histogram.percentile(99));
+	EXPECT_DOUBLE_EQ(100, histogram.percentile(100));
+
+	histogram.add(microseconds(-5));
+	EXPECT_DOUBLE_EQ(0, histogram.percentile(0));
+}
+
+TEST(latency_histogram, Buckets)
+{
+	latency_histogram histogram;
+	histogram.add(microseconds(2500));
+	histogram.add(microseconds(3999));
+	histogram.add(microseconds(9000));
+
+	std::ostringstream out;
+	histogram.print_buckets(out);
+	std::vector<std::string> lines;
+	std::istringstream in(out.str());
+	for (std::string line; std::getline(in, line);) { lines.push_back(line); }
+
+	ASSERT_EQ(3u, lines.size());
+	EXPECT_THAT(lines[0], StartsWith("[2, 4) ms"));
+	EXPECT_THAT(lines[0], EndsWith(" 2 " + std::string(40, '#')));
+	EXPECT_THAT(lines[1], StartsWith("[4, 8) ms"));
+	EXPECT_THAT(lines[1], EndsWith(" 0 "));
+	EXPECT_THAT(lines[2], StartsWith("[8, 16) ms"));
+	EXPECT_THAT(lines[2], EndsWith(" 1 " + std::string(20, '#')));
+}
@@ -0,0 +1,67 @@
+#include "latency_histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <numeric>
+#include <string>
+
+
+void latency_histogram::add(std::chrono::microseconds value)
+{
+	values_.push_back(std::max(value.count(), (std::chrono::microseconds::rep) 0));
+	sorted_ = values_.size() < 2 || (sorted_ && values_[values_.size() - 2] <= values_.back());
+}
+
+std::size_t latency_histogram::count() const
+{
+	return values_.size();
+}
+
+double latency_histogram::mean() const
+{
+	if (values_.empty()) { return 0; }
+	double sum = std::accumulate(values_.begin(), values_.end(), 0.0);
+	return sum / values_.size() / 1000;
+}
+
+double latency_histogram::percentile(double percent) const
+{
+	if (values_.empty()) { return 0; }
+	if (!sorted_) {
+		std::sort(values_.begin(), values_.end());
+		sorted_ = true;
+	}
+
+	percent = std::min(std::max(percent, 0.0), 100.0);
+	auto rank = (std::size_t) std::ceil(percent / 100 * values_.size());
+	return values_[rank == 0 ? 0 : rank - 1] / 1000.0;
+}
+
+void latency_histogram::print_buckets(std::ostream &out, const std::string &indent) const
+{
+	if (values_.empty()) { return; }
+
+	// bucket 0 is [0, 1) ms, bucket i is [2^(i-1), 2^i) ms
+	std::vector<std::size_t> buckets;
+	for (auto value : values_) {
+		std::size_t bucket = 0;
+		for (auto ms = value / 1000; ms > 0; ms /= 2) { ++bucket; }
+		if (bucket >= buckets.size()) { buckets.resize(bucket + 1, 0); }
+		++buckets[bucket];
+	}
+
+	std::size_t first = 0;
+	while (buckets[first] == 0) { ++first; }
+	std::size_t most = *std::max_element(buckets.begin(), buckets.end());
+
+	for (std::size_t i = first; i < buckets.size(); ++i) {
+		std::size_t low = i == 0 ? 0 : (std::size_t) 1 << (i - 1);
+		std::size_t high = (std::size_t) 1 << i;
+		std::string range = "[" + std::to_string(low) + ", " + std::to_string(high) + ") ms";
+		// bars are at most 40 characters wide, non-empty buckets get at least one character
+		std::size_t width = (buckets[i] * 40 + most - 1) / most;
+
+		out << indent << std::setw(20) << std::left << range << std::right << std::setw(8) << buckets[i] << " "
+			<< std::string(width, '#') << std::endl;
+	}
+}
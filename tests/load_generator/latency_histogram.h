@@ -0,0 +1,55 @@
+#ifndef RECODEX_WORKER_LOAD_GENERATOR_LATENCY_HISTOGRAM_H
+#define RECODEX_WORKER_LOAD_GENERATOR_LATENCY_HISTOGRAM_H
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+/**
+ * Latencies of one phase of job evaluation measured by the load generator.
+ * All values are kept (there are at most thousands of jobs in one run), so the percentiles are exact.
+ */
+class latency_histogram
+{
+public:
+	/**
+	 * Add one measured latency.
+	 * @param value the latency, negative values are counted as zero
+	 */
+	void add(std::chrono::microseconds value);
+
+	/**
+	 * Number of added values.
+	 */
+	std::size_t count() const;
+
+	/**
+	 * Arithmetic mean of the values in milliseconds, zero if there are none.
+	 */
+	double mean() const;
+
+	/**
+	 * Percentile of the values (nearest rank) in milliseconds, zero if there are none.
+	 * @param percent requested percentile in range [0, 100], 100 is the maximum
+	 */
+	double percentile(double percent) const;
+
+	/**
+	 * Print counts of values in buckets which are powers of two milliseconds (the first bucket is below 1 ms).
+	 * Empty buckets at both ends are omitted.
+	 * @param out target stream
+	 * @param indent prefix of every printed line
+	 */
+	void print_buckets(std::ostream &out, const std::string &indent = "") const;
+
+private:
+	/** Measured values in microseconds, sorted lazily */
+	mutable std::vector<std::chrono::microseconds::rep> values_;
+	/** Whether @a values_ are sorted */
+	mutable bool sorted_ = true;
+};
+
+#endif // RECODEX_WORKER_LOAD_GENERATOR_LATENCY_HISTOGRAM_H
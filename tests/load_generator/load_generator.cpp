@@ -0,0 +1,311 @@
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include <boost/program_options.hpp>
+#include <yaml-cpp/yaml.h>
+
+#include "worker_core.h"
+#include "archives/archivator.h"
+#include "helpers/config.h"
+#include "latency_histogram.h"
+#include "mock_broker.h"
+
+namespace fs = std::filesystem;
+
+/**
+ * Load generator for measuring throughput and latency of the worker outside of production.
+ *
+ * The real worker (@ref worker_core) runs in this process against a mock broker, which replays a mix of job
+ * archives at a given rate. Archives and results are exchanged through "file://" URLs, so no file server is needed
+ * (the worker gets a copy of its configuration with a file server for the data directory of the generator).
+ * Isolate can be replaced by the stub script next to this file, then programs of the jobs run without any isolation.
+ */
+namespace
+{
+	/** Submission archive replayed by the generator */
+	struct job_archive {
+		/** URL of the archive given to the worker */
+		std::string url;
+		/** Identifier of the job from its configuration */
+		std::string job_id;
+		/** Relative frequency of the archive in the mix */
+		double weight = 1;
+	};
+
+	/** Measured part of the evaluation, between two marks (progress states or the marks added by the generator) */
+	struct phase {
+		std::string name;
+		std::string from;
+		std::string to;
+	};
+
+	/** Phases in the order of evaluation, the last one covers the whole job */
+	const std::vector<phase> phases = {
+		{"queue", "ARRIVED", "SENT"},
+		{"download", "SENT", "DOWNLOADED"},
+		{"build", "DOWNLOADED", "STARTED"},
+		{"run", "STARTED", "ENDED"},
+		{"upload", "ENDED", "UPLOADED"},
+		{"finish", "UPLOADED", "DONE"},
+		{"total", "ARRIVED", "DONE"},
+	};
+
+	/**
+	 * Copy an archive to the data directory and find out the identifier of its job.
+	 * @param spec path to the archive, optionally followed by a colon and its weight in the mix
+	 * @param data_dir data directory of the generator
+	 * @param index index of the archive (makes the copies unique)
+	 */
+	job_archive prepare_archive(const std::string &spec, const fs::path &data_dir, std::size_t index)
+	{
+		job_archive result;
+		fs::path path = spec;
+		auto colon = spec.rfind(':');
+		if (colon != std::string::npos) {
+			try {
+				std::size_t parsed;
+				result.weight = std::stod(spec.substr(colon + 1), &parsed);
+				if (parsed == spec.size() - colon - 1) { path = spec.substr(0, colon); }
+			} catch (std::exception &) {
+				// the colon is a part of the path
+				result.weight = 1;
+			}
+		}
+		if (result.weight <= 0) { throw std::runtime_error("Weight of archive " + spec + " must be positive"); }
+
+		fs::path copy = fs::absolute(data_dir / "jobs" / (std::to_string(index) + "-" + path.filename().string()))
+							.lexically_normal();
+		fs::create_directories(copy.parent_path());
+		fs::copy_file(path, copy, fs::copy_options::overwrite_existing);
+		result.url = "file://" + copy.string();
+
+		fs::path inspect_dir = data_dir / "inspect";
+		fs::remove_all(inspect_dir);
+		archivator::decompress(copy.string(), inspect_dir.string());
+		auto job_meta = helpers::build_job_metadata(YAML::LoadFile((inspect_dir / "job-config.yml").string()));
+		result.job_id = job_meta->job_id;
+		fs::remove_all(inspect_dir);
+
+		return result;
+	}
+
+	/**
+	 * Write a copy of the worker configuration, which serves "file://" URLs from the data directory.
+	 * @param config_file original configuration of the worker
+	 * @param data_dir data directory of the generator
+	 * @return path to the copy
+	 */
+	std::string prepare_config(const std::string &config_file, const fs::path &data_dir)
+	{
+		auto config = YAML::LoadFile(config_file);
+		auto dir = fs::absolute(data_dir).lexically_normal().string();
+
+		YAML::Node fileman;
+		fileman["hostname"] = "file://" + dir;
+		fileman["local-dir"] = dir;
+		config["file-managers"].push_back(fileman);
+
+		fs::create_directories(data_dir);
+		auto path = (data_dir / "worker-config.yml").string();
+		std::ofstream out(path);
+		out << config << std::endl;
+		if (!out) { throw std::runtime_error("Cannot write worker configuration " + path); }
+		return path;
+	}
+
+	/**
+	 * Choose archives of the jobs according to their weights and plan their arrivals.
+	 * @param rate jobs per second, arrivals form a Poisson process; zero for closed loop (offsets are not set)
+	 */
+	std::vector<scheduled_job> make_schedule(const std::vector<job_archive> &archives,
+		std::size_t count,
+		double rate,
+		unsigned seed,
+		const fs::path &data_dir)
+	{
+		std::mt19937 generator(seed);
+		std::vector<double> weights;
+		for (auto &archive : archives) { weights.push_back(archive.weight); }
+		std::discrete_distribution<std::size_t> choice(weights.begin(), weights.end());
+		std::exponential_distribution<double> interval(rate > 0 ? rate : 1);
+
+		fs::path results_dir = fs::absolute(data_dir / "results").lexically_normal();
+		fs::create_directories(results_dir);
+
+		std::vector<scheduled_job> jobs(count);
+		double offset = 0;
+		for (std::size_t i = 0; i < count; ++i) {
+			auto &archive = archives[choice(generator)];
+			jobs[i].job_id = archive.job_id;
+			jobs[i].job_url = archive.url;
+			jobs[i].result_url = "file://" + (results_dir / (std::to_string(i) + ".zip")).string();
+			if (rate > 0) {
+				jobs[i].arrival_offset = std::chrono::microseconds((long long) (offset * 1000000));
+				offset += interval(generator);
+			}
+		}
+
+		return jobs;
+	}
+
+	/**
+	 * Print throughput, results and latencies of the phases of measured jobs.
+	 */
+	void report(std::vector<scheduled_job> &jobs, std::size_t warmup, bool histograms)
+	{
+		std::map<std::string, std::size_t> results;
+		std::vector<latency_histogram> latencies(phases.size());
+		auto first = scheduled_job::clock::time_point::max();
+		auto last = scheduled_job::clock::time_point::min();
+
+		for (std::size_t i = warmup; i < jobs.size(); ++i) {
+			auto &job = jobs[i];
+			++results[job.result];
+			first = std::min(first, job.arrived);
+			last = std::max(last, job.done);
+
+			job.states["ARRIVED"] = job.arrived;
+			job.states["SENT"] = job.sent;
+			job.states["DONE"] = job.done;
+			for (std::size_t p = 0; p < phases.size(); ++p) {
+				auto from = job.states.find(phases[p].from);
+				auto to = job.states.find(phases[p].to);
+				if (from == job.states.end() || to == job.states.end()) { continue; }
+				latencies[p].add(std::chrono::duration_cast<std::chrono::microseconds>(to->second - from->second));
+			}
+		}
+
+		std::size_t measured = jobs.size() - warmup;
+		double seconds = std::chrono::duration<double>(last - first).count();
+		std::cout << "Jobs: " << measured << " measured (" << warmup << " warm-up) in " << std::fixed
+				  << std::setprecision(2) << seconds << " s, " << (seconds > 0 ? measured / seconds : 0) << " jobs/s"
+				  << std::endl;
+		for (auto &result : results) { std::cout << "  " << result.first << ": " << result.second << std::endl; }
+
+		std::cout << std::endl
+				  << std::left << std::setw(10) << "phase" << std::right << std::setw(8) << "count" << std::setw(10)
+				  << "mean" << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99"
+				  << std::setw(10) << "max" << "  [ms]" << std::endl;
+		for (std::size_t p = 0; p < phases.size(); ++p) {
+			auto &latency = latencies[p];
+			std::cout << std::left << std::setw(10) << phases[p].name << std::right << std::setw(8) << latency.count()
+					  << std::setw(10) << latency.mean() << std::setw(10) << latency.percentile(50) << std::setw(10)
+					  << latency.percentile(90) << std::setw(10) << latency.percentile(99) << std::setw(10)
+					  << latency.percentile(100) << std::endl;
+		}
+
+		if (!histograms) { return; }
+		for (std::size_t p = 0; p < phases.size(); ++p) {
+			if (latencies[p].count() == 0) { continue; }
+			std::cout << std::endl << phases[p].name << ":" << std::endl;
+			latencies[p].print_buckets(std::cout, "  ");
+		}
+	}
+} // namespace
+
+
+/**
+ * The entry point of the load generator
+ * @param argc number of CLI arguments
+ * @param argv an array of CLI arguments
+ * @return exit code
+ */
+int main(int argc, char **argv)
+{
+	using namespace boost::program_options;
+
+	options_description desc("Allowed options for the load generator");
+	desc.add_options()("help,h", "Writes this help message to stderr")(
+		"config,c", value<std::string>()->required(), "Configuration of the worker")("job,j",
+		value<std::vector<std::string>>()->multitoken()->required(),
+		"Submission archives replayed in the mix, each may be followed by a colon and its weight (e.g., a.zip:3)")(
+		"count,n", value<std::size_t>()->default_value(100), "Number of measured jobs")(
+		"warmup,w", value<std::size_t>()->default_value(5), "Number of jobs evaluated before the measurement")(
+		"rate,r", value<double>()->default_value(0), "Arriving jobs per second, 0 = next job when the previous is done")(
+		"seed,s", value<unsigned>()->default_value(1), "Seed of the job mix and arrivals")(
+		"data-dir,d", value<std::string>()->default_value((fs::temp_directory_path() / "recodex-load").string()),
+		"Directory for archives and uploaded results")(
+		"sandbox-stub", value<std::string>(), "Directory with the isolate stub, which is used instead of isolate")(
+		"job-timeout", value<std::size_t>()->default_value(600), "Longest evaluation of one job in seconds")(
+		"histograms", "Print histograms of latencies of all phases");
+
+	variables_map vm;
+	try {
+		store(command_line_parser(argc, argv).options(desc).run(), vm);
+		if (vm.count("help")) {
+			std::cerr << desc << std::endl;
+			return 1;
+		}
+		notify(vm);
+	} catch (std::exception &e) {
+		std::cerr << "Error in loading a parameter: " << e.what() << std::endl;
+		return 1;
+	}
+
+	auto config_file = vm["config"].as<std::string>();
+	fs::path data_dir = vm["data-dir"].as<std::string>();
+	auto count = vm["count"].as<std::size_t>();
+	auto warmup = vm["warmup"].as<std::size_t>();
+	auto rate = vm["rate"].as<double>();
+
+	std::vector<scheduled_job> jobs;
+	std::string broker_uri;
+	try {
+		broker_uri = worker_config(YAML::LoadFile(config_file)).get_broker_uri();
+		config_file = prepare_config(config_file, data_dir);
+
+		std::vector<job_archive> archives;
+		for (auto &spec : vm["job"].as<std::vector<std::string>>()) {
+			archives.push_back(prepare_archive(spec, data_dir, archives.size()));
+			std::cout << "Job " << archives.back().job_id << " from " << spec << std::endl;
+		}
+		jobs = make_schedule(archives, warmup + count, rate, vm["seed"].as<unsigned>(), data_dir);
+	} catch (std::exception &e) {
+		std::cerr << "Jobs cannot be prepared: " << e.what() << std::endl;
+		return 1;
+	}
+
+	if (vm.count("sandbox-stub")) {
+		// isolate is executed through PATH
+		auto stub_dir = fs::absolute(vm["sandbox-stub"].as<std::string>()).string();
+		const char *path = std::getenv("PATH");
+		setenv("PATH", (stub_dir + (path != nullptr ? ":" + std::string(path) : "")).c_str(), 1);
+	}
+
+	auto context = std::make_shared<zmq::context_t>(1);
+	mock_broker broker(context, broker_uri);
+
+	// the worker never stops receiving, so it is left running until the process exits
+	auto core = new worker_core({argv[0], "-c", config_file});
+	std::thread([core]() { core->run(); }).detach();
+
+	if (!broker.wait_for_worker(std::chrono::seconds(30))) {
+		std::cerr << "Worker did not connect to " << broker_uri << std::endl;
+		std::quick_exit(1);
+	}
+
+	std::cout << "Evaluating " << jobs.size() << " jobs"
+			  << (rate > 0 ? " arriving at " + std::to_string(rate) + " jobs/s" : " in closed loop") << "..."
+			  << std::endl;
+	try {
+		broker.run(jobs, rate <= 0, std::chrono::seconds(vm["job-timeout"].as<std::size_t>()));
+	} catch (std::exception &e) {
+		std::cerr << e.what() << std::endl;
+		std::quick_exit(1);
+	}
+
+	report(jobs, warmup, vm.count("histograms") > 0);
+	fs::remove_all(data_dir / "results");
+
+	std::cout.flush();
+	std::quick_exit(0);
+}
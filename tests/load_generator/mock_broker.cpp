@@ -0,0 +1,103 @@
+#include "mock_broker.h"
+#include "helpers/zmq_socket.h"
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+
+
+mock_broker::mock_broker(std::shared_ptr<zmq::context_t> context, const std::string &address)
+	: socket_(*context, ZMQ_ROUTER)
+{
+	socket_.setsockopt(ZMQ_LINGER, 0);
+	socket_.bind(address);
+}
+
+bool mock_broker::wait_for_worker(std::chrono::milliseconds timeout)
+{
+	auto deadline = scheduled_job::clock::now() + timeout;
+	while (worker_identity_.empty()) {
+		auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - scheduled_job::clock::now());
+		if (left <= std::chrono::milliseconds::zero()) { return false; }
+		receive(left, nullptr);
+	}
+
+	return true;
+}
+
+void mock_broker::run(std::vector<scheduled_job> &jobs, bool closed_loop, std::chrono::milliseconds job_timeout)
+{
+	auto start = scheduled_job::clock::now();
+	std::deque<scheduled_job *> queue;
+	std::size_t next_arrival = 0;
+	scheduled_job *current = nullptr;
+
+	while (next_arrival < jobs.size() || !queue.empty() || current != nullptr) {
+		auto now = scheduled_job::clock::now();
+
+		// enqueue jobs which have already arrived
+		while (next_arrival < jobs.size()) {
+			auto &job = jobs[next_arrival];
+			if (closed_loop) {
+				if (current != nullptr || !queue.empty()) { break; }
+				job.arrived = now;
+			} else {
+				job.arrived = start + job.arrival_offset;
+				if (job.arrived > now) { break; }
+			}
+			queue.push_back(&job);
+			++next_arrival;
+		}
+
+		if (current == nullptr && !queue.empty()) {
+			current = queue.front();
+			queue.pop_front();
+			current->sent = scheduled_job::clock::now();
+			helpers::send_through_socket(
+				socket_, {worker_identity_, "eval", current->job_id, current->job_url, current->result_url});
+		}
+
+		if (current != nullptr && scheduled_job::clock::now() - current->sent > job_timeout) {
+			throw std::runtime_error("Job " + current->job_id + " was not evaluated in time");
+		}
+
+		// wake up for the next arrival, but check the timeout of the current job regularly
+		auto timeout = std::chrono::milliseconds(100);
+		if (!closed_loop && next_arrival < jobs.size()) {
+			auto until_arrival = std::chrono::duration_cast<std::chrono::milliseconds>(
+				start + jobs[next_arrival].arrival_offset - scheduled_job::clock::now());
+			timeout = std::max(std::min(timeout, until_arrival), std::chrono::milliseconds::zero());
+		}
+
+		if (receive(timeout, current)) { current = nullptr; }
+	}
+}
+
+bool mock_broker::receive(std::chrono::milliseconds timeout, scheduled_job *current)
+{
+	zmq::pollitem_t item = {(void *) socket_, 0, ZMQ_POLLIN, 0};
+	zmq::poll(&item, 1, (long) timeout.count());
+	if ((item.revents & ZMQ_POLLIN) == 0) { return false; }
+
+	std::vector<std::string> msg;
+	if (!helpers::recv_from_socket(socket_, msg) || msg.size() < 2) { return false; }
+	auto now = scheduled_job::clock::now();
+	const std::string &command = msg[1];
+
+	if (command == "init") {
+		worker_identity_ = msg[0];
+	} else if (command == "ping") {
+		helpers::send_through_socket(socket_, {msg[0], "pong"});
+	} else if (current != nullptr && msg.size() >= 4 && msg[2] == current->job_id) {
+		if (command == "progress") {
+			// the first report of each state counts, states of single tasks are not measured
+			if (msg[3] != "TASK") { current->states.emplace(msg[3], now); }
+		} else if (command == "done") {
+			current->done = now;
+			current->result = msg[3];
+			current->message = msg.size() >= 5 ? msg[4] : "";
+			return true;
+		}
+	}
+
+	return false;
+}
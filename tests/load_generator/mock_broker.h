@@ -0,0 +1,87 @@
+#ifndef RECODEX_WORKER_LOAD_GENERATOR_MOCK_BROKER_H
+#define RECODEX_WORKER_LOAD_GENERATOR_MOCK_BROKER_H
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <zmq.hpp>
+
+
+/**
+ * One job submitted to the worker by the mock broker.
+ */
+struct scheduled_job {
+	using clock = std::chrono::steady_clock;
+
+	/** Identifier of the job, it must match the one in the job configuration */
+	std::string job_id;
+	/** URL of the submission archive */
+	std::string job_url;
+	/** URL where the worker uploads the results */
+	std::string result_url;
+	/** When the job arrives to the broker, relative to the start of the run (ignored in closed loop) */
+	std::chrono::microseconds arrival_offset = std::chrono::microseconds::zero();
+
+	/** When the job arrived to the broker */
+	clock::time_point arrived;
+	/** When the job was sent to the worker */
+	clock::time_point sent;
+	/** When the worker sent the done message */
+	clock::time_point done;
+	/** Progress states (DOWNLOADED, STARTED, ...) reported by the worker and when they arrived */
+	std::map<std::string, clock::time_point> states;
+	/** Result from the done message (OK, FAILED, ...) */
+	std::string result;
+	/** Message from the done message */
+	std::string message;
+};
+
+
+/**
+ * Broker which serves one worker with a prepared list of jobs, using the same protocol as the real broker
+ * (init, eval, progress, done, ping). Jobs arriving while the worker is busy wait in a queue, like in the real broker.
+ */
+class mock_broker
+{
+public:
+	/**
+	 * Constructor, binds the broker socket.
+	 * @param context ZeroMQ context
+	 * @param address address where the worker connects (broker-uri of its configuration)
+	 */
+	mock_broker(std::shared_ptr<zmq::context_t> context, const std::string &address);
+
+	/**
+	 * Wait for the init message of the worker.
+	 * @param timeout how long to wait
+	 * @return false if the worker did not connect in time
+	 */
+	bool wait_for_worker(std::chrono::milliseconds timeout);
+
+	/**
+	 * Submit the jobs to the worker and wait until all of them are evaluated. Timestamps of the jobs are filled.
+	 * @param jobs jobs in the order of their arrival
+	 * @param closed_loop if true, arrival offsets are ignored and each job arrives when the previous one is done
+	 * @param job_timeout longest time the evaluation of one job may take
+	 * @throws std::runtime_error if a job is not evaluated in time
+	 */
+	void run(std::vector<scheduled_job> &jobs, bool closed_loop, std::chrono::milliseconds job_timeout);
+
+private:
+	/**
+	 * Receive one message from the worker if it arrives in time and process it.
+	 * @param timeout how long to wait
+	 * @param current job being evaluated by the worker, @a nullptr if there is none
+	 * @return true if the message was the done message of the current job
+	 */
+	bool receive(std::chrono::milliseconds timeout, scheduled_job *current);
+
+	/** ROUTER socket the worker connects to */
+	zmq::socket_t socket_;
+	/** ZeroMQ identity of the connected worker */
+	std::string worker_identity_;
+};
+
+#endif // RECODEX_WORKER_LOAD_GENERATOR_MOCK_BROKER_H
@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "mocks.h"
+#include "fileman/local_file_manager.h"
+
+using namespace testing;
+using namespace std;
+
+
+/**
+ * Directory of the file server and a working directory, both are removed after each test.
+ */
+class local_file_manager_test : public Test
+{
+protected:
+	fs::path dir_ = fs::temp_directory_path() / "recodex_local_file_manager_test";
+	fs::path server_dir_ = dir_ / "server";
+	fs::path work_dir_ = dir_ / "work";
+	vector<fileman_config> configs_;
+
+	void SetUp() override
+	{
+		fs::remove_all(dir_);
+		fs::create_directories(server_dir_ / "exercises");
+		fs::create_directories(work_dir_);
+		write_file(server_dir_ / "exercises" / "input.txt", "input data");
+
+		fileman_config http_config;
+		http_config.remote_url = "http://remote:9999";
+		fileman_config local_config;
+		local_config.remote_url = "http://localhost:9999";
+		local_config.local_dir = server_dir_.string();
+		configs_ = {http_config, local_config};
+	}
+
+	void TearDown() override
+	{
+		fs::remove_all(dir_);
+	}
+
+	static void write_file(const fs::path &path, const string &content)
+	{
+		ofstream file(path.string());
+		file << content;
+	}
+
+	/** Configuration which serves "file://" URLs of the server directory. */
+	vector<fileman_config> file_configs() const
+	{
+		fileman_config config;
+		config.remote_url = "file://" + server_dir_.string();
+		config.local_dir = server_dir_.string();
+		return {config};
+	}
+
+	static string read_file(const fs::path &path)
+	{
+		ifstream file(path.string());
+		return string(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+	}
+};
+
+
+TEST_F(local_file_manager_test, GetFile)
+{
+	local_file_manager m(configs_);
+	m.get_file("http://localhost:9999/exercises/input.txt", (work_dir_ / "input.txt").string());
+
+	EXPECT_EQ("input data", read_file(work_dir_ / "input.txt"));
+	EXPECT_FALSE(fs::equivalent(work_dir_ / "input.txt", server_dir_ / "exercises" / "input.txt"));
+
+	// existing file is overwritten
+	write_file(server_dir_ / "exercises" / "input.txt", "new data");
+	m.get_file("http://localhost:9999/exercises/input.txt", (work_dir_ / "input.txt").string());
+	EXPECT_EQ("new data", read_file(work_dir_ / "input.txt"));
+}
+
+TEST_F(local_file_manager_test, GetFileHardlink)
+{
+	configs_[1].local_hardlink = true;
+	local_file_manager m(configs_);
+	m.get_file("http://localhost:9999/exercises/input.txt", (work_dir_ / "input.txt").string());
+
+	EXPECT_EQ("input data", read_file(work_dir_ / "input.txt"));
+	EXPECT_TRUE(fs::equivalent(work_dir_ / "input.txt", server_dir_ / "exercises" / "input.txt"));
+}
+
+TEST_F(local_file_manager_test, GetFileUrl)
+{
+	local_file_manager m(file_configs());
+	m.get_file("file://" + (server_dir_ / "exercises" / "input.txt").string(), (work_dir_ / "input.txt").string());
+
+	EXPECT_EQ("input data", read_file(work_dir_ / "input.txt"));
+}
+
+TEST_F(local_file_manager_test, GetFileUrlHost)
+{
+	local_file_manager m(file_configs());
+	auto path = (server_dir_ / "exercises" / "input.txt").string();
+	m.get_file("file://localhost" + path, (work_dir_ / "a").string());
+	EXPECT_EQ("input data", read_file(work_dir_ / "a"));
+
+	EXPECT_THROW(m.get_file("file://remote" + path, (work_dir_ / "b").string()), fm_exception);
+	EXPECT_FALSE(fs::exists(work_dir_ / "b"));
+}
+
+TEST_F(local_file_manager_test, GetFileUrlNotConfigured)
+{
+	write_file(dir_ / "secret.txt", "secret");
+
+	// no file server serves local files
+	local_file_manager m(configs_);
+	EXPECT_THROW(m.get_file("file://" + (server_dir_ / "exercises" / "input.txt").string(), (work_dir_ / "a").string()),
+		fm_exception);
+
+	// only files inside the directory of the file server are served
+	local_file_manager n(file_configs());
+	EXPECT_THROW(n.get_file("file://" + (dir_ / "secret.txt").string(), (work_dir_ / "a").string()), fm_exception);
+	EXPECT_THROW(
+		n.get_file("file://" + (server_dir_ / ".." / "secret.txt").string(), (work_dir_ / "a").string()), fm_exception);
+	EXPECT_FALSE(fs::exists(work_dir_ / "a"));
+}
+
+TEST_F(local_file_manager_test, GetNonexistingFile)
+{
+	local_file_manager m(configs_);
+	EXPECT_THROW(m.get_file("http://localhost:9999/exercises/nonexisting.txt", (work_dir_ / "a").string()),
+		fm_exception);
+	EXPECT_THROW(m.get_file("http://localhost:9999/exercises", (work_dir_ / "a").string()), fm_exception);
+	EXPECT_THROW(m.get_file("http://localhost:9999/exercises/input.txt", (work_dir_ / "none" / "a").string()),
+		fm_exception);
+}
+
+TEST_F(local_file_manager_test, GetFileOutsideDirectory)
+{
+	write_file(dir_ / "secret.txt", "secret");
+
+	local_file_manager m(configs_);
+	EXPECT_THROW(m.get_file("http://localhost:9999/../secret.txt", (work_dir_ / "a").string()), fm_exception);
+	EXPECT_THROW(
+		m.get_file("http://localhost:9999/exercises/../../secret.txt", (work_dir_ / "a").string()), fm_exception);
+	EXPECT_FALSE(fs::exists(work_dir_ / "a"));
+}
+
+TEST_F(local_file_manager_test, RemoteUrls)
+{
+	auto remote = make_shared<StrictMock<mock_file_manager>>();
+	EXPECT_CALL(*remote, get_file("http://remote:9999/input.txt", "a")).Times(1);
+	EXPECT_CALL(*remote, get_file("http://localhost:99999/input.txt", "b")).Times(1);
+	EXPECT_CALL(*remote, put_file("c", "http://remote:9999/results/c")).Times(1);
+
+	local_file_manager m(configs_, remote);
+	m.get_file("http://remote:9999/input.txt", "a");
+	m.get_file("http://localhost:99999/input.txt", "b");
+	m.put_file("c", "http://remote:9999/results/c");
+
+	local_file_manager n(configs_);
+	EXPECT_THROW(n.get_file("http://remote:9999/input.txt", "a"), fm_exception);
+}
+
+TEST_F(local_file_manager_test, PutFile)
+{
+	write_file(work_dir_ / "result.zip", "results");
+
+	local_file_manager m(configs_);
+	m.put_file((work_dir_ / "result.zip").string(), "http://localhost:9999/results/job_1.zip");
+
+	EXPECT_EQ("results", read_file(server_dir_ / "results" / "job_1.zip"));
+	// no temporary file left behind
+	EXPECT_EQ(1, distance(fs::directory_iterator(server_dir_ / "results"), fs::directory_iterator()));
+
+	EXPECT_THROW(m.put_file((work_dir_ / "nonexisting.zip").string(), "http://localhost:9999/results/job_2.zip"),
+		fm_exception);
+	EXPECT_EQ(1, distance(fs::directory_iterator(server_dir_ / "results"), fs::directory_iterator()));
+}
+
+TEST_F(local_file_manager_test, PutFileUrl)
+{
+	write_file(work_dir_ / "result.zip", "results");
+
+	local_file_manager m(file_configs());
+	m.put_file((work_dir_ / "result.zip").string(), "file://" + (server_dir_ / "job_1.zip").string());
+	EXPECT_EQ("results", read_file(server_dir_ / "job_1.zip"));
+
+	// directories are not created for local paths
+	EXPECT_THROW(m.put_file((work_dir_ / "result.zip").string(),
+					 "file://" + (server_dir_ / "results" / "job_2.zip").string()),
+		fm_exception);
+	EXPECT_FALSE(fs::exists(server_dir_ / "results"));
+	EXPECT_THROW(
+		m.put_file((work_dir_ / "result.zip").string(), "file://remote" + (server_dir_ / "job_3.zip").string()),
+		fm_exception);
+	EXPECT_FALSE(fs::exists(server_dir_ / "job_3.zip"));
+}
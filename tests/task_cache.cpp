@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "tasks/task_cache.h"
+#include "tasks/task_base.h"
+
+using namespace testing;
+using namespace std;
+
+
+/**
+ * Cache directory and a directory with task outputs, both are removed after each test.
+ */
+class task_cache_test : public Test
+{
+protected:
+	fs::path dir_ = fs::temp_directory_path() / "recodex_task_cache_test";
+	fs::path cache_dir_ = dir_ / "cache";
+	fs::path work_dir_ = dir_ / "work";
+	vector<fs::path> files_ = {work_dir_ / "a.out", work_dir_ / "sub" / "stdout", work_dir_ / "stderr"};
+
+	void SetUp() override
+	{
+		fs::remove_all(dir_);
+		fs::create_directories(work_dir_);
+	}
+
+	void TearDown() override
+	{
+		fs::remove_all(dir_);
+	}
+
+	static void write_file(const fs::path &path, const string &content)
+	{
+		fs::create_directories(path.parent_path());
+		ofstream file(path.string());
+		file << content;
+	}
+
+	static string read_file(const fs::path &path)
+	{
+		ifstream file(path.string());
+		return string(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+	}
+};
+
+
+TEST_F(task_cache_test, Miss)
+{
+	task_cache cache(cache_dir_, 0);
+	EXPECT_TRUE(fs::is_directory(cache_dir_));
+
+	sandbox_results results;
+	EXPECT_FALSE(cache.restore("key", files_, results));
+	EXPECT_EQ(0u, cache.get_hits());
+	EXPECT_EQ(1u, cache.get_misses());
+}
+
+TEST_F(task_cache_test, StoreAndRestore)
+{
+	write_file(files_[0], "binary");
+	write_file(files_[1], "compiler output");
+	fs::permissions(files_[0], fs::perms::owner_exec, fs::perm_options::add);
+
+	sandbox_results results;
+	results.status = isolate_status::RE;
+	results.exitcode = 1;
+	results.time = 1.5f;
+	results.memory = 1024;
+	results.message = "Exited with error status 1";
+
+	task_cache cache(cache_dir_, 0);
+	cache.store("key", files_, results);
+
+	// outputs are restored, the file which was not produced is removed
+	fs::remove_all(work_dir_);
+	write_file(files_[2], "stale");
+	sandbox_results restored;
+	ASSERT_TRUE(cache.restore("key", files_, restored));
+	EXPECT_EQ("binary", read_file(files_[0]));
+	EXPECT_EQ("compiler output", read_file(files_[1]));
+	EXPECT_FALSE(fs::exists(files_[2]));
+	EXPECT_NE(fs::perms::none, fs::status(files_[0]).permissions() & fs::perms::owner_exec);
+
+	EXPECT_EQ(isolate_status::RE, restored.status);
+	EXPECT_EQ(1, restored.exitcode);
+	EXPECT_FLOAT_EQ(1.5f, restored.time);
+	EXPECT_EQ(1024u, restored.memory);
+	EXPECT_EQ("Exited with error status 1", restored.message);
+	EXPECT_EQ(1u, cache.get_hits());
+
+	// entry of different task does not match
+	EXPECT_FALSE(cache.restore("key", {files_[0]}, restored));
+	EXPECT_FALSE(cache.restore("other", files_, restored));
+	EXPECT_EQ(2u, cache.get_misses());
+}
+
+TEST_F(task_cache_test, SharedDirectory)
+{
+	write_file(files_[0], "binary");
+
+	task_cache first(cache_dir_, 0);
+	task_cache second(cache_dir_, 0);
+	first.store("key", files_, sandbox_results());
+	// the entry already exists, it is not overwritten
+	write_file(files_[0], "another binary");
+	second.store("key", files_, sandbox_results());
+
+	sandbox_results restored;
+	ASSERT_TRUE(second.restore("key", files_, restored));
+	EXPECT_EQ("binary", read_file(files_[0]));
+	// no temporary entries left behind
+	EXPECT_EQ(1, distance(fs::directory_iterator(cache_dir_), fs::directory_iterator()));
+}
+
+TEST_F(task_cache_test, Eviction)
+{
+	write_file(files_[0], string(1000, 'x'));
+
+	task_cache cache(cache_dir_, 2500);
+	cache.store("first", files_, sandbox_results());
+	cache.store("second", files_, sandbox_results());
+
+	// the first entry is used, so the second one is the least recently used
+	fs::last_write_time(cache_dir_ / "second", fs::file_time_type::clock::now() - chrono::hours(1));
+	sandbox_results restored;
+	ASSERT_TRUE(cache.restore("first", files_, restored));
+
+	cache.store("third", files_, sandbox_results());
+	EXPECT_TRUE(fs::exists(cache_dir_ / "first"));
+	EXPECT_FALSE(fs::exists(cache_dir_ / "second"));
+	EXPECT_TRUE(fs::exists(cache_dir_ / "third"));
+}
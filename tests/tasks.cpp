@@ -14,6 +14,7 @@
 #include "tasks/internal/rm_task.h"
 #include "tasks/internal/fetch_task.h"
 #include "tasks/internal/exists_task.h"
+#include "tasks/internal/judge_task.h"
 #include "tasks/external_task.h"
 #include "tasks/root_task.h"
 #include "tasks/task_factory.h"
@@ -168,6 +169,14 @@ TEST(Tasks, InternalExistsTask)
 	EXPECT_NO_THROW(exists_task(1, get_three_args()));
 }
 
+TEST(Tasks, InternalJudgeTask)
+{
+	EXPECT_THROW(judge_task(1, get_zero_args()), task_exception);
+	EXPECT_THROW(judge_task(1, get_one_args()), task_exception);
+	EXPECT_NO_THROW(judge_task(1, get_two_args()));
+	EXPECT_NO_THROW(judge_task(1, get_three_args()));
+}
+
 
 class test_task_base : public task_base
 {
@@ -226,6 +235,11 @@ TEST(Tasks, TaskFactory)
 	task = factory.create_internal_task(0, meta);
 	EXPECT_NE(std::dynamic_pointer_cast<fetch_task>(task), nullptr);
 
+	// judge task
+	meta->binary = "judge";
+	task = factory.create_internal_task(0, meta);
+	EXPECT_NE(std::dynamic_pointer_cast<judge_task>(task), nullptr);
+
 	// mkdir task
 	meta->binary = "mkdir";
 	task = factory.create_internal_task(0, meta);
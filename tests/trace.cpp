@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <yaml-cpp/yaml.h>
+
+#include "helpers/trace.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+
+class trace_test : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		file_ = fs::temp_directory_path() / "recodex_trace_test.json";
+		fs::remove(file_);
+	}
+
+	void TearDown() override
+	{
+		helpers::close_trace();
+		fs::remove(file_);
+	}
+
+	/**
+	 * Read the events (one per line after the opening bracket).
+	 */
+	vector<YAML::Node> read_events()
+	{
+		ifstream in(file_.string());
+		string line;
+		getline(in, line);
+		EXPECT_EQ("[", line);
+
+		vector<YAML::Node> events;
+		while (getline(in, line)) {
+			EXPECT_EQ(',', line.back());
+			line.pop_back();
+			events.push_back(YAML::Load(line));
+		}
+		return events;
+	}
+
+	fs::path file_;
+};
+
+
+TEST_F(trace_test, Disabled)
+{
+	helpers::trace_span span("job", "job1");
+	span.set("result", "OK");
+	span.end();
+
+	EXPECT_EQ(0u, helpers::trace_span::current().span_id);
+	EXPECT_FALSE(fs::exists(file_));
+}
+
+TEST_F(trace_test, NestedSpans)
+{
+	ASSERT_TRUE(helpers::open_trace(file_.string(), 7));
+	{
+		helpers::trace_span job("job", "job1");
+		{
+			helpers::trace_span task("task");
+			task.set("task_id", "compile \"main\"");
+			task.set("exitcode", 3);
+			task.set("cached", false);
+			EXPECT_EQ(task.context().span_id, helpers::trace_span::current().span_id);
+		}
+		EXPECT_EQ(job.context().span_id, helpers::trace_span::current().span_id);
+	}
+	EXPECT_EQ(0u, helpers::trace_span::current().span_id);
+	helpers::close_trace();
+
+	auto events = read_events();
+	ASSERT_EQ(2u, events.size());
+	auto &task = events[0];
+	auto &job = events[1];
+
+	EXPECT_EQ("task", task["name"].as<string>());
+	EXPECT_EQ("X", task["ph"].as<string>());
+	EXPECT_EQ(7u, task["pid"].as<size_t>());
+	EXPECT_EQ("job1", task["args"]["trace_id"].as<string>());
+	EXPECT_EQ(job["args"]["span_id"].as<uint64_t>(), task["args"]["parent_id"].as<uint64_t>());
+	EXPECT_EQ("compile \"main\"", task["args"]["task_id"].as<string>());
+	EXPECT_EQ(3, task["args"]["exitcode"].as<int>());
+	EXPECT_FALSE(task["args"]["cached"].as<bool>());
+
+	EXPECT_EQ("job", job["name"].as<string>());
+	EXPECT_EQ(0u, job["args"]["parent_id"].as<uint64_t>());
+	EXPECT_LE(job["ts"].as<long long>(), task["ts"].as<long long>());
+	EXPECT_GE(job["ts"].as<long long>() + job["dur"].as<long long>(),
+		task["ts"].as<long long>() + task["dur"].as<long long>());
+}
+
+TEST_F(trace_test, ParentFromAnotherThread)
+{
+	ASSERT_TRUE(helpers::open_trace(file_.string(), 1));
+	{
+		helpers::trace_span job("job", "job1");
+		auto parent = helpers::trace_span::current();
+		thread([parent]() {
+			helpers::trace_span other("box_prepare", parent);
+			helpers::trace_span nested("box_init");
+		}).join();
+	}
+
+	// the file is appended to when it is opened again
+	ASSERT_TRUE(helpers::open_trace(file_.string(), 1));
+	{
+		helpers::trace_span orphan("cleanup");
+	}
+	helpers::close_trace();
+
+	auto events = read_events();
+	ASSERT_EQ(4u, events.size());
+	EXPECT_EQ("box_init", events[0]["name"].as<string>());
+	EXPECT_EQ("box_prepare", events[1]["name"].as<string>());
+	EXPECT_EQ("job", events[2]["name"].as<string>());
+	EXPECT_EQ("cleanup", events[3]["name"].as<string>());
+
+	EXPECT_EQ(events[1]["args"]["span_id"].as<uint64_t>(), events[0]["args"]["parent_id"].as<uint64_t>());
+	EXPECT_EQ(events[2]["args"]["span_id"].as<uint64_t>(), events[1]["args"]["parent_id"].as<uint64_t>());
+	EXPECT_EQ("job1", events[0]["args"]["trace_id"].as<string>());
+	EXPECT_NE(events[0]["tid"].as<size_t>(), events[2]["tid"].as<size_t>());
+	EXPECT_EQ("", events[3]["args"]["trace_id"].as<string>());
+	EXPECT_EQ(0u, events[3]["args"]["parent_id"].as<uint64_t>());
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "fileman/transfer_governor.h"
+
+using namespace testing;
+using namespace std;
+
+
+TEST(transfer_governor, Unlimited)
+{
+	transfer_governor governor;
+	auto first = governor.start(transfer_priority::HIGH);
+	auto second = governor.start(transfer_priority::LOW);
+
+	first->consume(100000000);
+	second->consume(100000000);
+
+	EXPECT_EQ(chrono::milliseconds(0), first->get_throttled());
+	EXPECT_EQ(chrono::milliseconds(0), second->get_throttled());
+}
+
+TEST(transfer_governor, MaxConcurrent)
+{
+	transfer_governor governor(2);
+	auto first = governor.start(transfer_priority::HIGH);
+	auto second = governor.start(transfer_priority::HIGH);
+
+	atomic<bool> started(false);
+	thread third([&] {
+		auto transfer = governor.start(transfer_priority::HIGH);
+		started = true;
+	});
+
+	this_thread::sleep_for(chrono::milliseconds(50));
+	EXPECT_FALSE(started);
+
+	first.reset();
+	third.join();
+	EXPECT_TRUE(started);
+}
+
+TEST(transfer_governor, HighPriorityFirst)
+{
+	transfer_governor governor(1);
+	auto running = governor.start(transfer_priority::HIGH);
+
+	mutex order_mutex;
+	vector<transfer_priority> order;
+	auto run = [&](transfer_priority priority) {
+		auto transfer = governor.start(priority);
+		lock_guard<mutex> lock(order_mutex);
+		order.push_back(priority);
+	};
+
+	// low priority transfer is waiting longer, but the high priority one goes first
+	thread low(run, transfer_priority::LOW);
+	this_thread::sleep_for(chrono::milliseconds(20));
+	thread high(run, transfer_priority::HIGH);
+	this_thread::sleep_for(chrono::milliseconds(20));
+
+	running.reset();
+	low.join();
+	high.join();
+
+	EXPECT_THAT(order, ElementsAre(transfer_priority::HIGH, transfer_priority::LOW));
+}
+
+TEST(transfer_governor, MaxBandwidth)
+{
+	transfer_governor governor(0, 1000000);
+	auto transfer = governor.start(transfer_priority::HIGH);
+
+	auto begin = chrono::steady_clock::now();
+	// one second burst is available immediately, the rest is limited
+	for (int i = 0; i < 130; ++i) { transfer->consume(10000); }
+	auto elapsed = chrono::steady_clock::now() - begin;
+
+	EXPECT_GE(elapsed, chrono::milliseconds(250));
+	EXPECT_LT(elapsed, chrono::seconds(2));
+	EXPECT_GE(transfer->get_throttled(), chrono::milliseconds(250));
+}
@@ -8,6 +8,7 @@ TEST(worker_config, load_yaml_basic)
 	using sp = sandbox_limits::dir_perm;
 	auto yaml = YAML::Load("---\n"
 						   "worker-id: 8\n"
+						   "spare-box-ids: [108, 208]\n"
 						   "broker-uri: tcp://localhost:1234\n"
 						   "broker-ping-interval: 5487\n"
 						   "max-broker-liveness: 1245\n"
@@ -25,13 +26,49 @@ TEST(worker_config, load_yaml_basic)
 						   "    - hostname: http://localhost:4242\n"
 						   "      username: 123456\n"
 						   "      password: 654321\n"
+						   "      retries: 5\n"
+						   "      retry-delay: 200\n"
+						   "      low-speed-limit: 100\n"
+						   "      low-speed-time: 0\n"
+						   "      compression: false\n"
+						   "      local-dir: /mnt/files\n"
+						   "      local-hardlink: true\n"
+						   "file-transfers:\n"
+						   "    max-concurrent: 3\n"
+						   "    max-bandwidth: 10485760\n"
 						   "file-cache:\n"
 						   "    cache-dir: /tmp/isoeval/cache\n"
+						   "    warmup-threads: 4\n"
+						   "staging:\n"
+						   "    directory: /dev/shm/isoeval\n"
+						   "    job-budget: 1048576\n"
+						   "compilation-cache:\n"
+						   "    directory: /var/cache/isoeval-compilations\n"
+						   "    max-size: 4194304\n"
+						   "    toolchain:\n"
+						   "        - /usr/lib/gcc\n"
+						   "        - /usr/include\n"
+						   "    toolchain-version: gcc-13.2\n"
+						   "judge-cache:\n"
+						   "    directory: /var/cache/isoeval-judges\n"
+						   "    max-size: 2097152\n"
+						   "    judges:\n"
+						   "        - recodex-judge-normal\n"
+						   "resource-sampling:\n"
+						   "    interval: 50\n"
+						   "    max-samples: 200\n"
+						   "    cgroup-root: /sys/fs/cgroup/isolate\n"
+						   "cpuset:\n"
+						   "    box-cpus: 2-3,6\n"
+						   "    box-mems: 0\n"
+						   "    worker-cpus: 0\n"
 						   "logger:\n"
 						   "    file: /var/log/isoeval\n"
 						   "    level: emerg\n"
 						   "    max-size: 2048576\n"
 						   "    rotations: 5\n"
+						   "tracing:\n"
+						   "    file: /var/log/isoeval-trace.json\n"
 						   "limits:\n"
 						   "    time: 5\n"
 						   "    wall-time: 6\n"
@@ -95,17 +132,44 @@ TEST(worker_config, load_yaml_basic)
 	expected_fileman.remote_url = "http://localhost:4242";
 	expected_fileman.username = "123456";
 	expected_fileman.password = "654321";
+	expected_fileman.retries = 5;
+	expected_fileman.retry_delay = 200;
+	expected_fileman.low_speed_limit = 100;
+	expected_fileman.low_speed_time = 0;
+	expected_fileman.compression = false;
+	expected_fileman.local_dir = "/mnt/files";
+	expected_fileman.local_hardlink = true;
 	expected_filemans.push_back(expected_fileman);
 
 	ASSERT_STREQ("tcp://localhost:1234", config.get_broker_uri().c_str());
 	ASSERT_EQ((std::size_t) 8, config.get_worker_id());
+	ASSERT_EQ((std::vector<std::size_t>{108, 208}), config.get_spare_box_ids());
 	ASSERT_EQ("/tmp/working_dir", config.get_working_directory());
 	ASSERT_STREQ("/tmp/isoeval/cache", config.get_cache_dir().c_str());
+	ASSERT_EQ((std::size_t) 4, config.get_cache_warmup_threads());
+	ASSERT_EQ("/dev/shm/isoeval", config.get_staging_dir());
+	ASSERT_EQ((std::size_t) 1048576, config.get_staging_job_budget());
+	ASSERT_EQ("/var/cache/isoeval-compilations", config.get_compilation_cache_dir());
+	ASSERT_EQ((std::vector<std::string>{"/usr/lib/gcc", "/usr/include"}), config.get_compilation_cache_toolchain());
+	ASSERT_EQ("gcc-13.2", config.get_compilation_cache_toolchain_version());
+	ASSERT_EQ((std::size_t) 4194304, config.get_compilation_cache_max_size());
+	ASSERT_EQ("/var/cache/isoeval-judges", config.get_judge_cache_dir());
+	ASSERT_EQ((std::size_t) 2097152, config.get_judge_cache_max_size());
+	ASSERT_EQ(std::vector<std::string>{"recodex-judge-normal"}, config.get_judge_cache_binaries());
+	ASSERT_EQ(std::chrono::milliseconds(50), config.get_sampling_interval());
+	ASSERT_EQ((std::size_t) 200, config.get_sampling_max_samples());
+	ASSERT_EQ("/sys/fs/cgroup/isolate", config.get_sampling_cgroup_root());
+	ASSERT_EQ((std::vector<std::size_t>{2, 3, 6}), config.get_box_cpus());
+	ASSERT_EQ(std::vector<std::size_t>{0}, config.get_box_mems());
+	ASSERT_EQ(std::vector<std::size_t>{0}, config.get_worker_cpus());
 	ASSERT_EQ(expected_headers, config.get_headers());
 	ASSERT_EQ("group_1", config.get_hwgroup());
 	ASSERT_EQ(expected_limits, config.get_limits());
 	ASSERT_EQ(expected_log, config.get_log_config());
+	ASSERT_EQ("/var/log/isoeval-trace.json", config.get_trace_file());
 	ASSERT_EQ(expected_filemans, config.get_filemans_configs());
+	ASSERT_EQ((std::size_t) 3, config.get_max_transfers());
+	ASSERT_EQ((std::size_t) 10485760, config.get_max_transfer_bandwidth());
 	ASSERT_EQ(std::chrono::milliseconds(5487), config.get_broker_ping_interval());
 	ASSERT_EQ((std::size_t) 1245, config.get_max_broker_liveness());
 	ASSERT_EQ((std::size_t) 1024, config.get_max_output_length());